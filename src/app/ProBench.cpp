@@ -0,0 +1,1861 @@
+#include <iostream>
+#include <string>
+#include <map>
+#include <random>
+#include "pro/Prometheus.hpp"
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////
+// STRUCTS
+///////////////////////////////////////////////////////////////////////////////
+
+struct ProVertex {
+    glm::vec3 pos;
+    glm::vec4 color;
+};
+
+// Window is nullptr if running headless; returns exit code
+using BenchFunc = std::function<int(GLFWwindow*, int, char**)>;
+
+///////////////////////////////////////////////////////////////////////////////
+// GLOBALS
+///////////////////////////////////////////////////////////////////////////////
+
+string appName = "ProBench";
+
+///////////////////////////////////////////////////////////////////////////////
+// HELPER FUNCTIONS
+///////////////////////////////////////////////////////////////////////////////
+
+pro::VulkanInitCreateInfo makeBenchInitCreateInfo(GLFWwindow *window) {
+    pro::VulkanInitCreateInfo createInfo {};
+    createInfo.appName = appName;
+    createInfo.requireComputeQueue = false;
+    createInfo.requireTransferQueue = false;
+
+    // No window --> headless
+    if(!window) {
+        createInfo.headless = true;
+        return createInfo;
+    }
+
+    createInfo.createSurfaceFunc = [window](VkInstance instance, VkSurfaceKHR& surface) {            
+        return glfwCreateWindowSurface(instance, window, nullptr, &surface);
+    };
+
+    createInfo.getCurrentWindowSizeFunc = [window](int &width, int &height) {
+        glfwGetFramebufferSize(window, &width, &height);
+    };
+
+    return createInfo;
+}
+
+// Vertex input comes from T (any vertex with pos + color at locations 0 and 1)
+template<typename T = ProVertex>
+pro::VulkanPipelineCreateInfo makeBenchPipelineCreateInfo(pro::VulkanInitData &vkInitData) {
+    pro::VulkanPipelineCreateInfo pipelineCreateInfo(vkInitData);
+
+    pipelineCreateInfo.shaderInfo = {
+        pro::VulkanShaderCreateInfo(
+            "build/compiledshaders/" + appName + "/shader.vert.spv",
+            vk::ShaderStageFlagBits::eVertex),
+        pro::VulkanShaderCreateInfo(
+            "build/compiledshaders/" + appName + "/shader.frag.spv",
+            vk::ShaderStageFlagBits::eFragment)
+    };
+
+    pipelineCreateInfo.bindDesc = pro::getVertexBindDesc<T>();
+    pipelineCreateInfo.attribDesc = pro::getVertexAttribDesc<T>();
+
+    return pipelineCreateInfo;
+}
+
+pro::HostMesh<ProVertex> makeQuad() {
+    pro::HostMesh<ProVertex> quad {};
+    quad.vertices = {
+        {{-0.5f, -0.5f, 0.5f},  {1,0,0,1}},
+        {{0.5f, -0.5f, 0.5f},   {0,1,0,1}},
+        {{0.5f, 0.5f, 0.5f},    {0,0,1,1}},
+        {{-0.5f, 0.5f, 0.5f},   {1,1,1,1}}
+    };
+    quad.indices = { 0, 1, 2, 0, 2, 3 };
+    return quad;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// BENCHMARKS
+///////////////////////////////////////////////////////////////////////////////
+
+// Compares "launches" (VulkanInitData + pipeline creation) 
+// with no pipeline cache on disk (cold) vs. with the cache saved by the previous launch (warm).
+// NOTE: many drivers ALSO keep their own shader cache (e.g., MESA_SHADER_CACHE_DISABLE=true, 
+// __GL_SHADER_DISK_CACHE=0 to turn them off), which will shrink the difference.
+int benchPipelineCache(GLFWwindow *window, int argc, char **argv) {
+    int iterations = (argc > 2) ? stoi(argv[2]) : 5;
+    string cacheFilename = "probench_pipeline_cache.bin";
+
+    auto runLaunch = [&](bool cold, float &initSeconds, float &pipelineSeconds) {
+        pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+        createInfo.pipelineCacheFilename = cacheFilename;
+
+        // Cold launch --> remove any previously-saved cache
+        if(cold) {
+            for(auto &entry : filesystem::directory_iterator(".")) {
+                string name = entry.path().filename().string();
+                if(name.starts_with("probench_pipeline_cache.")) {
+                    filesystem::remove(entry.path());
+                }
+            }
+        }
+
+        auto startInit = pro::getTime();
+        pro::VulkanInitData vkInitData(createInfo);
+        auto startPipeline = pro::getTime();
+
+        pro::VulkanPipelineCreateInfo pipelineCreateInfo = makeBenchPipelineCreateInfo(vkInitData);
+        pro::VulkanPipelineData pipelineData = pro::createVulkanPipeline(vkInitData, pipelineCreateInfo);
+
+        auto end = pro::getTime();
+        initSeconds = pro::getElapsedSeconds(startInit, startPipeline);
+        pipelineSeconds = pro::getElapsedSeconds(startPipeline, end);
+
+        pro::cleanupVulkanPipeline(vkInitData, pipelineData);
+        // Cache saved when vkInitData falls out of scope
+    };
+
+    float coldInit = 0, coldPipeline = 0, warmInit = 0, warmPipeline = 0;
+    for(int i = 0; i < iterations; i++) {
+        float initSeconds, pipelineSeconds;
+
+        runLaunch(true, initSeconds, pipelineSeconds);
+        coldInit += initSeconds;
+        coldPipeline += pipelineSeconds;
+
+        runLaunch(false, initSeconds, pipelineSeconds);
+        warmInit += initSeconds;
+        warmPipeline += pipelineSeconds;
+    }
+
+    cout << "** PIPELINE CACHE (" << iterations << " iterations, average) **" << endl;
+    cout << "Cold: init " << (coldInit / iterations * 1000.0f) << " ms, pipeline " 
+            << (coldPipeline / iterations * 1000.0f) << " ms" << endl;
+    cout << "Warm: init " << (warmInit / iterations * 1000.0f) << " ms, pipeline " 
+            << (warmPipeline / iterations * 1000.0f) << " ms" << endl;
+
+    return 0;
+}
+
+// Renders the quad many times per frame with N = 1, 2, 3 frames-in-flight,
+// reporting average frame time and how long the CPU blocked on fences.
+int benchFrameRing(GLFWwindow *window, int argc, char **argv) {
+    int frameCnt = (argc > 2) ? stoi(argv[2]) : 500;
+    int drawsPerFrame = (argc > 3) ? stoi(argv[3]) : 2000;
+
+    if(!window) {
+        pro::print_error("benchFrameRing", "Needs a swapchain (cannot run headless)!");
+        return 1;
+    }
+
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    pro::VulkanInitData vkInitData(createInfo);
+
+    pro::VulkanPipelineCreateInfo pipelineCreateInfo = makeBenchPipelineCreateInfo(vkInitData);
+    pro::VulkanPipelineData pipelineData = pro::createVulkanPipeline(vkInitData, pipelineCreateInfo);
+
+    pro::HostMesh<ProVertex> quad = makeQuad();
+    pro::narrowHostMeshIndices(quad);
+    pro::VulkanMesh mesh = pro::createVulkanMesh(vkInitData, quad, false);
+    pro::copyToHostVisibleVulkanMesh(vkInitData, mesh, quad);
+
+    cout << "** FRAME RING (" << frameCnt << " frames, " << drawsPerFrame << " draws/frame) **" << endl;
+
+    for(unsigned int framesInFlight = 1; framesInFlight <= 3; framesInFlight++) {
+        pro::FrameRing frameRing(vkInitData, framesInFlight);
+        pro::OnResizeFunc resizeFunc = [&vkInitData, &frameRing]() {
+            vkInitData.recreateVulkanSwapchain();
+            frameRing.recreateDepthImages();
+        };
+
+        float totalWait = 0.0f;
+        auto start = pro::getTime();
+
+        for(int f = 0; f < frameCnt; f++) {
+            glfwPollEvents();
+
+            unsigned int indexSwap = frameRing.acquire(resizeFunc);
+            totalWait += frameRing.getLastWaitSeconds();
+
+            pro::FrameCommandData &cd = frameRing.current();
+            const pro::VulkanSwapImage &swapImage = vkInitData.swapchain().swaps[indexSwap];
+
+            vkInitData.device().resetCommandPool(cd.commandPool);
+            cd.commandBuffer.begin(vk::CommandBufferBeginInfo());
+            pro::performVulkanImageTransition(cd.commandBuffer, swapImage.image, pro::IMAGE_TRANSITION_TYPE::UNDEF_TO_COLOR);
+
+            vk::RenderingAttachmentInfoKHR colorAtt = pro::createColorAttachment(
+                swapImage.view, vk::ClearColorValue {0.0f, 1.0f, 1.0f, 1.0f});
+            vk::RenderingAttachmentInfoKHR depthAtt = pro::createDepthAttachment(frameRing.currentDepthImage().view);
+            vk::RenderingInfoKHR ri{};
+            ri.setRenderArea(vk::Rect2D{ {0,0}, vkInitData.swapchain().extent })
+                .setLayerCount(1)
+                .setColorAttachments(colorAtt)
+                .setPDepthAttachment(&depthAtt);
+
+            cd.commandBuffer.beginRendering(ri);
+            cd.commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineData.pipeline);
+            vk::Viewport viewports[] = { pro::makeDefaultViewport(vkInitData) };    
+            cd.commandBuffer.setViewport(0, viewports);
+            vk::Rect2D scissors[] = { pro::makeDefaultScissors(vkInitData) };
+            cd.commandBuffer.setScissor(0, scissors);
+            for(int d = 0; d < drawsPerFrame; d++) {
+                pro::recordDrawVulkanMesh(cd.commandBuffer, mesh);
+            }
+            cd.commandBuffer.endRendering();
+            pro::performVulkanImageTransition(cd.commandBuffer, swapImage.image, pro::IMAGE_TRANSITION_TYPE::COLOR_TO_PRESENT);
+            cd.commandBuffer.end();
+
+            frameRing.submit(indexSwap, resizeFunc);
+            frameRing.present(indexSwap, resizeFunc);
+        }
+
+        vkInitData.device().waitIdle();
+        float totalSeconds = pro::getElapsedSeconds(start, pro::getTime());
+
+        cout << "N = " << framesInFlight 
+                << ": frame " << (totalSeconds / frameCnt * 1000.0f) << " ms"
+                << ", CPU wait " << (totalWait / frameCnt * 1000.0f) << " ms" << endl;
+    }
+
+    pro::cleanupVulkanMesh(vkInitData, mesh);
+    pro::cleanupVulkanPipeline(vkInitData, pipelineData);
+    return 0;
+}
+
+// Uploads many small buffers through the TransferManager, 
+// with per-copy staging buffers (old path) vs. the staging ring.
+int benchTransfer(GLFWwindow *window, int argc, char **argv) {
+    int bufferCnt = (argc > 2) ? stoi(argv[2]) : 10000;
+    int bufferSize = (argc > 3) ? stoi(argv[3]) : 256;
+    int batchSize = (argc > 4) ? stoi(argv[4]) : 100;
+
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    pro::VulkanInitData vkInitData(createInfo);
+    if(!vkInitData.isTransferQueueValid()) {
+        pro::print_error("benchTransfer", "No transfer queue available!");
+        return 1;
+    }
+
+    // Destination buffers and host data (same for both runs)
+    vector<unsigned char> hostData(bufferSize, 42);
+    vector<pro::VulkanBuffer> allBuffers {};
+    for(int i = 0; i < bufferCnt; i++) {
+        allBuffers.push_back(pro::createVulkanBuffer(   vkInitData, bufferSize,
+                                                        vk::BufferUsageFlagBits::eVertexBuffer 
+                                                            | vk::BufferUsageFlagBits::eTransferDst,
+                                                        pro::createVMADeviceLocalInfo()));
+    }
+
+    // Graphics command buffer to receive the ownership barriers
+    vk::CommandPool graphicsPool = pro::createVulkanCommandPool(vkInitData, vkInitData.graphicsQueue().index);
+    vk::CommandBuffer graphicsBuffer = pro::createVulkanCommandBuffers(vkInitData, graphicsPool).front();
+
+    auto runUploads = [&](vk::DeviceSize stagingRingSize) {
+        pro::TransferManager transferManager(vkInitData, stagingRingSize);
+        auto start = pro::getTime();
+
+        graphicsBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        vector<pro::BufferCopyReceipt> allReceipts {};
+        for(int i = 0; i < bufferCnt; i += batchSize) {
+            vector<pro::PendingBufferCopy> pendingCopies {};
+            for(int j = i; j < min(i + batchSize, bufferCnt); j++) {
+                pendingCopies.push_back(pro::PendingBufferCopy(
+                    allBuffers[j], hostData.data(), vk::AccessFlagBits::eVertexAttributeRead));
+            }
+            allReceipts.push_back(transferManager.submitCopies(pendingCopies));
+
+            // Retire whatever has finished so far (like a render loop would)
+            std::erase_if(allReceipts, [&](pro::BufferCopyReceipt &r) {
+                return transferManager.checkCompleted(r, graphicsBuffer);
+            });
+        }
+
+        // Wait for the rest
+        while(!allReceipts.empty()) {
+            std::erase_if(allReceipts, [&](pro::BufferCopyReceipt &r) {
+                return transferManager.checkCompleted(r, graphicsBuffer);
+            });
+        }
+
+        graphicsBuffer.end();
+        vk::SubmitInfo submitInfo = vk::SubmitInfo().setCommandBuffers(graphicsBuffer);
+        vkInitData.graphicsQueue().queue.submit(submitInfo);
+        vkInitData.graphicsQueue().queue.waitIdle();
+
+        return pro::getElapsedSeconds(start, pro::getTime());
+    };
+
+    float dedicatedSeconds = runUploads(0);
+    float ringSeconds = runUploads(64 * 1024 * 1024);
+
+    cout << "** TRANSFER (" << bufferCnt << " buffers x " << bufferSize 
+            << " bytes, " << batchSize << " per batch) **" << endl;
+    cout << "Per-copy staging buffers: " << (dedicatedSeconds * 1000.0f) << " ms" << endl;
+    cout << "Staging ring:             " << (ringSeconds * 1000.0f) << " ms" << endl;
+
+    pro::cleanupVulkanCommandPool(vkInitData, graphicsPool);
+    for(auto &buffer : allBuffers) {
+        pro::cleanupVulkanBuffer(vkInitData, buffer);
+    }
+    return 0;
+}
+
+// Renders the quad offscreen (works headless, e.g., on lavapipe), reports throughput,
+// then reads back the last frame and compares it against a golden image 
+// (or writes the golden image if it does not exist yet).
+int benchOffscreen(GLFWwindow *window, int argc, char **argv) {
+    int frameCnt = (argc > 2) ? stoi(argv[2]) : 500;
+    string goldenFilename = (argc > 3) ? argv[3] : "";
+    int tolerance = 2;
+
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    pro::VulkanInitData vkInitData(createInfo);
+
+    pro::VulkanPipelineCreateInfo pipelineCreateInfo = makeBenchPipelineCreateInfo(vkInitData);
+    pro::VulkanPipelineData pipelineData = pro::createVulkanPipeline(vkInitData, pipelineCreateInfo);
+
+    pro::HostMesh<ProVertex> quad = makeQuad();
+    pro::narrowHostMeshIndices(quad);
+    pro::VulkanMesh mesh = pro::createVulkanMesh(vkInitData, quad, false);
+    pro::copyToHostVisibleVulkanMesh(vkInitData, mesh, quad);
+
+    vector<pro::VulkanImage> allDepthImages {};
+    pro::recreateAllVulkanDepthImages(vkInitData, allDepthImages, 1);
+    pro::VulkanImage colorImage = pro::createOffscreenColorImage(vkInitData);
+    pro::FrameCommandData cd = pro::createFrameCommandData(vkInitData, 64);
+    pro::GPUProfiler profiler(vkInitData);
+
+    auto start = pro::getTime();
+
+    for(int f = 0; f < frameCnt; f++) {
+        vkInitData.device().waitForFences(cd.inFlight, true, UINT64_MAX);
+        vkInitData.device().resetFences(cd.inFlight);
+
+        vkInitData.device().resetCommandPool(cd.commandPool);
+        cd.commandBuffer.begin(vk::CommandBufferBeginInfo());
+        profiler.beginFrame(cd);
+        profiler.beginScope("frame");
+        pro::performVulkanImageTransition(cd.commandBuffer, colorImage.image, pro::IMAGE_TRANSITION_TYPE::UNDEF_TO_COLOR);
+
+        vk::RenderingAttachmentInfoKHR colorAtt = pro::createColorAttachment(
+            colorImage.view, vk::ClearColorValue {0.0f, 1.0f, 1.0f, 1.0f});
+        vk::RenderingAttachmentInfoKHR depthAtt = pro::createDepthAttachment(allDepthImages[0].view);
+        vk::RenderingInfoKHR ri{};
+        ri.setRenderArea(vk::Rect2D{ {0,0}, vkInitData.swapchain().extent })
+            .setLayerCount(1)
+            .setColorAttachments(colorAtt)
+            .setPDepthAttachment(&depthAtt);
+
+        {
+            pro::GPUProfileScope drawScope(profiler, "draw");
+            cd.commandBuffer.beginRendering(ri);
+            cd.commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineData.pipeline);
+            vk::Viewport viewports[] = { pro::makeDefaultViewport(vkInitData) };    
+            cd.commandBuffer.setViewport(0, viewports);
+            vk::Rect2D scissors[] = { pro::makeDefaultScissors(vkInitData) };
+            cd.commandBuffer.setScissor(0, scissors);
+            pro::recordDrawVulkanMesh(cd.commandBuffer, mesh);
+            cd.commandBuffer.endRendering();
+        }
+
+        pro::performVulkanImageTransition(cd.commandBuffer, colorImage.image, pro::IMAGE_TRANSITION_TYPE::COLOR_TO_TRANSFER_SRC);
+        profiler.endScope();
+        cd.commandBuffer.end();
+
+        pro::submitOffscreenToGraphicsQueue(vkInitData, cd);
+    }
+
+    vkInitData.device().waitIdle();
+    float totalSeconds = pro::getElapsedSeconds(start, pro::getTime());
+
+    cout << "** OFFSCREEN (" << frameCnt << " frames, " 
+            << vkInitData.swapchain().extent.width << "x" << vkInitData.swapchain().extent.height 
+            << (vkInitData.isHeadless() ? ", headless" : "") << ") **" << endl;
+    cout << "Frame: " << (totalSeconds / frameCnt * 1000.0f) << " ms ("
+            << (frameCnt / totalSeconds) << " frames/s)" << endl;
+    profiler.printStats();
+
+    // Golden image check
+    int exitCode = 0;
+    if(!goldenFilename.empty()) {
+        pro::HostImage result = pro::readbackVulkanImage(vkInitData, colorImage);
+
+        if(!filesystem::exists(goldenFilename)) {
+            pro::saveHostImagePNG(goldenFilename, result);
+            cout << "Golden image written: " << goldenFilename << endl;
+        }
+        else {
+            pro::HostImage golden = pro::loadHostImage(goldenFilename, 4);
+            long long diffCnt = pro::countHostImageDifferences(result, golden, tolerance);
+            if(diffCnt != 0) {
+                pro::saveHostImagePNG(goldenFilename + ".actual.png", result);
+                pro::print_failure("benchOffscreen", "Golden image mismatch (" + to_string(diffCnt) 
+                                    + " values differ); wrote " + goldenFilename + ".actual.png");
+                exitCode = 1;
+            }
+            else {
+                cout << "Golden image matches." << endl;
+            }
+        }
+    }
+
+    pro::cleanupFrameCommandData(vkInitData, cd);
+    pro::cleanupVulkanImage(vkInitData, colorImage);
+    pro::cleanupAllVulkanDepthImages(vkInitData, allDepthImages);
+    pro::cleanupVulkanMesh(vkInitData, mesh);
+    pro::cleanupVulkanPipeline(vkInitData, pipelineData);
+    return exitCode;
+}
+
+// Writes an N x N grid (positions, uvs, normals, quads) as a "large" OBJ file
+void writeGridOBJ(const string &filename, int gridSize) {
+    ofstream file(filename);
+    for(int y = 0; y <= gridSize; y++) {
+        for(int x = 0; x <= gridSize; x++) {
+            float u = (float)x / gridSize;
+            float v = (float)y / gridSize;
+            file << "v " << (u * 2.0f - 1.0f) << " " << sin(u * 10.0f) * 0.1f << " " << (v * 2.0f - 1.0f) << "\n";
+            file << "vt " << u << " " << v << "\n";
+            file << "vn 0 1 0\n";
+        }
+    }
+    for(int y = 0; y < gridSize; y++) {
+        for(int x = 0; x < gridSize; x++) {
+            int i0 = y * (gridSize + 1) + x + 1;
+            int i1 = i0 + 1;
+            int i2 = i1 + gridSize + 1;
+            int i3 = i0 + gridSize + 1;
+            file << "f " << i0 << "/" << i0 << "/" << i0 << " " 
+                    << i1 << "/" << i1 << "/" << i1 << " " 
+                    << i2 << "/" << i2 << "/" << i2 << " " 
+                    << i3 << "/" << i3 << "/" << i3 << "\n";
+        }
+    }
+}
+
+// Checks pro::parseObjFloat() against strtof() on awkward inputs (long leading-zero fractions,
+// more digits than the mantissa keeps, exponents, denormals); returns the number of mismatches
+int checkOBJFloatParsing() {
+    const vector<string> allInputs = {
+        "0.000000000000000123456",
+        "-0.00000000000000000000000001234567891234",
+        "0.0000000000000000000000000000000000001175494351",
+        "0.000000000000000000000000000000000000000000001401298",
+        "00000000000000000000001.25",
+        "123456789012345678901234.5",
+        "3.14159265358979323846",
+        "6.02214076e23",
+        "1.5e-10",
+        "-0e5"
+    };
+
+    int mismatchCnt = 0;
+    for(auto &input : allInputs) {
+        const char *p = input.c_str();
+        float parsed = 0.0f;
+        pro::parseObjFloat(p, input.c_str() + input.size(), parsed);
+        float expected = strtof(input.c_str(), nullptr);
+        if(parsed != expected && fabs(parsed - expected) > 1e-6f * fabs(expected)) {
+            cout << "parseObjFloat(\"" << input << "\") = " << parsed << ", expected " << expected << endl;
+            mismatchCnt++;
+        }
+    }
+    return mismatchCnt;
+}
+
+// Compares loadOBJ() (mmap + parallel parse) against the assimp importer.
+// With no file, a large grid OBJ is generated first.
+int benchOBJLoad(GLFWwindow *window, int argc, char **argv) {
+    string filename = (argc > 2) ? argv[2] : "";
+    int iterations = (argc > 3) ? stoi(argv[3]) : 5;
+
+    if(filename.empty()) {
+        filename = "probench_grid.obj";
+        if(!filesystem::exists(filename)) {
+            cout << "Generating " << filename << "..." << endl;
+            writeGridOBJ(filename, 1000);
+        }
+    }
+
+    float objSeconds = 0.0f;
+    float assimpSeconds = 0.0f;
+    size_t objVertexCnt = 0, objIndexCnt = 0, assimpVertexCnt = 0, assimpIndexCnt = 0;
+
+    for(int i = 0; i < iterations; i++) {
+        auto start = pro::getTime();
+        pro::HostMesh<ProVertex> mesh = pro::loadOBJ<ProVertex>(filename);
+        objSeconds += pro::getElapsedSeconds(start, pro::getTime());
+        objVertexCnt = mesh.vertices.size();
+        objIndexCnt = mesh.indices.size();
+
+        // Same output through assimp (including conversion to HostMesh)
+        start = pro::getTime();
+        pro::HostModel<ProVertex> model = pro::loadModel<ProVertex>(filename);
+        assimpVertexCnt = 0;
+        assimpIndexCnt = 0;
+        for(auto &m : model.meshes) {
+            assimpVertexCnt += m.vertices.size();
+            assimpIndexCnt += m.indices.size();
+        }
+        assimpSeconds += pro::getElapsedSeconds(start, pro::getTime());
+    }
+
+    cout << "** OBJ LOAD (" << filename << ", " << iterations << " iterations, average) **" << endl;
+    cout << "loadOBJ: " << (objSeconds / iterations * 1000.0f) << " ms (" 
+            << objVertexCnt << " vertices, " << objIndexCnt << " indices)" << endl;
+    cout << "assimp:  " << (assimpSeconds / iterations * 1000.0f) << " ms (" 
+            << assimpVertexCnt << " vertices, " << assimpIndexCnt << " indices)" << endl;
+
+    int mismatchCnt = checkOBJFloatParsing();
+    cout << "Float parsing: " << (mismatchCnt == 0 ? "matches strtof()" : to_string(mismatchCnt) + " mismatches") << endl;
+    return (mismatchCnt == 0) ? 0 : 1;
+}
+
+// Compares parsing an OBJ every time against the mmap'd binary mesh cache.
+int benchMeshCache(GLFWwindow *window, int argc, char **argv) {
+    string filename = (argc > 2) ? argv[2] : "";
+    int iterations = (argc > 3) ? stoi(argv[3]) : 5;
+
+    if(filename.empty()) {
+        filename = "probench_grid.obj";
+        if(!filesystem::exists(filename)) {
+            cout << "Generating " << filename << "..." << endl;
+            writeGridOBJ(filename, 1000);
+        }
+    }
+
+    // Cold: force a rebuild
+    error_code err;
+    filesystem::remove(filename + ".pmesh", err);
+    auto start = pro::getTime();
+    {
+        pro::MappedHostMesh<ProVertex> mesh = pro::loadMeshCached<ProVertex>(filename);
+    }
+    float coldSeconds = pro::getElapsedSeconds(start, pro::getTime());
+
+    float objSeconds = 0.0f;
+    float cachedSeconds = 0.0f;
+    float cachedNoHashSeconds = 0.0f;
+    size_t vertexCnt = 0, indexCnt = 0;
+    pro::MeshCacheOptions noHashOptions {};
+    noHashOptions.verifySourceHash = false;
+
+    for(int i = 0; i < iterations; i++) {
+        start = pro::getTime();
+        pro::HostMesh<ProVertex> hostMesh = pro::loadOBJ<ProVertex>(filename);
+        objSeconds += pro::getElapsedSeconds(start, pro::getTime());
+
+        start = pro::getTime();
+        pro::MappedHostMesh<ProVertex> mesh = pro::loadMeshCached<ProVertex>(filename);
+        cachedSeconds += pro::getElapsedSeconds(start, pro::getTime());
+        vertexCnt = mesh.vertexCnt();
+        indexCnt = mesh.indexCnt();
+
+        start = pro::getTime();
+        pro::MappedHostMesh<ProVertex> meshNoHash = pro::loadMeshCached<ProVertex>(filename, 
+                                                            [](const string &f) { return pro::loadOBJ<ProVertex>(f); }, 
+                                                            noHashOptions);
+        cachedNoHashSeconds += pro::getElapsedSeconds(start, pro::getTime());
+    }
+
+    cout << "** MESH CACHE (" << filename << ", " << vertexCnt << " vertices, " << indexCnt << " indices) **" << endl;
+    cout << "Cold (parse + write cache): " << (coldSeconds * 1000.0f) << " ms" << endl;
+    cout << "loadOBJ:                    " << (objSeconds / iterations * 1000.0f) << " ms" << endl;
+    cout << "Cache (hash checked):       " << (cachedSeconds / iterations * 1000.0f) << " ms" << endl;
+    cout << "Cache (mtime/size only):    " << (cachedNoHashSeconds / iterations * 1000.0f) << " ms" << endl;
+    return 0;
+}
+
+// Runs the mesh optimization pipeline and reports vertex cache stats before/after.
+int benchMeshOpt(GLFWwindow *window, int argc, char **argv) {
+    string filename = (argc > 2) ? argv[2] : "sampleModels/teapot.obj";
+    unsigned int cacheSize = (argc > 3) ? (unsigned int)stoi(argv[3]) : 16;
+    float lambda = (argc > 4) ? stof(argv[4]) : pro::MeshOptOptions().clusterACMR;
+
+    pro::HostMesh<ProVertex> hostMesh = pro::loadOBJ<ProVertex>(filename);
+
+    pro::MeshOptOptions options {};
+    options.cacheSize = cacheSize;
+    options.clusterACMR = lambda;
+
+    auto start = pro::getTime();
+    pro::MeshOptReport report = pro::optimizeHostMesh(hostMesh, options);
+    float seconds = pro::getElapsedSeconds(start, pro::getTime());
+
+    cout << "** MESH OPTIMIZATION (" << filename << ", " << hostMesh.vertices.size() << " vertices, " 
+            << hostMesh.indices.size() << " indices, cache size " << cacheSize << ", lambda " << lambda << ") **" << endl;
+    pro::printMeshOptReport(report);
+    cout << "Time: " << (seconds * 1000.0f) << " ms" << endl;
+    return 0;
+}
+
+// Draws hostMesh drawsPerFrame times per frame (offscreen); returns average seconds per frame
+template<typename T>
+float timeOffscreenDraws(pro::VulkanInitData &vkInitData, pro::HostMesh<T> &hostMesh, int frameCnt, int drawsPerFrame) {
+    pro::VulkanPipelineCreateInfo pipelineCreateInfo = makeBenchPipelineCreateInfo<T>(vkInitData);
+    pro::VulkanPipelineData pipelineData = pro::createVulkanPipeline(vkInitData, pipelineCreateInfo);
+
+    // Host-visible (like benchOffscreen), so vertex fetch bandwidth matters even more
+    pro::narrowHostMeshIndices(hostMesh);
+    pro::VulkanMesh mesh = pro::createVulkanMesh(vkInitData, hostMesh, false);
+    pro::copyToHostVisibleVulkanMesh(vkInitData, mesh, hostMesh);
+
+    vector<pro::VulkanImage> allDepthImages {};
+    pro::recreateAllVulkanDepthImages(vkInitData, allDepthImages, 1);
+    pro::VulkanImage colorImage = pro::createOffscreenColorImage(vkInitData);
+    pro::FrameCommandData cd = pro::createFrameCommandData(vkInitData);
+
+    auto start = pro::getTime();
+
+    for(int f = 0; f < frameCnt; f++) {
+        vkInitData.device().waitForFences(cd.inFlight, true, UINT64_MAX);
+        vkInitData.device().resetFences(cd.inFlight);
+
+        vkInitData.device().resetCommandPool(cd.commandPool);
+        cd.commandBuffer.begin(vk::CommandBufferBeginInfo());
+        pro::performVulkanImageTransition(cd.commandBuffer, colorImage.image, pro::IMAGE_TRANSITION_TYPE::UNDEF_TO_COLOR);
+
+        vk::RenderingAttachmentInfoKHR colorAtt = pro::createColorAttachment(
+            colorImage.view, vk::ClearColorValue {0.0f, 0.0f, 0.0f, 1.0f});
+        vk::RenderingAttachmentInfoKHR depthAtt = pro::createDepthAttachment(allDepthImages[0].view);
+        vk::RenderingInfoKHR ri{};
+        ri.setRenderArea(vk::Rect2D{ {0,0}, vkInitData.swapchain().extent })
+            .setLayerCount(1)
+            .setColorAttachments(colorAtt)
+            .setPDepthAttachment(&depthAtt);
+
+        cd.commandBuffer.beginRendering(ri);
+        cd.commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineData.pipeline);
+        vk::Viewport viewports[] = { pro::makeDefaultViewport(vkInitData) };    
+        cd.commandBuffer.setViewport(0, viewports);
+        vk::Rect2D scissors[] = { pro::makeDefaultScissors(vkInitData) };
+        cd.commandBuffer.setScissor(0, scissors);
+        pro::VulkanMeshBindState bindState {};
+        for(int d = 0; d < drawsPerFrame; d++) {
+            pro::recordDrawVulkanMesh(cd.commandBuffer, mesh, bindState);
+        }
+        cd.commandBuffer.endRendering();
+        cd.commandBuffer.end();
+
+        pro::submitOffscreenToGraphicsQueue(vkInitData, cd);
+    }
+
+    vkInitData.device().waitIdle();
+    float seconds = pro::getElapsedSeconds(start, pro::getTime()) / frameCnt;
+
+    pro::cleanupFrameCommandData(vkInitData, cd);
+    pro::cleanupVulkanImage(vkInitData, colorImage);
+    pro::cleanupAllVulkanDepthImages(vkInitData, allDepthImages);
+    pro::cleanupVulkanMesh(vkInitData, mesh);
+    pro::cleanupVulkanPipeline(vkInitData, pipelineData);
+    return seconds;
+}
+
+// Reports quantization error for each packed vertex format,
+// then compares draw time of full-float vs. packed (PackedVertexPC) vertices.
+int benchVertexPack(GLFWwindow *window, int argc, char **argv) {
+    string filename = (argc > 2) ? argv[2] : "";
+    int frameCnt = (argc > 3) ? stoi(argv[3]) : 100;
+    int drawsPerFrame = (argc > 4) ? stoi(argv[4]) : 20;
+
+    if(filename.empty()) {
+        filename = "probench_grid.obj";
+        if(!filesystem::exists(filename)) {
+            cout << "Generating " << filename << "..." << endl;
+            writeGridOBJ(filename, 1000);
+        }
+    }
+
+    struct FullVertex {
+        glm::vec3 pos;
+        glm::vec3 normal;
+        glm::vec2 uv;
+        glm::vec4 color;
+    };
+
+    pro::HostMesh<FullVertex> fullMesh = pro::loadOBJ<FullVertex>(filename);
+    pro::VertexQuantization quant {};
+    pro::VertexQuantizationReport report {};
+
+    cout << "** VERTEX PACKING (" << filename << ", " << fullMesh.vertices.size() << " vertices) **" << endl;
+
+    cout << "-- PackedVertexPC (" << sizeof(pro::PackedVertexPC) << " bytes) --" << endl;
+    pro::packHostMesh<pro::PackedVertexPC>(fullMesh, quant, &report);
+    pro::printVertexQuantizationReport(report);
+
+    cout << "-- PackedVertexPNU (" << sizeof(pro::PackedVertexPNU) << " bytes) --" << endl;
+    pro::packHostMesh<pro::PackedVertexPNU>(fullMesh, quant, &report);
+    pro::printVertexQuantizationReport(report);
+
+    cout << "-- QuantizedVertexPNUC (" << sizeof(pro::QuantizedVertexPNUC) << " bytes) --" << endl;
+    pro::packHostMesh<pro::QuantizedVertexPNUC>(fullMesh, quant, &report);
+    pro::printVertexQuantizationReport(report);
+
+    // GPU: same mesh with the bench shaders (pos + color)
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    pro::VulkanInitData vkInitData(createInfo);
+
+    pro::HostMesh<ProVertex> floatMesh = pro::loadOBJ<ProVertex>(filename);
+    pro::HostMesh<pro::PackedVertexPC> packedMesh = pro::packHostMesh<pro::PackedVertexPC>(floatMesh, quant);
+
+    float floatSeconds = timeOffscreenDraws(vkInitData, floatMesh, frameCnt, drawsPerFrame);
+    float packedSeconds = timeOffscreenDraws(vkInitData, packedMesh, frameCnt, drawsPerFrame);
+
+    cout << "-- Draw time (" << frameCnt << " frames, " << drawsPerFrame << " draws/frame) --" << endl;
+    cout << "ProVertex (" << sizeof(ProVertex) << " bytes):      " << (floatSeconds * 1000.0f) << " ms/frame" << endl;
+    cout << "PackedVertexPC (" << sizeof(pro::PackedVertexPC) << " bytes): " << (packedSeconds * 1000.0f) << " ms/frame" << endl;
+    return 0;
+}
+
+// Decodes the sample textures (copies times each) serially vs. on worker threads,
+// then uploads them all through the transfer queue in one batch.
+int benchTexture(GLFWwindow *window, int argc, char **argv) {
+    int copies = (argc > 2) ? stoi(argv[2]) : 8;
+
+    vector<string> filenames {};
+    for(int i = 0; i < copies; i++) {
+        filenames.push_back("textures/sponge.jpg");
+        filenames.push_back("textures/normalMap.png");
+    }
+
+    // Decode
+    auto start = pro::getTime();
+    vector<pro::HostImage> hostImages = pro::loadHostImagesParallel(filenames, 4, 1);
+    float serialSeconds = pro::getElapsedSeconds(start, pro::getTime());
+
+    start = pro::getTime();
+    hostImages = pro::loadHostImagesParallel(filenames, 4);
+    float parallelSeconds = pro::getElapsedSeconds(start, pro::getTime());
+
+    size_t totalBytes = 0;
+    for(auto &image : hostImages) {
+        totalBytes += image.data.size();
+    }
+
+    // Upload
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    pro::VulkanInitData vkInitData(createInfo);
+    if(!vkInitData.isTransferQueueValid()) {
+        pro::print_error("benchTexture", "No transfer queue available!");
+        return 1;
+    }
+
+    vk::CommandPool graphicsPool = pro::createVulkanCommandPool(vkInitData, vkInitData.graphicsQueue().index);
+    vk::CommandBuffer graphicsBuffer = pro::createVulkanCommandBuffers(vkInitData, graphicsPool).front();
+    vector<pro::VulkanImage> allTextures {};
+    vk::Sampler sampler = pro::createVulkanSampler(vkInitData);
+
+    auto runUpload = [&](pro::TextureLoadOptions options) {
+        pro::TransferManager transferManager(vkInitData, 128 * 1024 * 1024);
+        auto uploadStart = pro::getTime();
+
+        graphicsBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+        pro::BufferCopyReceipt receipt = pro::submitTextureUploads(vkInitData, transferManager, hostImages, allTextures, options);
+        while(!transferManager.checkCompleted(receipt, graphicsBuffer)) {}
+        graphicsBuffer.end();
+
+        vk::SubmitInfo submitInfo = vk::SubmitInfo().setCommandBuffers(graphicsBuffer);
+        vkInitData.graphicsQueue().queue.submit(submitInfo);
+        vkInitData.graphicsQueue().queue.waitIdle();
+        vkInitData.device().resetCommandPool(graphicsPool);
+
+        return pro::getElapsedSeconds(uploadStart, pro::getTime());
+    };
+
+    pro::TextureLoadOptions options {};
+    options.mipmaps = pro::MIPMAPS_NONE;
+    float noMipSeconds = runUpload(options);
+    options.mipmaps = pro::MIPMAPS_GPU;
+    float gpuMipSeconds = runUpload(options);
+    options.mipmaps = pro::MIPMAPS_CPU;
+    options.cpuFilter = pro::MIPMAP_BOX;
+    float boxMipSeconds = runUpload(options);
+    options.cpuFilter = pro::MIPMAP_KAISER;
+    float kaiserMipSeconds = runUpload(options);
+
+    cout << "** TEXTURE (" << filenames.size() << " images, " << (totalBytes / (1024.0f * 1024.0f)) << " MB decoded) **" << endl;
+    cout << "Decode (1 thread):         " << (serialSeconds * 1000.0f) << " ms" << endl;
+    cout << "Decode (parallel):         " << (parallelSeconds * 1000.0f) << " ms" << endl;
+    cout << "Upload (no mips):          " << (noMipSeconds * 1000.0f) << " ms" << endl;
+    cout << "Upload (GPU blit mips):    " << (gpuMipSeconds * 1000.0f) << " ms" << endl;
+    cout << "Upload (CPU box mips):     " << (boxMipSeconds * 1000.0f) << " ms" << endl;
+    cout << "Upload (CPU Kaiser mips):  " << (kaiserMipSeconds * 1000.0f) << " ms" << endl;
+
+    pro::cleanupVulkanSampler(vkInitData, sampler);
+    for(auto &texture : allTextures) {
+        pro::cleanupVulkanImage(vkInitData, texture);
+    }
+    pro::cleanupVulkanCommandPool(vkInitData, graphicsPool);
+    return 0;
+}
+
+int benchTexCompress(GLFWwindow *window, int argc, char **argv) {
+    unsigned int threadCnt = (argc > 2) ? (unsigned int)stoi(argv[2]) : 0;
+
+    // Color texture + normal map (BC5 is only meant for the latter)
+    vector<string> filenames = { "textures/sponge.jpg", "textures/normalMap.png" };
+    vector<pro::HostImage> hostImages = pro::loadHostImagesParallel(filenames);
+    vector<vector<pro::HostImage>> allLevels {};
+    size_t totalPixels = 0;
+    for(size_t i = 0; i < hostImages.size(); i++) {
+        allLevels.push_back(pro::generateHostMipChain(hostImages[i], (i == 0)));
+        for(auto &level : allLevels.back()) {
+            totalPixels += (size_t)level.width * level.height;
+        }
+    }
+
+    cout << "** TEXCOMPRESS (" << filenames.size() << " mip chains, " << (totalPixels / 1.0e6f) << " Mpixels) **" << endl;
+    for(auto compression : { pro::COMPRESS_BC1, pro::COMPRESS_BC3, pro::COMPRESS_BC5, pro::COMPRESS_BC7 }) {
+        auto runEncode = [&](unsigned int threads) {
+            size_t bytes = 0;
+            auto start = pro::getTime();
+            for(auto &levels : allLevels) {
+                bytes += pro::compressHostMipChainBC(levels, compression, threads).data.size();
+            }
+            return make_pair(pro::getElapsedSeconds(start, pro::getTime()), bytes);
+        };
+        auto [serialSeconds, bytes] = runEncode(1);
+        auto [parallelSeconds, parallelBytes] = runEncode(threadCnt);
+
+        cout << pro::getTextureCompressionName(compression) << ": "
+             << (bytes / 1024) << " KB (" << (totalPixels * 4 / 1024) << " KB raw), "
+             << "1 thread " << (serialSeconds * 1000.0f) << " ms (" << (totalPixels / 1.0e6f / serialSeconds) << " Mpix/s), "
+             << "parallel " << (parallelSeconds * 1000.0f) << " ms (" << (totalPixels / 1.0e6f / parallelSeconds) << " Mpix/s)" << endl;
+    }
+
+    // Cold (encode + write cache) vs. warm (map cache) loads
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    pro::VulkanInitData vkInitData(createInfo);
+    if(!vkInitData.isTransferQueueValid()) {
+        pro::print_error("benchTexCompress", "No transfer queue available!");
+        return 1;
+    }
+    if(!vkInitData.enabledFeatures().textureCompressionBC) {
+        pro::print_warning("benchTexCompress", "No BC texture support; skipping upload test.");
+        return 0;
+    }
+
+    vk::CommandPool graphicsPool = pro::createVulkanCommandPool(vkInitData, vkInitData.graphicsQueue().index);
+    vk::CommandBuffer graphicsBuffer = pro::createVulkanCommandBuffers(vkInitData, graphicsPool).front();
+    vector<pro::VulkanImage> allTextures {};
+
+    auto runLoad = [&](bool removeCaches) {
+        pro::TextureLoadOptions options {};
+        options.mipmaps = pro::MIPMAPS_CPU;
+        options.threadCnt = threadCnt;
+        pro::TextureCacheOptions cacheOptions {};
+
+        if(removeCaches) {
+            for(auto &filename : filenames) {
+                filesystem::remove(pro::getTextureCacheFilename(filename, pro::COMPRESS_BC7));
+                filesystem::remove(pro::getTextureCacheFilename(filename, pro::COMPRESS_BC5));
+            }
+        }
+
+        pro::TransferManager transferManager(vkInitData, 64 * 1024 * 1024);
+        auto start = pro::getTime();
+
+        graphicsBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+        for(size_t i = 0; i < filenames.size(); i++) {
+            options.sRGB = (i == 0);
+            cacheOptions.isNormalMap = (i == 1);
+            pro::BufferCopyReceipt receipt = pro::loadCompressedTextures(   vkInitData, transferManager,
+                                                                            { filenames[i] }, allTextures,
+                                                                            options, cacheOptions);
+            while(!transferManager.checkCompleted(receipt, graphicsBuffer)) {}
+        }
+        graphicsBuffer.end();
+
+        vk::SubmitInfo submitInfo = vk::SubmitInfo().setCommandBuffers(graphicsBuffer);
+        vkInitData.graphicsQueue().queue.submit(submitInfo);
+        vkInitData.graphicsQueue().queue.waitIdle();
+        vkInitData.device().resetCommandPool(graphicsPool);
+
+        return pro::getElapsedSeconds(start, pro::getTime());
+    };
+
+    float coldSeconds = runLoad(true);
+    float warmSeconds = runLoad(false);
+    cout << "Load BC7 + BC5 (encode, write cache): " << (coldSeconds * 1000.0f) << " ms" << endl;
+    cout << "Load BC7 + BC5 (mapped cache):        " << (warmSeconds * 1000.0f) << " ms" << endl;
+
+    for(auto &texture : allTextures) {
+        pro::cleanupVulkanImage(vkInitData, texture);
+    }
+    pro::cleanupVulkanCommandPool(vkInitData, graphicsPool);
+    return 0;
+}
+
+// Streams many textures in while rendering offscreen frames;
+// compares frame times with no per-frame upload limit vs. the streaming byte budget.
+int benchStreaming(GLFWwindow *window, int argc, char **argv) {
+    int copies = (argc > 2) ? stoi(argv[2]) : 32;
+    vk::DeviceSize budgetMB = (argc > 3) ? (vk::DeviceSize)stoi(argv[3]) : 8;
+    vk::DeviceSize capMB = (argc > 4) ? (vk::DeviceSize)stoi(argv[4]) : 0;
+
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    createInfo.requireTransferQueue = true;
+    pro::VulkanInitData vkInitData(createInfo);
+
+    vector<pro::VulkanImage> allDepthImages {};
+    pro::recreateAllVulkanDepthImages(vkInitData, allDepthImages, 1);
+    pro::VulkanImage colorImage = pro::createOffscreenColorImage(vkInitData);
+
+    auto runStreaming = [&](vk::DeviceSize maxUploadBytesPerFrame) {
+        pro::StreamingOptions options {};
+        options.maxUploadBytesPerFrame = maxUploadBytesPerFrame;
+        options.maxResidentBytes = capMB * 1024 * 1024;
+        pro::StreamingManager streaming(vkInitData, options);
+        pro::FrameCommandData cd = pro::createFrameCommandData(vkInitData);
+
+        // Earlier requests get higher priority
+        vector<pro::StreamHandle> allHandles {};
+        for(int i = 0; i < copies; i++) {
+            float priority = (float)(copies - i);
+            allHandles.push_back(streaming.request(pro::makeTextureStreamRequest("textures/sponge.jpg", priority)));
+            allHandles.push_back(streaming.request(pro::makeTextureStreamRequest("textures/normalMap.png", priority, false)));
+        }
+
+        vector<float> allFrameTimes {};
+        int frame = 0;
+        while(true) {
+            auto frameStart = pro::getTime();
+            vkInitData.device().waitForFences(cd.inFlight, true, UINT64_MAX);
+            vkInitData.device().resetFences(cd.inFlight);
+            vkInitData.device().resetCommandPool(cd.commandPool);
+            cd.commandBuffer.begin(vk::CommandBufferBeginInfo());
+
+            streaming.update(cd.commandBuffer);
+
+            // "Use" a sliding window of textures (the rest can be evicted if capped)
+            for(size_t i = 0; i < allHandles.size(); i++) {
+                bool inWindow = (capMB == 0) || ((i + frame) % allHandles.size() < allHandles.size() / 2);
+                if(inWindow) {
+                    streaming.getTexture(allHandles[i]);
+                }
+            }
+
+            pro::performVulkanImageTransition(cd.commandBuffer, colorImage.image, pro::IMAGE_TRANSITION_TYPE::UNDEF_TO_COLOR);
+            vk::RenderingAttachmentInfoKHR colorAtt = pro::createColorAttachment(
+                colorImage.view, vk::ClearColorValue {0.0f, 0.0f, 0.0f, 1.0f});
+            vk::RenderingAttachmentInfoKHR depthAtt = pro::createDepthAttachment(allDepthImages[0].view);
+            vk::RenderingInfoKHR ri{};
+            ri.setRenderArea(vk::Rect2D{ {0,0}, vkInitData.swapchain().extent })
+                .setLayerCount(1)
+                .setColorAttachments(colorAtt)
+                .setPDepthAttachment(&depthAtt);
+            cd.commandBuffer.beginRendering(ri);
+            cd.commandBuffer.endRendering();
+            cd.commandBuffer.end();
+            pro::submitOffscreenToGraphicsQueue(vkInitData, cd);
+
+            allFrameTimes.push_back(pro::getElapsedSeconds(frameStart, pro::getTime()) * 1000.0f);
+            frame++;
+
+            // Uncapped: until everything is resident; capped: fixed frame count (it never settles)
+            pro::StreamingStats stats = streaming.getStats();
+            bool isDone = (stats.queuedCnt + stats.decodedCnt + stats.uploadingCnt == 0);
+            if(capMB == 0 ? isDone : (frame >= 600)) {
+                if(capMB > 0) {
+                    cout << "Evictions: " << stats.totalEvictions << ", resident: " 
+                         << (stats.residentBytes / (1024 * 1024)) << " MB" << endl;
+                }
+                break;
+            }
+        }
+
+        vkInitData.device().waitIdle();
+        pro::cleanupFrameCommandData(vkInitData, cd);
+
+        vector<float> sorted = allFrameTimes;
+        sort(sorted.begin(), sorted.end());
+        float total = 0.0f;
+        for(float t : sorted) {
+            total += t;
+        }
+        cout << "Frames: " << sorted.size()
+             << ", avg " << (total / sorted.size()) << " ms"
+             << ", p99 " << sorted[min(sorted.size() - 1, sorted.size() * 99 / 100)] << " ms"
+             << ", max " << sorted.back() << " ms" << endl;
+    };
+
+    cout << "** STREAMING (" << (copies * 2) << " textures) **" << endl;
+    cout << "-- No per-frame upload limit --" << endl;
+    runStreaming(0);
+    cout << "-- " << budgetMB << " MB per frame --" << endl;
+    runStreaming(budgetMB * 1024 * 1024);
+
+    pro::cleanupVulkanImage(vkInitData, colorImage);
+    pro::cleanupAllVulkanDepthImages(vkInitData, allDepthImages);
+    return 0;
+}
+
+// Per-scope cost of the CPU profiler (on, switched off at runtime, and no scope at all),
+// then a few threads of nested scopes written out as a Chrome trace
+int benchCPUProfile(GLFWwindow *window, int argc, char **argv) {
+    int scopeCnt = (argc > 2) ? stoi(argv[2]) : 1000000;
+    string traceFilename = (argc > 3) ? argv[3] : "probench_trace.json";
+
+    pro::CPUProfiler &profiler = pro::CPUProfiler::get();
+    volatile uint64_t sink = 0;
+
+    auto timeScopes = [&](bool useScope) {
+        auto start = pro::getTime();
+        for(int i = 0; i < scopeCnt; i++) {
+            if(useScope) {
+                pro::CPUProfileScope scope("bench");
+                sink = sink + i;
+            }
+            else {
+                sink = sink + i;
+            }
+        }
+        return pro::getElapsedSeconds(start, pro::getTime()) * 1.0e9f / scopeCnt;
+    };
+
+    float baseNs = timeScopes(false);
+    profiler.setEnabled(true);
+    float enabledNs = timeScopes(true);
+    profiler.setEnabled(false);
+    float disabledNs = timeScopes(true);
+    profiler.setEnabled(true);
+
+    cout << "** CPU PROFILER (" << scopeCnt << " scopes) **" << endl;
+#ifdef PRO_ENABLE_CPU_PROFILER
+    cout << "PRO_PROFILE_SCOPE: compiled in" << endl;
+#else
+    cout << "PRO_PROFILE_SCOPE: compiled out (configure with -DPRO_ENABLE_CPU_PROFILER=ON)" << endl;
+#endif
+    cout << "Recording: " << (enabledNs - baseNs) << " ns/scope" << endl;
+    cout << "Switched off: " << (disabledNs - baseNs) << " ns/scope" << endl;
+
+    // Nested scopes on several threads
+    profiler.clear();
+    unsigned int threadCnt = min(4u, max(1u, thread::hardware_concurrency()));
+    pro::runInParallel(threadCnt * 8, [&](size_t job) {
+        pro::CPUProfileScope jobScope("job");
+        for(int i = 0; i < 100; i++) {
+            pro::CPUProfileScope outerScope("outer");
+            for(int j = 0; j < 10; j++) {
+                pro::CPUProfileScope innerScope("inner");
+                for(int k = 0; k < 1000; k++) {
+                    sink = sink + k;
+                }
+            }
+        }
+    }, threadCnt);
+
+    size_t eventCnt = 0;
+    for(auto &trace : profiler.capture()) {
+        eventCnt += trace.allEvents.size();
+    }
+    if(!profiler.writeChromeTrace(traceFilename)) {
+        return 1;
+    }
+    cout << "Wrote " << eventCnt << " events from " << threadCnt << " threads to " << traceFilename << endl;
+    return 0;
+}
+
+// CPU time to record many draws into one primary command buffer vs. secondaries 
+// recorded by 1..N threads (pro::ParallelCommandRecorder on a pro::JobSystem of that size)
+int benchParallelRecord(GLFWwindow *window, int argc, char **argv) {
+    int frameCnt = (argc > 2) ? stoi(argv[2]) : 200;
+    int drawsPerFrame = (argc > 3) ? stoi(argv[3]) : 20000;
+    unsigned int maxThreads = (argc > 4) ? (unsigned int)stoi(argv[4]) : max(1u, thread::hardware_concurrency());
+
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    pro::VulkanInitData vkInitData(createInfo);
+
+    pro::VulkanPipelineCreateInfo pipelineCreateInfo = makeBenchPipelineCreateInfo(vkInitData);
+    pro::VulkanPipelineData pipelineData = pro::createVulkanPipeline(vkInitData, pipelineCreateInfo);
+
+    pro::HostMesh<ProVertex> quad = makeQuad();
+    pro::narrowHostMeshIndices(quad);
+    pro::VulkanMesh mesh = pro::createVulkanMesh(vkInitData, quad, false);
+    pro::copyToHostVisibleVulkanMesh(vkInitData, mesh, quad);
+
+    vector<pro::VulkanImage> allDepthImages {};
+    pro::recreateAllVulkanDepthImages(vkInitData, allDepthImages, 1);
+    pro::VulkanImage colorImage = pro::createOffscreenColorImage(vkInitData);
+    pro::FrameCommandData cd = pro::createFrameCommandData(vkInitData);
+    pro::SecondaryRenderingInfo secondaryInfo(vkInitData);
+
+    // Same commands for the primary and for each secondary slice
+    auto recordDraws = [&](vk::CommandBuffer &cmd, size_t begin, size_t end) {
+        cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineData.pipeline);
+        vk::Viewport viewports[] = { pro::makeDefaultViewport(vkInitData) };    
+        cmd.setViewport(0, viewports);
+        vk::Rect2D scissors[] = { pro::makeDefaultScissors(vkInitData) };
+        cmd.setScissor(0, scissors);
+        pro::VulkanMeshBindState bindState {};
+        for(size_t d = begin; d < end; d++) {
+            pro::recordDrawVulkanMesh(cmd, mesh, bindState);
+        }
+    };
+
+    // threadCnt = 0 --> everything in the primary
+    auto runFrames = [&](unsigned int threadCnt, float &recordMs, float &frameMs) {
+        unique_ptr<pro::JobSystem> jobs {};
+        unique_ptr<pro::ParallelCommandRecorder> recorder {};
+        if(threadCnt > 0) {
+            jobs = make_unique<pro::JobSystem>(threadCnt);
+            recorder = make_unique<pro::ParallelCommandRecorder>(vkInitData, 1, threadCnt, *jobs);
+        }
+
+        float recordSeconds = 0.0f;
+        auto start = pro::getTime();
+        for(int f = 0; f < frameCnt; f++) {
+            vkInitData.device().waitForFences(cd.inFlight, true, UINT64_MAX);
+            vkInitData.device().resetFences(cd.inFlight);
+
+            auto startRecord = pro::getTime();
+            vkInitData.device().resetCommandPool(cd.commandPool);
+            cd.commandBuffer.begin(vk::CommandBufferBeginInfo());
+            pro::performVulkanImageTransition(cd.commandBuffer, colorImage.image, pro::IMAGE_TRANSITION_TYPE::UNDEF_TO_COLOR);
+
+            vk::RenderingAttachmentInfoKHR colorAtt = pro::createColorAttachment(
+                colorImage.view, vk::ClearColorValue {0.0f, 1.0f, 1.0f, 1.0f});
+            vk::RenderingAttachmentInfoKHR depthAtt = pro::createDepthAttachment(allDepthImages[0].view);
+            vk::RenderingInfoKHR ri{};
+            ri.setRenderArea(vk::Rect2D{ {0,0}, vkInitData.swapchain().extent })
+                .setLayerCount(1)
+                .setColorAttachments(colorAtt)
+                .setPDepthAttachment(&depthAtt);
+
+            if(recorder) {
+                ri.setFlags(vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
+                cd.commandBuffer.beginRendering(ri);
+                recorder->record(cd.commandBuffer, 0, secondaryInfo, drawsPerFrame, recordDraws);
+            }
+            else {
+                cd.commandBuffer.beginRendering(ri);
+                recordDraws(cd.commandBuffer, 0, drawsPerFrame);
+            }
+            cd.commandBuffer.endRendering();
+
+            pro::performVulkanImageTransition(cd.commandBuffer, colorImage.image, pro::IMAGE_TRANSITION_TYPE::COLOR_TO_TRANSFER_SRC);
+            cd.commandBuffer.end();
+            recordSeconds += pro::getElapsedSeconds(startRecord, pro::getTime());
+
+            pro::submitOffscreenToGraphicsQueue(vkInitData, cd);
+        }
+        vkInitData.device().waitIdle();
+
+        recordMs = recordSeconds / frameCnt * 1000.0f;
+        frameMs = pro::getElapsedSeconds(start, pro::getTime()) / frameCnt * 1000.0f;
+    };
+
+    cout << "** PARALLEL RECORD (" << frameCnt << " frames, " << drawsPerFrame << " draws/frame) **" << endl;
+
+    float recordMs = 0.0f, frameMs = 0.0f;
+    runFrames(0, recordMs, frameMs);
+    float serialMs = recordMs;
+    cout << "Primary only: record " << recordMs << " ms, frame " << frameMs << " ms" << endl;
+
+    for(unsigned int threadCnt = 1; threadCnt <= maxThreads; threadCnt++) {
+        runFrames(threadCnt, recordMs, frameMs);
+        cout << threadCnt << " thread(s): record " << recordMs << " ms (" 
+                << (serialMs / recordMs) << "x), frame " << frameMs << " ms" << endl;
+    }
+
+    pro::cleanupFrameCommandData(vkInitData, cd);
+    pro::cleanupVulkanImage(vkInitData, colorImage);
+    pro::cleanupAllVulkanDepthImages(vkInitData, allDepthImages);
+    pro::cleanupVulkanMesh(vkInitData, mesh);
+    pro::cleanupVulkanPipeline(vkInitData, pipelineData);
+    return 0;
+}
+
+// Recursive fork-join (each job spawns one half and works on the other); exercises stealing
+long long jobFib(pro::JobSystem &jobs, int n) {
+    if(n < 16) {
+        long long a = 0, b = 1;
+        for(int i = 0; i < n; i++) {
+            long long c = a + b;
+            a = b;
+            b = c;
+        }
+        return a;
+    }
+    long long x = 0;
+    pro::JobCounter counter {};
+    jobs.run([&]() { x = jobFib(jobs, n - 1); }, &counter);
+    long long y = jobFib(jobs, n - 2);
+    jobs.wait(counter);
+    return x + y;
+}
+
+// pro::JobSystem microbenchmarks for 1..N threads: cost per spawned (empty) job, 
+// parallelFor() vs. new threads per call on the same loop, and nested fork-join
+int benchJobs(GLFWwindow *window, int argc, char **argv) {
+    int jobCnt = (argc > 2) ? stoi(argv[2]) : 200000;
+    unsigned int maxThreads = (argc > 3) ? (unsigned int)stoi(argv[3]) : max(1u, thread::hardware_concurrency());
+
+    vector<float> values(1 << 22);
+    auto kernel = [&values](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            values[i] = sin(i * 0.001f) * cos(i * 0.002f);
+        }
+    };
+    int loopCnt = 20;
+
+    cout << "** JOBS (" << jobCnt << " empty jobs, " << values.size() << "-element loop x " << loopCnt << ") **" << endl;
+
+    float baseLoopMs = 0.0f;
+    for(unsigned int threadCnt = 1; threadCnt <= maxThreads; threadCnt++) {
+        pro::JobSystem jobs(threadCnt);
+
+        // Spawn + run + wait
+        atomic<int> hits = 0;
+        auto start = pro::getTime();
+        pro::JobCounter counter {};
+        for(int i = 0; i < jobCnt; i++) {
+            jobs.run([&hits]() { hits.fetch_add(1, memory_order_relaxed); }, &counter);
+        }
+        jobs.wait(counter);
+        float spawnNs = pro::getElapsedSeconds(start, pro::getTime()) * 1.0e9f / jobCnt;
+
+        start = pro::getTime();
+        for(int i = 0; i < loopCnt; i++) {
+            jobs.parallelFor(values.size(), kernel);
+        }
+        float loopMs = pro::getElapsedSeconds(start, pro::getTime()) * 1000.0f / loopCnt;
+        if(threadCnt == 1) {
+            baseLoopMs = loopMs;
+        }
+
+        // What the job system replaces: start (and join) threads for every loop
+        start = pro::getTime();
+        for(int i = 0; i < loopCnt; i++) {
+            vector<thread> allThreads {};
+            for(unsigned int t = 1; t < threadCnt; t++) {
+                allThreads.emplace_back(kernel, values.size() * t / threadCnt, values.size() * (t + 1) / threadCnt);
+            }
+            kernel(0, values.size() / threadCnt);
+            for(auto &t : allThreads) {
+                t.join();
+            }
+        }
+        float adhocMs = pro::getElapsedSeconds(start, pro::getTime()) * 1000.0f / loopCnt;
+
+        start = pro::getTime();
+        long long fib = jobFib(jobs, 32);
+        float fibMs = pro::getElapsedSeconds(start, pro::getTime()) * 1000.0f;
+
+        cout << threadCnt << " thread(s): spawn " << spawnNs << " ns/job"
+                << ", parallelFor " << loopMs << " ms (" << (baseLoopMs / loopMs) << "x)"
+                << ", new threads " << adhocMs << " ms"
+                << ", fork-join fib(32) " << fibMs << " ms" 
+                << ((hits == jobCnt && fib == 2178309) ? "" : " [WRONG RESULT]") << endl;
+    }
+    return 0;
+}
+
+// Frustum culling of many random objects (pro::cullFrustum()): scalar reference vs. SIMD path for each test,
+// then the SIMD path split over a pro::JobSystem
+int benchCull(GLFWwindow *window, int argc, char **argv) {
+    size_t objectCnt = (argc > 2) ? (size_t)stoull(argv[2]) : 100000;
+    int iterCnt = (argc > 3) ? stoi(argv[3]) : 100;
+
+    // Unit cube, scattered in a 200 x 200 x 200 volume with random scales
+    pro::MeshBounds cube {};
+    cube.minPos = glm::vec3(-0.5f);
+    cube.maxPos = glm::vec3(0.5f);
+    cube.center = glm::vec3(0.0f);
+    cube.radius = glm::length(glm::vec3(0.5f));
+
+    mt19937 rng(42);
+    uniform_real_distribution<float> posDist(-100.0f, 100.0f);
+    uniform_real_distribution<float> scaleDist(0.5f, 4.0f);
+    pro::BoundsSoA bounds {};
+    bounds.reserve(objectCnt);
+    for(size_t i = 0; i < objectCnt; i++) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(posDist(rng), posDist(rng), posDist(rng)));
+        model = glm::scale(model, glm::vec3(scaleDist(rng), scaleDist(rng), scaleDist(rng)));
+        bounds.add(cube, model);
+    }
+
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.2f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    pro::Frustum frustum = pro::extractFrustum(proj * view, false);     // glm::perspective() is OpenGL-style depth
+
+    #if defined(PRO_USE_AVX)
+        string simdName = "AVX";
+    #elif defined(PRO_USE_SSE2)
+        string simdName = "SSE2";
+    #else
+        string simdName = "scalar (no SIMD)";
+    #endif
+    cout << "** CULL (" << objectCnt << " objects, " << iterCnt << " iterations, " << simdName << ") **" << endl;
+
+    vector<pair<string, pro::CULL_TEST>> allTests = {
+        { "Sphere", pro::CULL_SPHERE },
+        { "AABB", pro::CULL_AABB },
+        { "Sphere+AABB", pro::CULL_SPHERE_AND_AABB }
+    };
+
+    vector<uint32_t> visible {};
+    visible.reserve(objectCnt);
+    for(auto &[name, test] : allTests) {
+        auto start = pro::getTime();
+        for(int k = 0; k < iterCnt; k++) {
+            visible.clear();
+            for(size_t i = 0; i < bounds.size(); i++) {
+                if(pro::isInFrustum(frustum, bounds, i, test)) {
+                    visible.push_back((uint32_t)i);
+                }
+            }
+        }
+        float scalarMs = pro::getElapsedSeconds(start, pro::getTime()) * 1000.0f / iterCnt;
+        vector<uint32_t> reference = visible;
+
+        start = pro::getTime();
+        for(int k = 0; k < iterCnt; k++) {
+            visible.clear();
+            pro::cullFrustum(frustum, bounds, visible, test);
+        }
+        float simdMs = pro::getElapsedSeconds(start, pro::getTime()) * 1000.0f / iterCnt;
+
+        cout << name << ": " << visible.size() << " visible, scalar " << scalarMs << " ms, cullFrustum "
+                << simdMs << " ms (" << (scalarMs / simdMs) << "x)"
+                << ((visible == reference) ? "" : " [MISMATCH]") << endl;
+    }
+
+    // One visible list per chunk, concatenated afterwards (keeps the order)
+    unsigned int threadCnt = max(1u, thread::hardware_concurrency());
+    pro::JobSystem jobs(threadCnt);
+    size_t chunkCnt = threadCnt * 4;
+    size_t chunkSize = ((bounds.size() + chunkCnt - 1) / chunkCnt + 7) & ~size_t(7);
+    vector<vector<uint32_t>> allChunkVisible(chunkCnt);
+
+    auto start = pro::getTime();
+    for(int k = 0; k < iterCnt; k++) {
+        jobs.parallelFor(chunkCnt, [&](size_t begin, size_t end) {
+            for(size_t c = begin; c < end; c++) {
+                allChunkVisible[c].clear();
+                pro::cullFrustum(frustum, bounds, allChunkVisible[c], pro::CULL_SPHERE_AND_AABB,
+                                    c * chunkSize, (c + 1) * chunkSize);
+            }
+        }, 1);
+        visible.clear();
+        for(auto &chunk : allChunkVisible) {
+            visible.insert(visible.end(), chunk.begin(), chunk.end());
+        }
+    }
+    float jobsMs = pro::getElapsedSeconds(start, pro::getTime()) * 1000.0f / iterCnt;
+    cout << "Sphere+AABB on " << threadCnt << " thread(s): " << visible.size() << " visible, " << jobsMs << " ms" << endl;
+
+    return 0;
+}
+
+// Many small objects in ONE shared mesh: CPU culling (pro::cullFrustum()) + one drawIndexed() per visible object
+// vs. GPU-driven (pro::GPUCuller: compute culling + one drawIndexedIndirectCount())
+int benchIndirect(GLFWwindow *window, int argc, char **argv) {
+    uint32_t objectCnt = (argc > 2) ? (uint32_t)stoul(argv[2]) : 100000;
+    int frameCnt = (argc > 3) ? stoi(argv[3]) : 200;
+
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    createInfo.reqFeatures12.drawIndirectCount = true;
+    pro::VulkanInitData vkInitData(createInfo);
+
+    pro::VulkanPipelineCreateInfo pipelineCreateInfo = makeBenchPipelineCreateInfo(vkInitData);
+    pro::VulkanPipelineData pipelineData = pro::createVulkanPipeline(vkInitData, pipelineCreateInfo);
+
+    // Small quads scattered over [-2, 2] in clip space (so roughly a quarter are visible)
+    mt19937 rng(7);
+    uniform_real_distribution<float> posDist(-2.0f, 2.0f);
+    pro::HostMesh<ProVertex> quad = makeQuad();
+    pro::HostMesh<ProVertex> scene {};
+    for(uint32_t i = 0; i < objectCnt; i++) {
+        glm::vec3 offset(posDist(rng), posDist(rng), 0.0f);
+        for(auto v : quad.vertices) {
+            v.pos = v.pos * 0.02f + offset;
+            v.pos.z = 0.5f;
+            scene.vertices.push_back(v);
+        }
+        scene.indices.insert(scene.indices.end(), quad.indices.begin(), quad.indices.end());
+    }
+    pro::narrowHostMeshIndices(scene);
+    pro::VulkanMesh sceneMesh = pro::createVulkanMesh(vkInitData, scene, false);
+    pro::copyToHostVisibleVulkanMesh(vkInitData, sceneMesh, scene);
+
+    // One view per object into the shared buffers
+    vector<pro::VulkanMesh> allObjects(objectCnt);
+    vector<pro::GPUDrawObject> allGPUObjects(objectCnt);
+    pro::BoundsSoA bounds {};
+    bounds.reserve(objectCnt);
+    for(uint32_t i = 0; i < objectCnt; i++) {
+        pro::VulkanMesh &object = allObjects[i];
+        object = sceneMesh;
+        object.ownsBuffers = false;
+        object.indexCnt = (unsigned int)quad.indices.size();
+        object.firstIndex = i * (uint32_t)quad.indices.size();
+        object.vertexOffset = (int32_t)(i * quad.vertices.size());
+        object.bounds = pro::computeMeshBounds(&scene.vertices[object.vertexOffset], quad.vertices.size());
+        bounds.add(object.bounds);
+        allGPUObjects[i] = pro::makeGPUDrawObject(object, glm::mat4(1.0f), i);
+    }
+
+    // The vertex shader outputs clip space directly
+    pro::Frustum frustum = pro::extractFrustum(glm::mat4(1.0f));
+
+    pro::GPUCuller culler(vkInitData, "build/compiledshaders/" + appName + "/cull.comp.spv", objectCnt, 1);
+    culler.setObjects(0, allGPUObjects);
+
+    vector<pro::VulkanImage> allDepthImages {};
+    pro::recreateAllVulkanDepthImages(vkInitData, allDepthImages, 1);
+    pro::VulkanImage colorImage = pro::createOffscreenColorImage(vkInitData);
+    pro::FrameCommandData cd = pro::createFrameCommandData(vkInitData);
+
+    vector<uint32_t> visible {};
+    auto runFrames = [&](bool gpuDriven, float &recordMs, float &frameMs) {
+        float recordSeconds = 0.0f;
+        auto start = pro::getTime();
+        for(int f = 0; f < frameCnt; f++) {
+            vkInitData.device().waitForFences(cd.inFlight, true, UINT64_MAX);
+            vkInitData.device().resetFences(cd.inFlight);
+
+            auto startRecord = pro::getTime();
+            vkInitData.device().resetCommandPool(cd.commandPool);
+            cd.commandBuffer.begin(vk::CommandBufferBeginInfo());
+            if(gpuDriven) {
+                culler.recordCull(cd.commandBuffer, 0, frustum);
+            }
+            else {
+                visible.clear();
+                pro::cullFrustum(frustum, bounds, visible);
+            }
+            pro::performVulkanImageTransition(cd.commandBuffer, colorImage.image, pro::IMAGE_TRANSITION_TYPE::UNDEF_TO_COLOR);
+
+            vk::RenderingAttachmentInfoKHR colorAtt = pro::createColorAttachment(
+                colorImage.view, vk::ClearColorValue {0.0f, 1.0f, 1.0f, 1.0f});
+            vk::RenderingAttachmentInfoKHR depthAtt = pro::createDepthAttachment(allDepthImages[0].view);
+            vk::RenderingInfoKHR ri{};
+            ri.setRenderArea(vk::Rect2D{ {0,0}, vkInitData.swapchain().extent })
+                .setLayerCount(1)
+                .setColorAttachments(colorAtt)
+                .setPDepthAttachment(&depthAtt);
+            cd.commandBuffer.beginRendering(ri);
+
+            cd.commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipelineData.pipeline);
+            vk::Viewport viewports[] = { pro::makeDefaultViewport(vkInitData) };    
+            cd.commandBuffer.setViewport(0, viewports);
+            vk::Rect2D scissors[] = { pro::makeDefaultScissors(vkInitData) };
+            cd.commandBuffer.setScissor(0, scissors);
+
+            if(gpuDriven) {
+                culler.recordDraw(cd.commandBuffer, 0, sceneMesh);
+            }
+            else {
+                pro::VulkanMeshBindState bindState {};
+                for(uint32_t index : visible) {
+                    pro::recordDrawVulkanMesh(cd.commandBuffer, allObjects[index], bindState);
+                }
+            }
+            cd.commandBuffer.endRendering();
+
+            pro::performVulkanImageTransition(cd.commandBuffer, colorImage.image, pro::IMAGE_TRANSITION_TYPE::COLOR_TO_TRANSFER_SRC);
+            cd.commandBuffer.end();
+            recordSeconds += pro::getElapsedSeconds(startRecord, pro::getTime());
+
+            pro::submitOffscreenToGraphicsQueue(vkInitData, cd);
+        }
+        vkInitData.device().waitIdle();
+
+        recordMs = recordSeconds / frameCnt * 1000.0f;
+        frameMs = pro::getElapsedSeconds(start, pro::getTime()) / frameCnt * 1000.0f;
+    };
+
+    cout << "** INDIRECT (" << objectCnt << " objects, " << frameCnt << " frames) **" << endl;
+
+    float recordMs = 0.0f, frameMs = 0.0f;
+    runFrames(false, recordMs, frameMs);
+    cout << "CPU cull + drawIndexed (" << visible.size() << " draws): record " << recordMs << " ms, frame " << frameMs << " ms" << endl;
+    runFrames(true, recordMs, frameMs);
+    cout << "GPU cull + drawIndexedIndirectCount: record " << recordMs << " ms, frame " << frameMs << " ms" << endl;
+
+    pro::cleanupFrameCommandData(vkInitData, cd);
+    pro::cleanupVulkanImage(vkInitData, colorImage);
+    pro::cleanupAllVulkanDepthImages(vkInitData, allDepthImages);
+    pro::cleanupVulkanMesh(vkInitData, sceneMesh);
+    pro::cleanupVulkanPipeline(vkInitData, pipelineData);
+    return 0;
+}
+
+// Compute bandwidth (GPU timestamps): vkCmdCopyBuffer vs. a copy shader vs. a reduction shader over the same buffer,
+// then the reduction on the compute queue (pro::AsyncCompute) handed to graphics through a timeline semaphore
+int benchCompute(GLFWwindow *window, int argc, char **argv) {
+    vk::DeviceSize sizeMB = (argc > 2) ? stoull(argv[2]) : 64;
+    int iterCnt = (argc > 3) ? stoi(argv[3]) : 50;
+    vk::DeviceSize size = sizeMB * 1024 * 1024;
+    uint32_t vec4Cnt = (uint32_t)(size / 16);
+    uint32_t fillValue = 3;
+    uint32_t expectedTotal = (uint32_t)((size / 4) * fillValue);
+
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    pro::VulkanInitData vkInitData(createInfo);
+
+    // Buffers
+    pro::VulkanBuffer srcBuffer = pro::createVulkanBuffer(vkInitData, size, 
+                                    vk::BufferUsageFlagBits::eStorageBuffer 
+                                        | vk::BufferUsageFlagBits::eTransferSrc 
+                                        | vk::BufferUsageFlagBits::eTransferDst,
+                                    pro::createVMADeviceLocalInfo());
+    pro::VulkanBuffer dstBuffer = pro::createVulkanBuffer(vkInitData, size, 
+                                    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                    pro::createVMADeviceLocalInfo());
+    pro::VulkanBuffer resultBuffer = pro::createVulkanBuffer(vkInitData, sizeof(uint32_t), 
+                                    vk::BufferUsageFlagBits::eStorageBuffer 
+                                        | vk::BufferUsageFlagBits::eTransferSrc 
+                                        | vk::BufferUsageFlagBits::eTransferDst,
+                                    pro::createVMADeviceLocalInfo());
+    pro::VulkanBuffer readbackBuffer = pro::createVulkanBuffer(vkInitData, sizeof(uint32_t), 
+                                    vk::BufferUsageFlagBits::eTransferDst,
+                                    pro::createVMAHostVisibleInfo());
+
+    // Both shaders: two storage buffers + the element count
+    auto makeComputePipeline = [&](const string &shaderName) {
+        vector<vk::DescriptorSetLayoutBinding> allBindings = {
+            vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+            vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute)
+        };
+        pro::VulkanComputePipelineCreateInfo pipelineCreateInfo("build/compiledshaders/" + appName + "/" + shaderName);
+        pipelineCreateInfo.allDescSetLayouts = { vkInitData.device().createDescriptorSetLayout(
+                                                    vk::DescriptorSetLayoutCreateInfo({}, allBindings)) };
+        pipelineCreateInfo.pushConstantRanges = { vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t)) };
+        return pro::createVulkanComputePipeline(vkInitData, pipelineCreateInfo);
+    };
+    pro::VulkanPipelineData copyPipeline = makeComputePipeline("copy.comp.spv");
+    pro::VulkanPipelineData reducePipeline = makeComputePipeline("reduce.comp.spv");
+
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, 4);
+    vk::DescriptorPool descPool = vkInitData.device().createDescriptorPool(vk::DescriptorPoolCreateInfo({}, 2, poolSize));
+    auto makeDescSet = [&](pro::VulkanPipelineData &pipelineData, pro::VulkanBuffer &b0, pro::VulkanBuffer &b1) {
+        vk::DescriptorSet descSet = vkInitData.device().allocateDescriptorSets(
+                                        vk::DescriptorSetAllocateInfo(descPool, pipelineData.allDescSetLayouts)).front();
+        vk::DescriptorBufferInfo allBufferInfo[] = {
+            vk::DescriptorBufferInfo(b0.buffer, 0, VK_WHOLE_SIZE),
+            vk::DescriptorBufferInfo(b1.buffer, 0, VK_WHOLE_SIZE)
+        };
+        vector<vk::WriteDescriptorSet> allWrites = {
+            vk::WriteDescriptorSet(descSet, 0, 0, vk::DescriptorType::eStorageBuffer, {}, allBufferInfo[0]),
+            vk::WriteDescriptorSet(descSet, 1, 0, vk::DescriptorType::eStorageBuffer, {}, allBufferInfo[1])
+        };
+        vkInitData.device().updateDescriptorSets(allWrites, {});
+        return descSet;
+    };
+    vk::DescriptorSet copySet = makeDescSet(copyPipeline, srcBuffer, dstBuffer);
+    vk::DescriptorSet reduceSet = makeDescSet(reducePipeline, srcBuffer, resultBuffer);
+
+    // Enough groups to fill the GPU; the shaders loop over the rest
+    uint32_t groupCnt = min(pro::getDispatchGroupCount(vec4Cnt, 256), 4096u);
+    
+    auto recordReduce = [&](vk::CommandBuffer &cmd) {
+        cmd.fillBuffer(resultBuffer.buffer, 0, sizeof(uint32_t), 0);
+        vk::MemoryBarrier resetBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, resetBarrier, {}, {});
+        pro::recordDispatchCompute(cmd, reducePipeline, groupCnt, 1, 1, { reduceSet }, &vec4Cnt, sizeof(uint32_t));
+    };
+
+    auto readResult = [&]() {
+        vmaInvalidateAllocation(vkInitData.allocator(), readbackBuffer.allocation, 0, VK_WHOLE_SIZE);
+        return *(uint32_t*)readbackBuffer.mapped;
+    };
+
+    cout << "** COMPUTE (" << sizeMB << " MB, " << iterCnt << " iterations) **" << endl;
+
+    // Fill the source once
+    pro::FrameCommandData cd = pro::createFrameCommandData(vkInitData, 16);
+    vkInitData.device().waitForFences(cd.inFlight, true, UINT64_MAX);
+    vkInitData.device().resetFences(cd.inFlight);
+    cd.commandBuffer.begin(vk::CommandBufferBeginInfo());
+    cd.commandBuffer.fillBuffer(srcBuffer.buffer, 0, VK_WHOLE_SIZE, fillValue);
+    vk::MemoryBarrier fillBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eShaderRead);
+    cd.commandBuffer.pipelineBarrier(   vk::PipelineStageFlagBits::eTransfer, 
+                                        vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, 
+                                        {}, fillBarrier, {}, {});
+    cd.commandBuffer.end();
+    pro::submitOffscreenToGraphicsQueue(vkInitData, cd);
+
+    // 1) Everything on the graphics queue, timed per scope
+    pro::GPUProfiler profiler(vkInitData);
+    for(int i = 0; i <= iterCnt; i++) {
+        vkInitData.device().waitForFences(cd.inFlight, true, UINT64_MAX);
+        vkInitData.device().resetFences(cd.inFlight);
+        vkInitData.device().resetCommandPool(cd.commandPool);
+        cd.commandBuffer.begin(vk::CommandBufferBeginInfo());
+        profiler.beginFrame(cd);
+
+        // (The extra last frame only collects the previous one's timestamps)
+        if(i < iterCnt) {
+            vk::MemoryBarrier barrier(  vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite,
+                                        vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+            vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader;
+
+            profiler.beginScope("copyBuffer");
+            vk::BufferCopy region(0, 0, size);
+            cd.commandBuffer.copyBuffer(srcBuffer.buffer, dstBuffer.buffer, region);
+            profiler.endScope();
+            cd.commandBuffer.pipelineBarrier(stages, stages, {}, barrier, {}, {});
+
+            profiler.beginScope("copy.comp");
+            pro::recordDispatchCompute(cd.commandBuffer, copyPipeline, groupCnt, 1, 1, { copySet }, &vec4Cnt, sizeof(uint32_t));
+            profiler.endScope();
+            cd.commandBuffer.pipelineBarrier(stages, stages, {}, barrier, {}, {});
+
+            profiler.beginScope("reduce.comp");
+            recordReduce(cd.commandBuffer);
+            profiler.endScope();
+        }
+
+        cd.commandBuffer.end();
+        pro::submitOffscreenToGraphicsQueue(vkInitData, cd);
+    }
+    vkInitData.device().waitIdle();
+
+    for(auto &stats : profiler.getStats()) {
+        // Copies read and write every byte; the reduction only reads
+        double bytes = (stats.name == "reduce.comp") ? (double)size : 2.0 * size;
+        cout << stats.name << ": avg " << stats.avgMs << " ms, min " << stats.minMs << " ms ("
+                << (bytes / (stats.minMs * 1.0e6)) << " GB/s at min)" << endl;
+    }
+
+    // 2) Reduction on the compute queue; graphics waits on the timeline and reads back the result
+    pro::AsyncCompute compute(vkInitData, 1);
+
+    // Refill the source on the compute queue (it belongs to the graphics queue family so far)
+    vk::CommandBuffer &fillBuffer = compute.begin(0);
+    fillBuffer.fillBuffer(srcBuffer.buffer, 0, VK_WHOLE_SIZE, fillValue);
+    fillBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, fillBarrier, {}, {});
+    compute.submit(0);
+
+    bool isCorrect = true;
+    auto start = pro::getTime();
+    for(int i = 0; i < iterCnt; i++) {
+        vkInitData.device().waitForFences(cd.inFlight, true, UINT64_MAX);
+        if(i > 0) {
+            isCorrect = isCorrect && (readResult() == expectedTotal);
+        }
+        vkInitData.device().resetFences(cd.inFlight);
+
+        vk::CommandBuffer &computeBuffer = compute.begin(0);
+        recordReduce(computeBuffer);
+        compute.releaseBuffer(resultBuffer, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
+        pro::TimelineWait computeDone = compute.submit(0);
+
+        vkInitData.device().resetCommandPool(cd.commandPool);
+        cd.commandBuffer.begin(vk::CommandBufferBeginInfo());
+        compute.recordAcquireBarriers(cd.commandBuffer);
+        vk::BufferCopy region(0, 0, sizeof(uint32_t));
+        cd.commandBuffer.copyBuffer(resultBuffer.buffer, readbackBuffer.buffer, region);
+        vk::MemoryBarrier hostBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead);
+        cd.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, hostBarrier, {}, {});
+        cd.commandBuffer.end();
+        pro::submitOffscreenToGraphicsQueue(vkInitData, cd, { computeDone });
+    }
+    vkInitData.device().waitForFences(cd.inFlight, true, UINT64_MAX);
+    isCorrect = isCorrect && (readResult() == expectedTotal);
+    float asyncMs = pro::getElapsedSeconds(start, pro::getTime()) * 1000.0f / iterCnt;
+
+    cout << "reduce.comp on " << (compute.isAsync() ? "dedicated compute queue" : "graphics queue (no separate compute queue)")
+            << " + graphics readback: " << asyncMs << " ms per round trip"
+            << (isCorrect ? "" : " [WRONG RESULT]") << endl;
+
+    vkInitData.device().waitIdle();
+    pro::cleanupFrameCommandData(vkInitData, cd);
+    vkInitData.device().destroyDescriptorPool(descPool);
+    pro::cleanupVulkanPipeline(vkInitData, copyPipeline);
+    pro::cleanupVulkanPipeline(vkInitData, reducePipeline);
+    pro::cleanupVulkanBuffer(vkInitData, srcBuffer);
+    pro::cleanupVulkanBuffer(vkInitData, dstBuffer);
+    pro::cleanupVulkanBuffer(vkInitData, resultBuffer);
+    pro::cleanupVulkanBuffer(vkInitData, readbackBuffer);
+    return isCorrect ? 0 : 1;
+}
+
+// Compiles many pipeline permutations (cull mode, winding, depth test, blending) one after another
+// on the calling thread vs. with pro::PipelineCompiler on 1..maxThreads job threads;
+// also reports the cost of the fallback pipeline (built on the calling thread) and how many others were ready right away.
+// Every run uses a different depth bias, so no run gets exact hits from an earlier run in the pipeline cache
+// (drivers' own shader caches may still shrink the difference; see pipelinecache).
+int benchPipelineCompiler(GLFWwindow *window, int argc, char **argv) {
+    int permutationCnt = (argc > 2) ? stoi(argv[2]) : 96;
+    unsigned int maxThreads = (argc > 3) ? (unsigned int)stoi(argv[3]) : max(1u, thread::hardware_concurrency());
+
+    pro::VulkanInitCreateInfo createInfo = makeBenchInitCreateInfo(window);
+    pro::VulkanInitData vkInitData(createInfo);
+    pro::VulkanPipelineCreateInfo pipelineCreateInfo = makeBenchPipelineCreateInfo(vkInitData);
+
+    vector<vk::CullModeFlagBits> allCullModes = { 
+        vk::CullModeFlagBits::eNone, vk::CullModeFlagBits::eBack, vk::CullModeFlagBits::eFront };
+    vector<vk::CompareOp> allCompareOps = {
+        vk::CompareOp::eLess, vk::CompareOp::eLessOrEqual, vk::CompareOp::eGreater, vk::CompareOp::eGreaterOrEqual,
+        vk::CompareOp::eEqual, vk::CompareOp::eNotEqual, vk::CompareOp::eAlways, vk::CompareOp::eNever };
+
+    // Permutation i of run (modifies pipelineCreateInfo in place)
+    auto setPermutation = [&](int i, int run) {
+        pipelineCreateInfo.rasterizerInfo.cullMode = allCullModes[i % allCullModes.size()];
+        i /= (int)allCullModes.size();
+        pipelineCreateInfo.rasterizerInfo.frontFace = (i % 2) ? vk::FrontFace::eClockwise : vk::FrontFace::eCounterClockwise;
+        i /= 2;
+        pipelineCreateInfo.depthStencilInfo.depthCompareOp = allCompareOps[i % allCompareOps.size()];
+        i /= (int)allCompareOps.size();
+        pipelineCreateInfo.colorBlendAttachment.blendEnable = (i % 2) == 1;
+        pipelineCreateInfo.colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+        pipelineCreateInfo.colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+        i /= 2;
+        pipelineCreateInfo.rasterizerInfo.depthBiasEnable = true;
+        pipelineCreateInfo.rasterizerInfo.depthBiasConstantFactor = (float)(run * 1000 + i);
+    };
+
+    cout << "** PIPELINE COMPILER (" << permutationCnt << " permutations) **" << endl;
+
+    // One after another, like createVulkanPipeline() at startup
+    int run = 0;
+    vector<pro::VulkanPipelineData> allSerial {};
+    auto start = pro::getTime();
+    for(int i = 0; i < permutationCnt; i++) {
+        setPermutation(i, run);
+        allSerial.push_back(pro::createVulkanPipeline(vkInitData, pipelineCreateInfo));
+    }
+    float serialMs = pro::getElapsedSeconds(start, pro::getTime()) * 1000.0f;
+    for(auto &data : allSerial) {
+        pro::cleanupVulkanPipelineOnly(vkInitData, data);
+    }
+    cout << "Serial: " << serialMs << " ms (" << (serialMs / permutationCnt) << " ms per pipeline)" << endl;
+
+    vector<unsigned int> allThreadCnts {};
+    for(unsigned int threadCnt = 1; threadCnt < maxThreads; threadCnt *= 2) {
+        allThreadCnts.push_back(threadCnt);
+    }
+    allThreadCnts.push_back(maxThreads);
+
+    for(unsigned int threadCnt : allThreadCnts) {
+        run++;
+        pro::JobSystem jobs(threadCnt);
+        pro::PipelineCompiler compiler(vkInitData, jobs);
+
+        // Fallback first, on this thread (usable from the first frame on)
+        start = pro::getTime();
+        setPermutation(0, run);
+        size_t fallbackID = compiler.addFallback(pipelineCreateInfo);
+        vk::Pipeline fallback = compiler.get(fallbackID, fallbackID).pipeline;
+        float fallbackMs = pro::getElapsedSeconds(start, pro::getTime()) * 1000.0f;
+
+        auto startSubmit = pro::getTime();
+        vector<size_t> allIDs {};
+        for(int i = 1; i < permutationCnt; i++) {
+            setPermutation(i, run);
+            allIDs.push_back(compiler.submit(pipelineCreateInfo));
+        }
+        float submitMs = pro::getElapsedSeconds(startSubmit, pro::getTime()) * 1000.0f;
+
+        // Like a render loop that draws with whatever is ready (get() never blocks)
+        size_t readyCnt = 0;
+        for(size_t id : allIDs) {
+            readyCnt += (compiler.get(id, fallbackID).pipeline != fallback) ? 1 : 0;
+        }
+
+        compiler.waitAll();
+        float allMs = pro::getElapsedSeconds(start, pro::getTime()) * 1000.0f;
+
+        float compileMs = compiler.getCompileSeconds(fallbackID) * 1000.0f;
+        for(size_t id : allIDs) {
+            compileMs += compiler.getCompileSeconds(id) * 1000.0f;
+        }
+
+        cout << threadCnt << " thread(s): fallback " << fallbackMs << " ms, submit " << submitMs << " ms"
+                << " (" << readyCnt << " others ready right after), all ready " << allMs << " ms"
+                << " (" << (serialMs / allMs) << "x), " << (compileMs / permutationCnt) << " ms per pipeline" << endl;
+        // compiler destroys its pipelines here
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// MAIN FUNCTION
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv) {
+    map<string, BenchFunc> allBenchmarks = {
+        { "pipelinecache", benchPipelineCache },
+        { "framering", benchFrameRing },
+        { "transfer", benchTransfer },
+        { "offscreen", benchOffscreen },
+        { "objload", benchOBJLoad },
+        { "meshcache", benchMeshCache },
+        { "meshopt", benchMeshOpt },
+        { "vertexpack", benchVertexPack },
+        { "texture", benchTexture },
+        { "texcompress", benchTexCompress },
+        { "streaming", benchStreaming },
+        { "cpuprofile", benchCPUProfile },
+        { "parallelrecord", benchParallelRecord },
+        { "jobs", benchJobs },
+        { "cull", benchCull },
+        { "indirect", benchIndirect },
+        { "compute", benchCompute },
+        { "pipelinecompiler", benchPipelineCompiler }
+    };
+
+    // Pull out "--headless" (no GLFW at all; works without a display)
+    bool headless = false;
+    vector<char*> args {};
+    for(int i = 0; i < argc; i++) {
+        if(string(argv[i]) == "--headless") {
+            headless = true;
+        }
+        else {
+            args.push_back(argv[i]);
+        }
+    }
+    argc = (int)args.size();
+    argv = args.data();
+
+    if(argc < 2 || !allBenchmarks.contains(argv[1])) {
+        cout << "Usage: " << appName << " [--headless] <benchmark> [args...]" << endl;
+        cout << "Available benchmarks:" << endl;
+        for(auto &bench : allBenchmarks) {
+            cout << "\t" << bench.first << endl;
+        }
+        return 1;
+    }
+
+    if(headless) {
+        return allBenchmarks[argv[1]](nullptr, argc, argv);
+    }
+
+    // Initialize GLFW (hidden window; we only need a surface)
+    if(!glfwInit()) {
+        cerr << "ERROR: Cannot start GLFW!" << endl;
+        exit(1);
+    }
+    
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_VISIBLE, false);
+    GLFWwindow *window = glfwCreateWindow(800, 600, appName.c_str(), nullptr, nullptr);
+    if(!window) {
+        cerr << "ERROR: Cannot create GLFW window!" << endl;
+        glfwTerminate();
+        exit(1);
+    }
+
+    // Run benchmark
+    int exitCode = allBenchmarks[argv[1]](window, argc, argv);
+
+    glfwDestroyWindow(window);
+    glfwTerminate();   
+
+    return exitCode;
+}
@@ -66,7 +66,9 @@ void recordFrame(   pro::VulkanInitData &vkInitData,
                     const pro::VulkanSwapImage &swapImage,
                     const pro::VulkanImage &depthImage,
                     pro::VulkanPipelineData &pipelineData,
-                    vector<pro::VulkanMesh> allMeshes) {
+                    vector<pro::VulkanMesh> allMeshes,
+                    const vector<uint32_t> &visible) {
+    PRO_PROFILE_SCOPE("recordFrame");
 
     // Reset our command pool so it's cleared and ready to go
     vkInitData.device().resetCommandPool(cd.commandPool);
@@ -104,9 +106,9 @@ void recordFrame(   pro::VulkanInitData &vkInitData,
     vk::Rect2D scissors[] = { pro::makeDefaultScissors(vkInitData) };
     cd.commandBuffer.setScissor(0, scissors);
 
-    // FOR NOW, just render all meshes
-    for(auto &mesh : allMeshes) {
-        pro::recordDrawVulkanMesh(cd.commandBuffer, mesh);
+    // Render only the meshes that survived culling
+    for(uint32_t index : visible) {
+        pro::recordDrawVulkanMesh(cd.commandBuffer, allMeshes[index]);
     }
     
     // End rendering
@@ -190,13 +192,16 @@ int main(int argc, char **argv) {
         pro::printPhysicalDeviceProperties(vkInitData.physicalDevice());
         vkInitData.printQueues();
 
-        // Create depth image(s)
-        vector<pro::VulkanImage> allDepthImages {};
-        int numberOfFramesInFlight = 1;
-        pro::recreateAllVulkanDepthImages(vkInitData, allDepthImages, numberOfFramesInFlight);
+        ///////////////////////////////////////////////////////////////////////
+        // VULKAN COMMAND DATA
+        ///////////////////////////////////////////////////////////////////////
+
+        // Create command data and depth image(s) for each frame-in-flight
+        int numberOfFramesInFlight = 2;
+        pro::FrameRing frameRing(vkInitData, numberOfFramesInFlight);
         
         // Define resize function
-        pro::OnResizeFunc resizeFunc = [&vkInitData, window, &allDepthImages, numberOfFramesInFlight]() {            
+        pro::OnResizeFunc resizeFunc = [&vkInitData, window, &frameRing]() {            
             int width = 0;
             int height = 0;
 
@@ -208,18 +213,11 @@ int main(int argc, char **argv) {
         
             // Safe to recreate
             vkInitData.recreateVulkanSwapchain();
-            recreateAllVulkanDepthImages(vkInitData, allDepthImages, numberOfFramesInFlight);
+            frameRing.recreateDepthImages();
 
             cout << "Swapchain recreated..." << endl;
         };
 
-        ///////////////////////////////////////////////////////////////////////
-        // VULKAN COMMAND DATA
-        ///////////////////////////////////////////////////////////////////////
-
-        // Create command data
-        pro::FrameCommandData commandData = pro::createFrameCommandData(vkInitData);
-
         ///////////////////////////////////////////////////////////////////////
         // VULKAN GRAPHICS PIPELINE
         ///////////////////////////////////////////////////////////////////////
@@ -260,8 +258,10 @@ int main(int argc, char **argv) {
             offsetof(ProVertex, color) // offset
         ));
 
-        // Actually create the pipeline data
-        pro::VulkanPipelineData pipelineData = createVulkanPipeline(vkInitData, pipelineCreateInfo);
+        // Actually create the pipeline data (rebuilt whenever its shaders change)
+        pro::ShaderHotReloader hotReloader(vkInitData, numberOfFramesInFlight, PRO_GLSLC);
+        size_t pipelineID = hotReloader.addPipeline(pipelineCreateInfo);
+        hotReloader.addShaderSourceDirectory(PRO_SHADER_SOURCE_DIR, "build/compiledshaders/" + appName);
 
         ///////////////////////////////////////////////////////////////////////
         // MESH CREATION
@@ -278,22 +278,32 @@ int main(int argc, char **argv) {
             {{-0.5f, 0.5f, 0.5f},   {1,1,1,1}}
         };
         simpleQuad.indices = { 0, 1, 2, 0, 2, 3 };        
+        pro::narrowHostMeshIndices(simpleQuad);
         allHostMeshes.push_back(simpleQuad);
 
         // Create the Vulkan meshes
         vector<pro::VulkanMesh> allMeshes {};    
         allMeshes.resize(allHostMeshes.size());       
         for(unsigned int i = 0; i < allMeshes.size(); i++) {
-            allMeshes[i] = pro::createVulkanMesh(vkInitData, simpleQuad, false);
+            allMeshes[i] = pro::createVulkanMesh(vkInitData, allHostMeshes[i], false);
             pro::copyToHostVisibleVulkanMesh(vkInitData, allMeshes[i], allHostMeshes[i]);            
         }
 
+        // Bounds for frustum culling (meshes are not transformed, so the model matrix is identity)
+        pro::BoundsSoA allBounds {};
+        for(auto &mesh : allMeshes) {
+            allBounds.add(mesh.bounds);
+        }
+        vector<uint32_t> visible {};
+
         ///////////////////////////////////////////////////////////////////////
         // MAIN RENDER LOOP
         ///////////////////////////////////////////////////////////////////////
         
         // While the window is still open...
         while (!glfwWindowShouldClose(window)) { 
+            PRO_PROFILE_SCOPE("frame");
+
             // Check for window/keyboard/mouse events...	
             glfwPollEvents();	
 
@@ -303,26 +313,33 @@ int main(int argc, char **argv) {
                 resizeFunc();
             }
 
-            // Set frame-in-flight index (only one for now)
-            unsigned int indexFlight = 0;
+            // Cull (the vertex shader outputs clip space directly, so view-projection is identity)
+            visible.clear();
+            pro::cullFrustum(pro::extractFrustum(glm::mat4(1.0f)), allBounds, visible);
 
-            // Acquire swap image
-            unsigned int indexSwap = pro::acquireNextSwapImage(vkInitData, commandData, resizeFunc);
+            // Acquire swap image (waits on the CURRENT frame-in-flight only)
+            unsigned int indexSwap = frameRing.acquire(resizeFunc);
+
+            // Swap in any rebuilt pipelines (frame boundary)
+            if(hotReloader.beginFrame() > 0) {
+                cout << "Shaders reloaded." << endl;
+            }
 
             // Record a frame
             recordFrame(
                 vkInitData, 
-                commandData, 
+                frameRing.current(), 
                 vkInitData.swapchain().swaps[indexSwap], 
-                allDepthImages[indexFlight],
-                pipelineData,
-                allMeshes);
+                frameRing.currentDepthImage(),
+                hotReloader.get(pipelineID),
+                allMeshes,
+                visible);
                     
             // Submit to queue
-            pro::submitToGraphicsQueue(vkInitData, commandData, indexSwap, resizeFunc);
+            frameRing.submit(indexSwap, resizeFunc);
 
-            // Present
-            if(!pro::presentSwapImage(vkInitData, commandData, indexSwap, resizeFunc)) {
+            // Present (also moves to the next frame-in-flight)
+            if(!frameRing.present(indexSwap, resizeFunc)) {
                 cout << "Warning: Presentation was not successful." << endl;
             }
         }
@@ -334,18 +351,18 @@ int main(int argc, char **argv) {
         // Wait until device is completely idle
         vkInitData.device().waitIdle();
 
+#ifdef PRO_ENABLE_CPU_PROFILER
+        // Last frames' CPU timings (open in chrome://tracing or ui.perfetto.dev)
+        pro::CPUProfiler::get().writeChromeTrace("VulkanStart_trace.json");
+#endif
+
         // Cleanup assets
         for(auto &mesh : allMeshes) {
             pro::cleanupVulkanMesh(vkInitData, mesh);
         }
         allMeshes.clear();
         
-        // Cleanup Vulkan-related stuff
-        cleanupVulkanPipeline(vkInitData, pipelineData);
-        cleanupFrameCommandData(vkInitData, commandData);
-        cleanupAllVulkanDepthImages(vkInitData, allDepthImages);
-
-        // VulkanInitData will be cleaned up automatically when it falls out of scope.
+        // ShaderHotReloader (pipelines), FrameRing, and VulkanInitData will be cleaned up automatically when they fall out of scope.
     }
     
     ///////////////////////////////////////////////////////////////////////
@@ -0,0 +1,574 @@
+#pragma once
+#include "ProImage.hpp"
+#include "ProJobs.hpp"
+#include <cfloat>
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    enum TEXTURE_COMPRESSION {
+        COMPRESS_NONE,
+        COMPRESS_AUTO,      // BC5 for normal maps, BC7 otherwise
+        COMPRESS_BC1,       // RGB, 4 bpp (alpha is dropped)
+        COMPRESS_BC3,       // RGBA, 8 bpp (BC1 color + BC4 alpha)
+        COMPRESS_BC5,       // RG only, 8 bpp (two BC4 blocks; rebuild z in the shader)
+        COMPRESS_BC7        // RGBA, 8 bpp (mode 6 only: one subset, 4-bit indices)
+    };
+
+    // Every level packed back to back (level 0 first)
+    struct CompressedMipChain {
+        TEXTURE_COMPRESSION compression = COMPRESS_NONE;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        vector<unsigned char> data {};
+        vector<size_t> levelOffsets {};
+        vector<size_t> levelSizes {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // HELPER FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // One 4x4 block as planes of 16 floats: R, G, B, A
+    struct BCBlock {
+        alignas(16) float channels[4][16];
+    };
+
+    // Edge pixels are repeated for blocks that hang off the image
+    inline void loadBCBlock(const HostImage &image, uint32_t bx, uint32_t by, BCBlock &block) {
+        for(int y = 0; y < 4; y++) {
+            int sy = min((int)by*4 + y, image.height - 1);
+            for(int x = 0; x < 4; x++) {
+                int sx = min((int)bx*4 + x, image.width - 1);
+                const unsigned char *p = &image.data[((size_t)sy * image.width + sx) * 4];
+                for(int c = 0; c < 4; c++) {
+                    block.channels[c][y*4 + x] = (float)p[c];
+                }
+            }
+        }
+    };
+
+    // Nearest palette entry for each pixel (squared RGBA distance). Returns the total error.
+    inline float findBCPaletteIndices(  const BCBlock &block,
+                                        const float (*palette)[4], int paletteCnt,
+                                        uint8_t indices[16]) {
+        float totalError = 0.0f;
+
+        #ifdef PRO_USE_SSE2
+            // 4 pixels at a time
+            for(int i = 0; i < 16; i += 4) {
+                __m128 r = _mm_load_ps(&block.channels[0][i]);
+                __m128 g = _mm_load_ps(&block.channels[1][i]);
+                __m128 b = _mm_load_ps(&block.channels[2][i]);
+                __m128 a = _mm_load_ps(&block.channels[3][i]);
+
+                __m128 bestError = _mm_set1_ps(FLT_MAX);
+                __m128i bestIndex = _mm_setzero_si128();
+                for(int p = 0; p < paletteCnt; p++) {
+                    __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[p][0]));
+                    __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[p][1]));
+                    __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[p][2]));
+                    __m128 da = _mm_sub_ps(a, _mm_set1_ps(palette[p][3]));
+                    __m128 err = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)),
+                                            _mm_add_ps(_mm_mul_ps(db, db), _mm_mul_ps(da, da)));
+
+                    __m128i better = _mm_castps_si128(_mm_cmplt_ps(err, bestError));
+                    bestError = _mm_min_ps(err, bestError);
+                    bestIndex = _mm_or_si128(   _mm_and_si128(better, _mm_set1_epi32(p)),
+                                                _mm_andnot_si128(better, bestIndex));
+                }
+
+                alignas(16) float errors[4];
+                alignas(16) int32_t bestIndices[4];
+                _mm_store_ps(errors, bestError);
+                _mm_store_si128(reinterpret_cast<__m128i*>(bestIndices), bestIndex);
+                for(int k = 0; k < 4; k++) {
+                    indices[i + k] = (uint8_t)bestIndices[k];
+                    totalError += errors[k];
+                }
+            }
+        #else
+            for(int i = 0; i < 16; i++) {
+                float bestError = FLT_MAX;
+                for(int p = 0; p < paletteCnt; p++) {
+                    float err = 0.0f;
+                    for(int c = 0; c < 4; c++) {
+                        float d = block.channels[c][i] - palette[p][c];
+                        err += d*d;
+                    }
+                    if(err < bestError) {
+                        bestError = err;
+                        indices[i] = (uint8_t)p;
+                    }
+                }
+                totalError += bestError;
+            }
+        #endif
+
+        return totalError;
+    };
+
+    // Principal axis (power iteration on the covariance) through the block mean.
+    // Returns false if the block is (nearly) a single color.
+    inline bool findBCPrincipalAxis(const BCBlock &block, int channelCnt, float mean[4], float axis[4]) {
+        for(int c = 0; c < 4; c++) {
+            mean[c] = 0.0f;
+            axis[c] = 0.0f;
+            if(c < channelCnt) {
+                for(int i = 0; i < 16; i++) {
+                    mean[c] += block.channels[c][i];
+                }
+                mean[c] /= 16.0f;
+            }
+        }
+
+        float cov[4][4] = {};
+        for(int i = 0; i < 16; i++) {
+            for(int c0 = 0; c0 < channelCnt; c0++) {
+                float d0 = block.channels[c0][i] - mean[c0];
+                for(int c1 = c0; c1 < channelCnt; c1++) {
+                    cov[c0][c1] += d0 * (block.channels[c1][i] - mean[c1]);
+                }
+            }
+        }
+        for(int c0 = 0; c0 < channelCnt; c0++) {
+            for(int c1 = 0; c1 < c0; c1++) {
+                cov[c0][c1] = cov[c1][c0];
+            }
+        }
+
+        float v[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        for(int iter = 0; iter < 8; iter++) {
+            float next[4] = {};
+            float largest = 0.0f;
+            for(int c0 = 0; c0 < channelCnt; c0++) {
+                for(int c1 = 0; c1 < channelCnt; c1++) {
+                    next[c0] += cov[c0][c1] * v[c1];
+                }
+                largest = max(largest, fabsf(next[c0]));
+            }
+            if(largest < 1e-6f) {
+                return false;
+            }
+            for(int c = 0; c < channelCnt; c++) {
+                v[c] = next[c] / largest;
+            }
+        }
+
+        float length = 0.0f;
+        for(int c = 0; c < channelCnt; c++) {
+            length += v[c]*v[c];
+        }
+        length = sqrtf(length);
+        for(int c = 0; c < channelCnt; c++) {
+            axis[c] = v[c] / length;
+        }
+        return true;
+    };
+
+    // Endpoints = block extent along the axis (pulled in by inset of the range on each side)
+    inline void findBCAxisEndpoints(const BCBlock &block, int channelCnt,
+                                    const float mean[4], const float axis[4], float inset,
+                                    float e0[4], float e1[4]) {
+        float tMin = FLT_MAX;
+        float tMax = -FLT_MAX;
+        for(int i = 0; i < 16; i++) {
+            float t = 0.0f;
+            for(int c = 0; c < channelCnt; c++) {
+                t += (block.channels[c][i] - mean[c]) * axis[c];
+            }
+            tMin = min(tMin, t);
+            tMax = max(tMax, t);
+        }
+        float pad = (tMax - tMin) * inset;
+        tMin += pad;
+        tMax -= pad;
+        for(int c = 0; c < 4; c++) {
+            e0[c] = glm::clamp(mean[c] + axis[c]*tMin, 0.0f, 255.0f);
+            e1[c] = glm::clamp(mean[c] + axis[c]*tMax, 0.0f, 255.0f);
+        }
+    };
+
+    // Least-squares endpoints for fixed indices (weights[index] = how much of e1 is used).
+    // Returns false if the system is singular (e.g., every pixel uses the same index).
+    inline bool refineBCEndpoints(  const BCBlock &block, int channelCnt,
+                                    const uint8_t indices[16], const float *weights,
+                                    float e0[4], float e1[4]) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ap[4] = {}, bp[4] = {};
+        for(int i = 0; i < 16; i++) {
+            float b = weights[indices[i]];
+            float a = 1.0f - b;
+            aa += a*a;
+            ab += a*b;
+            bb += b*b;
+            for(int c = 0; c < channelCnt; c++) {
+                ap[c] += a * block.channels[c][i];
+                bp[c] += b * block.channels[c][i];
+            }
+        }
+
+        float det = aa*bb - ab*ab;
+        if(fabsf(det) < 1e-6f) {
+            return false;
+        }
+        for(int c = 0; c < channelCnt; c++) {
+            e0[c] = glm::clamp((ap[c]*bb - bp[c]*ab) / det, 0.0f, 255.0f);
+            e1[c] = glm::clamp((bp[c]*aa - ap[c]*ab) / det, 0.0f, 255.0f);
+        }
+        return true;
+    };
+
+    inline uint16_t packRGB565(const float c[4]) {
+        uint16_t r = (uint16_t)lroundf(c[0] * 31.0f / 255.0f);
+        uint16_t g = (uint16_t)lroundf(c[1] * 63.0f / 255.0f);
+        uint16_t b = (uint16_t)lroundf(c[2] * 31.0f / 255.0f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    };
+
+    inline void unpackRGB565(uint16_t v, float c[4]) {
+        uint32_t r = (v >> 11) & 31;
+        uint32_t g = (v >> 5) & 63;
+        uint32_t b = v & 31;
+        c[0] = (float)((r << 3) | (r >> 2));
+        c[1] = (float)((g << 2) | (g >> 4));
+        c[2] = (float)((b << 3) | (b >> 2));
+        c[3] = 0.0f;
+    };
+
+    // Writes count bits of value at bit position pos (LSB first)
+    inline void writeBCBits(unsigned char *out, uint32_t &pos, uint32_t value, uint32_t count) {
+        for(uint32_t i = 0; i < count; i++, pos++) {
+            if(value & (1u << i)) {
+                out[pos / 8] |= (unsigned char)(1u << (pos % 8));
+            }
+        }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // BC1 color block (4-color mode; 8 bytes). Alpha is ignored.
+    inline void encodeBlockBC1(const BCBlock &block, unsigned char *out) {
+        // Weight of color1 for each palette index
+        static const float weights[4] = { 0.0f, 1.0f, 1.0f/3.0f, 2.0f/3.0f };
+
+        // Compare RGB only
+        BCBlock rgb = block;
+        for(int i = 0; i < 16; i++) {
+            rgb.channels[3][i] = 0.0f;
+        }
+
+        float mean[4], axis[4], e0[4], e1[4];
+        if(!findBCPrincipalAxis(rgb, 3, mean, axis)) {
+            for(int c = 0; c < 4; c++) {
+                e0[c] = e1[c] = mean[c];
+            }
+        }
+        else {
+            findBCAxisEndpoints(rgb, 3, mean, axis, 1.0f/16.0f, e1, e0);
+        }
+
+        uint16_t bestColor0 = 0, bestColor1 = 0;
+        uint8_t bestIndices[16] = {};
+        float bestError = FLT_MAX;
+
+        // Axis fit, then one least-squares pass
+        for(int pass = 0; pass < 2; pass++) {
+            uint16_t color0 = packRGB565(e0);
+            uint16_t color1 = packRGB565(e1);
+            if(color0 < color1) {
+                swap(color0, color1);
+            }
+
+            uint8_t indices[16] = {};
+            float err = 0.0f;
+            if(color0 == color1) {
+                // Only one color (index 0 everywhere)
+                float palette[1][4];
+                unpackRGB565(color0, palette[0]);
+                err = findBCPaletteIndices(rgb, palette, 1, indices);
+            }
+            else {
+                float palette[4][4];
+                unpackRGB565(color0, palette[0]);
+                unpackRGB565(color1, palette[1]);
+                for(int c = 0; c < 4; c++) {
+                    palette[2][c] = floorf((2.0f*palette[0][c] + palette[1][c]) / 3.0f);
+                    palette[3][c] = floorf((palette[0][c] + 2.0f*palette[1][c]) / 3.0f);
+                }
+                err = findBCPaletteIndices(rgb, palette, 4, indices);
+            }
+
+            if(err < bestError) {
+                bestError = err;
+                bestColor0 = color0;
+                bestColor1 = color1;
+                memcpy(bestIndices, indices, 16);
+            }
+
+            if(pass == 0 && (color0 == color1 || !refineBCEndpoints(rgb, 3, indices, weights, e0, e1))) {
+                break;
+            }
+        }
+
+        out[0] = (unsigned char)(bestColor0 & 0xFF);
+        out[1] = (unsigned char)(bestColor0 >> 8);
+        out[2] = (unsigned char)(bestColor1 & 0xFF);
+        out[3] = (unsigned char)(bestColor1 >> 8);
+        uint32_t bits = 0;
+        for(int i = 0; i < 16; i++) {
+            bits |= (uint32_t)bestIndices[i] << (2*i);
+        }
+        memcpy(out + 4, &bits, 4);
+    };
+
+    // BC4 block for one channel (8-value mode; 8 bytes)
+    inline void encodeBlockBC4(const BCBlock &block, int channel, unsigned char *out) {
+        const float *values = block.channels[channel];
+        float lo = 255.0f, hi = 0.0f;
+        for(int i = 0; i < 16; i++) {
+            lo = min(lo, values[i]);
+            hi = max(hi, values[i]);
+        }
+
+        // alpha0 > alpha1 selects the 8-value palette
+        unsigned char alpha0 = (unsigned char)hi;
+        unsigned char alpha1 = (unsigned char)lo;
+        float palette[8] = { (float)alpha0, (float)alpha1 };
+        for(int i = 2; i < 8; i++) {
+            palette[i] = floorf(((8 - i)*palette[0] + (i - 1)*palette[1]) / 7.0f);
+        }
+
+        uint64_t bits = 0;
+        if(alpha0 != alpha1) {
+            for(int i = 0; i < 16; i++) {
+                int best = 0;
+                float bestError = FLT_MAX;
+                for(int p = 0; p < 8; p++) {
+                    float err = fabsf(values[i] - palette[p]);
+                    if(err < bestError) {
+                        bestError = err;
+                        best = p;
+                    }
+                }
+                bits |= (uint64_t)best << (3*i);
+            }
+        }
+
+        out[0] = alpha0;
+        out[1] = alpha1;
+        for(int i = 0; i < 6; i++) {
+            out[2 + i] = (unsigned char)(bits >> (8*i));
+        }
+    };
+
+    // BC3 = BC4 alpha + BC1 color (16 bytes)
+    inline void encodeBlockBC3(const BCBlock &block, unsigned char *out) {
+        encodeBlockBC4(block, 3, out);
+        encodeBlockBC1(block, out + 8);
+    };
+
+    // BC5 = BC4 red + BC4 green (16 bytes)
+    inline void encodeBlockBC5(const BCBlock &block, unsigned char *out) {
+        encodeBlockBC4(block, 0, out);
+        encodeBlockBC4(block, 1, out + 8);
+    };
+
+    // BC7 mode 6 (16 bytes): 7.7.7.7 endpoints + one p-bit each, 16 interpolated colors
+    inline void encodeBlockBC7(const BCBlock &block, unsigned char *out) {
+        static const int weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+        static const float weights[16] = {  0/64.0f,  4/64.0f,  9/64.0f, 13/64.0f, 17/64.0f, 21/64.0f, 26/64.0f, 30/64.0f,
+                                            34/64.0f, 38/64.0f, 43/64.0f, 47/64.0f, 51/64.0f, 55/64.0f, 60/64.0f, 64/64.0f };
+
+        // Quantize an endpoint to 7 bits per channel + the p-bit that fits best
+        auto quantize = [](const float e[4], uint32_t q[4], uint32_t &pBit) {
+            float bestError = FLT_MAX;
+            for(uint32_t p = 0; p < 2; p++) {
+                uint32_t candidate[4];
+                float err = 0.0f;
+                for(int c = 0; c < 4; c++) {
+                    candidate[c] = (uint32_t)glm::clamp((int)lroundf((e[c] - (float)p) / 2.0f), 0, 127);
+                    float d = (float)((candidate[c] << 1) | p) - e[c];
+                    err += d*d;
+                }
+                if(err < bestError) {
+                    bestError = err;
+                    pBit = p;
+                    memcpy(q, candidate, sizeof(candidate));
+                }
+            }
+        };
+
+        float mean[4], axis[4], e0[4], e1[4];
+        if(!findBCPrincipalAxis(block, 4, mean, axis)) {
+            for(int c = 0; c < 4; c++) {
+                e0[c] = e1[c] = mean[c];
+            }
+        }
+        else {
+            findBCAxisEndpoints(block, 4, mean, axis, 0.0f, e0, e1);
+        }
+
+        uint32_t bestQ0[4] = {}, bestQ1[4] = {}, bestP0 = 0, bestP1 = 0;
+        uint8_t bestIndices[16] = {};
+        float bestError = FLT_MAX;
+
+        for(int pass = 0; pass < 2; pass++) {
+            uint32_t q0[4], q1[4], p0 = 0, p1 = 0;
+            quantize(e0, q0, p0);
+            quantize(e1, q1, p1);
+
+            float palette[16][4];
+            for(int i = 0; i < 16; i++) {
+                for(int c = 0; c < 4; c++) {
+                    uint32_t v0 = (q0[c] << 1) | p0;
+                    uint32_t v1 = (q1[c] << 1) | p1;
+                    palette[i][c] = (float)(((64 - weights4[i])*v0 + weights4[i]*v1 + 32) >> 6);
+                }
+            }
+
+            uint8_t indices[16];
+            float err = findBCPaletteIndices(block, palette, 16, indices);
+            if(err < bestError) {
+                bestError = err;
+                memcpy(bestQ0, q0, sizeof(q0));
+                memcpy(bestQ1, q1, sizeof(q1));
+                bestP0 = p0;
+                bestP1 = p1;
+                memcpy(bestIndices, indices, 16);
+            }
+
+            if(pass == 0 && !refineBCEndpoints(block, 4, indices, weights, e0, e1)) {
+                break;
+            }
+        }
+
+        // The first index only has 3 bits stored (its top bit must be 0)
+        if(bestIndices[0] & 8) {
+            swap(bestQ0, bestQ1);
+            swap(bestP0, bestP1);
+            for(int i = 0; i < 16; i++) {
+                bestIndices[i] = (uint8_t)(15 - bestIndices[i]);
+            }
+        }
+
+        memset(out, 0, 16);
+        uint32_t pos = 0;
+        writeBCBits(out, pos, 1u << 6, 7);      // Mode 6
+        for(int c = 0; c < 4; c++) {
+            writeBCBits(out, pos, bestQ0[c], 7);
+            writeBCBits(out, pos, bestQ1[c], 7);
+        }
+        writeBCBits(out, pos, bestP0, 1);
+        writeBCBits(out, pos, bestP1, 1);
+        writeBCBits(out, pos, bestIndices[0], 3);
+        for(int i = 1; i < 16; i++) {
+            writeBCBits(out, pos, bestIndices[i], 4);
+        }
+    };
+
+    inline TEXTURE_COMPRESSION resolveTextureCompression(TEXTURE_COMPRESSION compression, bool isNormalMap) {
+        if(compression == COMPRESS_AUTO) {
+            return isNormalMap ? COMPRESS_BC5 : COMPRESS_BC7;
+        }
+        return compression;
+    };
+
+    inline size_t getBCBlockSize(TEXTURE_COMPRESSION compression) {
+        return (compression == COMPRESS_BC1) ? 8 : 16;
+    };
+
+    inline size_t getBCLevelSize(TEXTURE_COMPRESSION compression, uint32_t width, uint32_t height) {
+        return (size_t)((width + 3) / 4) * ((height + 3) / 4) * getBCBlockSize(compression);
+    };
+
+    // BC5 has no sRGB variant (it is meant for data like normals anyway)
+    inline vk::Format getBCFormat(TEXTURE_COMPRESSION compression, bool sRGB) {
+        switch(compression) {
+            case COMPRESS_BC1:  return sRGB ? vk::Format::eBc1RgbSrgbBlock : vk::Format::eBc1RgbUnormBlock;
+            case COMPRESS_BC3:  return sRGB ? vk::Format::eBc3SrgbBlock : vk::Format::eBc3UnormBlock;
+            case COMPRESS_BC5:  return vk::Format::eBc5UnormBlock;
+            case COMPRESS_BC7:  return sRGB ? vk::Format::eBc7SrgbBlock : vk::Format::eBc7UnormBlock;
+            default:            return vk::Format::eUndefined;
+        }
+    };
+
+    inline const char* getTextureCompressionName(TEXTURE_COMPRESSION compression) {
+        switch(compression) {
+            case COMPRESS_NONE: return "none";
+            case COMPRESS_AUTO: return "auto";
+            case COMPRESS_BC1:  return "bc1";
+            case COMPRESS_BC3:  return "bc3";
+            case COMPRESS_BC5:  return "bc5";
+            case COMPRESS_BC7:  return "bc7";
+            default:            return "unknown";
+        }
+    };
+
+    // Compresses every level of an RGBA8 mip chain; block rows of ALL levels are spread over the threads
+    inline CompressedMipChain compressHostMipChainBC(   const vector<HostImage> &levels,
+                                                        TEXTURE_COMPRESSION compression,
+                                                        unsigned int threadCnt = 0) {
+        if(compression == COMPRESS_NONE || compression == COMPRESS_AUTO) {
+            print_and_throw_error("compressHostMipChainBC", "Needs a concrete BC format (call resolveTextureCompression() first)!");
+        }
+
+        CompressedMipChain chain {};
+        chain.compression = compression;
+        if(levels.empty()) {
+            return chain;
+        }
+        chain.width = (uint32_t)levels[0].width;
+        chain.height = (uint32_t)levels[0].height;
+
+        // (level, block row) jobs
+        vector<pair<uint32_t, uint32_t>> allRows {};
+        size_t totalSize = 0;
+        for(uint32_t i = 0; i < levels.size(); i++) {
+            if(levels[i].channels != 4) {
+                print_and_throw_error("compressHostMipChainBC", "Only 4-channel (RGBA) host images are supported!");
+            }
+            uint32_t width = (uint32_t)levels[i].width;
+            uint32_t height = (uint32_t)levels[i].height;
+            chain.levelOffsets.push_back(totalSize);
+            chain.levelSizes.push_back(getBCLevelSize(compression, width, height));
+            totalSize += chain.levelSizes.back();
+            for(uint32_t by = 0; by < (height + 3) / 4; by++) {
+                allRows.push_back({ i, by });
+            }
+        }
+        chain.data.resize(totalSize);
+
+        size_t blockSize = getBCBlockSize(compression);
+        runInParallel(allRows.size(), [&](size_t job) {
+            auto [level, by] = allRows[job];
+            const HostImage &image = levels[level];
+            uint32_t blocksX = ((uint32_t)image.width + 3) / 4;
+            unsigned char *out = chain.data.data() + chain.levelOffsets[level] + (size_t)by * blocksX * blockSize;
+
+            BCBlock block {};
+            for(uint32_t bx = 0; bx < blocksX; bx++, out += blockSize) {
+                loadBCBlock(image, bx, by, block);
+                switch(compression) {
+                    case COMPRESS_BC1:  encodeBlockBC1(block, out); break;
+                    case COMPRESS_BC3:  encodeBlockBC3(block, out); break;
+                    case COMPRESS_BC5:  encodeBlockBC5(block, out); break;
+                    default:            encodeBlockBC7(block, out); break;
+                }
+            }
+        }, threadCnt);
+
+        return chain;
+    };
+
+    inline CompressedMipChain compressHostImageBC(  const HostImage &image,
+                                                    TEXTURE_COMPRESSION compression,
+                                                    unsigned int threadCnt = 0) {
+        return compressHostMipChainBC(vector<HostImage> { image }, compression, threadCnt);
+    };
+}
@@ -18,18 +18,75 @@ namespace pro {
         void *hostData = nullptr;        
         VulkanBuffer dstBuffer {};
         vk::AccessFlags dstAccessMask {};
+        vk::DeviceSize dstOffset = 0;       // Where in dstBuffer to copy to
+        vk::DeviceSize size = 0;            // How many bytes to copy
 
         PendingBufferCopy(VulkanBuffer &dstBuffer, void *hostData, vk::AccessFlags dstAccessMask) {
             this->dstBuffer = dstBuffer;
             this->hostData = hostData;
             this->dstAccessMask = dstAccessMask;
+            this->size = dstBuffer.size;
         };
+
+        // Copy into only part of dstBuffer
+        PendingBufferCopy(  VulkanBuffer &dstBuffer, void *hostData, vk::AccessFlags dstAccessMask,
+                            vk::DeviceSize dstOffset, vk::DeviceSize size) {
+            this->dstBuffer = dstBuffer;
+            this->hostData = hostData;
+            this->dstAccessMask = dstAccessMask;
+            this->dstOffset = dstOffset;
+            this->size = size;
+        };
+    };
+
+    // Buffer-to-image upload (through the transfer queue).
+    // hostData holds every region back to back; region bufferOffsets are relative to hostData.
+    struct PendingImageCopy {
+        void *hostData = nullptr;
+        vk::DeviceSize size = 0;                            // Total bytes in hostData
+        VulkanImage dstImage {};
+        vector<vk::BufferImageCopy> regions {};
+        vk::ImageLayout finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+        // If true, only level 0 is copied; the rest are blitted on the graphics queue
+        // when the receive barriers are recorded (see recordGenerateMipmaps())
+        bool generateMipmaps = false;
+
+        // Just mip level 0 (tightly packed)
+        PendingImageCopy(VulkanImage &dstImage, void *hostData, vk::DeviceSize size) {
+            this->dstImage = dstImage;
+            this->hostData = hostData;
+            this->size = size;
+
+            vk::BufferImageCopy region {};
+            region.bufferOffset = 0;
+            region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+            region.imageExtent = dstImage.extent;
+            regions.push_back(region);
+        };
+
+        PendingImageCopy(   VulkanImage &dstImage, void *hostData, vk::DeviceSize size,
+                            const vector<vk::BufferImageCopy> &regions) {
+            this->dstImage = dstImage;
+            this->hostData = hostData;
+            this->size = size;
+            this->regions = regions;
+        };
+    };
+
+    enum TRANSFER_SYNC_TYPE {
+        SYNC_FENCE,         // One fence per receipt (polled with checkCompleted())
+        SYNC_TIMELINE       // One timeline semaphore; graphics submits wait on a receipt's ticket
     };
 
     struct BufferCopyReceipt {
-        vk::Fence copyFinished {};
+        uint64_t ticket = 0;                        // Timeline value signaled when done (SYNC_TIMELINE only)
+        vk::Fence copyFinished {};                  // SYNC_FENCE only
         vector<vk::BufferMemoryBarrier> allReceiveBarriers {};
-        vector<VulkanBuffer> allStageBuffers {};
+        vector<vk::ImageMemoryBarrier> allImageReceiveBarriers {};
+        vector<pair<VulkanImage, vk::ImageLayout>> allMipmapImages {};   // Image + its final layout
+        vector<VulkanBuffer> allStageBuffers {};    // Only for copies that did NOT fit in the staging ring
+        uint64_t stagingRingSpan = 0;               // 0 = nothing used in staging ring
         vk::CommandBuffer commandBuffer {};
     };
 
@@ -115,34 +172,355 @@ namespace pro {
         return stageBuffer;
     };
 
+    // Copies a (4 bytes per texel) color image back to the CPU.
+    // Image must already be in eTransferSrcOptimal (see COLOR_TO_TRANSFER_SRC).
+    // Waits until the graphics queue is idle!
+    inline HostImage readbackVulkanImage(VulkanInitData &vkInitData, const VulkanImage &imageData) {
+        
+        bool swapRedBlue = false;
+        switch(imageData.format) {
+            case vk::Format::eR8G8B8A8Unorm:
+            case vk::Format::eR8G8B8A8Srgb:
+                break;
+            case vk::Format::eB8G8R8A8Unorm:
+            case vk::Format::eB8G8R8A8Srgb:
+                swapRedBlue = true;
+                break;
+            default:
+                print_and_throw_error("readbackVulkanImage", 
+                                        "Unsupported format: " + vk::to_string(imageData.format));
+        }
+
+        // Host-visible buffer we will READ from (so random access, not sequential write)
+        vk::DeviceSize byteCnt = (vk::DeviceSize)imageData.extent.width * imageData.extent.height * 4;
+        VmaAllocationCreateInfo vmaInfo {};
+        vmaInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        vmaInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        VulkanBuffer readBuffer = createVulkanBuffer(   vkInitData, byteCnt, 
+                                                        vk::BufferUsageFlagBits::eTransferDst, 
+                                                        vmaInfo);
+
+        // Temporary command pool and buffer
+        vk::CommandPool readPool = createVulkanCommandPool( vkInitData, 
+                                                            vkInitData.graphicsQueue().index,
+                                                            vk::CommandPoolCreateFlagBits::eTransient);
+        vk::CommandBuffer readCommandBuffer = createVulkanCommandBuffers(vkInitData, readPool).front();
+        readCommandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        vk::BufferImageCopy region {};
+        region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+        region.imageExtent = imageData.extent;
+        readCommandBuffer.copyImageToBuffer(imageData.image, 
+                                            vk::ImageLayout::eTransferSrcOptimal, 
+                                            readBuffer.buffer, 
+                                            region);
+
+        // Make transfer write visible to the host
+        vk::BufferMemoryBarrier hostBarrier(vk::AccessFlagBits::eTransferWrite, 
+                                            vk::AccessFlagBits::eHostRead,
+                                            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                                            readBuffer.buffer, 0, VK_WHOLE_SIZE);
+        readCommandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTransfer,
+                                            vk::PipelineStageFlagBits::eHost,
+                                            {}, nullptr, hostBarrier, nullptr);
+        readCommandBuffer.end();
+
+        vk::SubmitInfo submitInfo = vk::SubmitInfo().setCommandBuffers(readCommandBuffer);                    
+        vkInitData.graphicsQueue().queue.submit(submitInfo);
+        vkInitData.graphicsQueue().queue.waitIdle();
+        cleanupVulkanCommandPool(vkInitData, readPool);
+
+        // Copy out to host image
+        vmaInvalidateAllocation(vkInitData.allocator(), readBuffer.allocation, 0, VK_WHOLE_SIZE);
+        HostImage hostImage {};
+        hostImage.width = (int)imageData.extent.width;
+        hostImage.height = (int)imageData.extent.height;
+        hostImage.channels = 4;
+        hostImage.data.resize(byteCnt);
+        memcpy(hostImage.data.data(), readBuffer.mapped, byteCnt);
+
+        if(swapRedBlue) {
+            for(size_t i = 0; i < hostImage.data.size(); i += 4) {
+                swap(hostImage.data[i], hostImage.data[i + 2]);
+            }
+        }
+
+        cleanupVulkanBuffer(vkInitData, readBuffer);
+        return hostImage;
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     // CLASSES 
     ///////////////////////////////////////////////////////////////////////////  
 
+    // One persistently-mapped, host-visible buffer that staging data 
+    // is linearly sub-allocated from (wrapping around at the end).
+    // Space is handed back in submission order once each span retires.
+    class StagingRing {
+    private:
+        struct StagingRingSpan {
+            uint64_t id = 0;
+            vk::DeviceSize end = 0;         // Head position after this span's allocations
+            vk::DeviceSize consumed = 0;    // Bytes used (including padding/wrap waste)
+            bool retired = false;
+        };
+
+        VulkanInitData *refInitData;        // Do NOT clean up!!!
+        VulkanBuffer buffer {};             // Cleaned up explicitly
+        vk::DeviceSize head = 0;            // Next free byte
+        vk::DeviceSize tail = 0;            // Oldest byte still in use
+        vk::DeviceSize used = 0;            // Bytes in use (including open span)
+        deque<StagingRingSpan> allSpans {};
+        StagingRingSpan openSpan {};
+        uint64_t nextSpanId = 1;
+
+    public:
+        StagingRing(VulkanInitData &vkInitData, vk::DeviceSize capacity) {
+            refInitData = &vkInitData;
+            buffer = createVulkanBuffer(*refInitData, 
+                                        capacity,
+                                        vk::BufferUsageFlagBits::eTransferSrc,
+                                        createVMAHostVisibleInfo());
+        };
+
+        ~StagingRing() {
+            cleanupVulkanBuffer(*refInitData, buffer);
+        };
+
+        // Copy: forbidden (unique ownership)
+        StagingRing(const StagingRing&)            = delete;
+        StagingRing& operator=(const StagingRing&) = delete;
+
+        const VulkanBuffer& getBuffer() const noexcept { return buffer; };
+        vk::DeviceSize getCapacity() const noexcept { return buffer.size; };
+        vk::DeviceSize getUsed() const noexcept { return used; };
+
+        // Returns false if there is no room (caller should fall back to a dedicated buffer)
+        bool allocate(vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize &offset) {
+            vk::DeviceSize capacity = buffer.size;
+            if(size == 0 || size > capacity) {
+                return false;
+            }
+
+            // Completely empty --> start over at the beginning
+            if(used == 0) {
+                head = tail = 0;
+            }
+            // Completely full
+            else if(head == tail) {
+                return false;
+            }
+            
+            vk::DeviceSize aligned = (head + alignment - 1) / alignment * alignment;
+            vk::DeviceSize consumed = 0;
+
+            if(head >= tail) {
+                // Free: [head, capacity) and [0, tail)
+                if(aligned + size <= capacity) {
+                    offset = aligned;
+                    consumed = (aligned + size) - head;
+                }
+                else if(size <= tail) {
+                    offset = 0;
+                    consumed = (capacity - head) + size;
+                }
+                else {
+                    return false;
+                }
+            }
+            else {
+                // Free: [head, tail)
+                if(aligned + size <= tail) {
+                    offset = aligned;
+                    consumed = (aligned + size) - head;
+                }
+                else {
+                    return false;
+                }
+            }
+
+            head = offset + size;
+            if(head == capacity) {
+                head = 0;
+            }
+            used += consumed;
+            openSpan.consumed += consumed;
+            return true;
+        };
+
+        void* getMapped(vk::DeviceSize offset) {
+            return static_cast<char*>(buffer.mapped) + offset;
+        };
+
+        // Closes everything allocated since the last call into a span (0 if nothing allocated)
+        uint64_t closeSpan() {
+            if(openSpan.consumed == 0) {
+                return 0;
+            }
+
+            // Make writes visible to the device
+            vmaFlushAllocation(refInitData->allocator(), buffer.allocation, 0, VK_WHOLE_SIZE);
+
+            openSpan.id = nextSpanId++;
+            openSpan.end = head;
+            allSpans.push_back(openSpan);
+            openSpan = {};
+            return allSpans.back().id;
+        };
+
+        // Called once the GPU is done with a span (can be out of order)
+        void retireSpan(uint64_t id) {
+            for(auto &span : allSpans) {
+                if(span.id == id) {
+                    span.retired = true;
+                    break;
+                }
+            }
+
+            // Give back space from the front, in order
+            while(!allSpans.empty() && allSpans.front().retired) {
+                tail = allSpans.front().end;
+                used -= allSpans.front().consumed;
+                allSpans.pop_front();
+            }
+        };
+    };
+
     class TransferManager {
     private:
         vk::CommandPool transferPool {};        
         VulkanInitData *refInitData;         // Do NOT clean up!!!
+        unique_ptr<StagingRing> stagingRing {}; // Released after in-flight copies finish (nullptr = disabled)
+
+        // SYNC_FENCE only: submitted and not yet cleaned up by checkCompleted()
+        vector<vk::Fence> allPendingFences {};
         
+        // SYNC_TIMELINE only
+        TRANSFER_SYNC_TYPE syncType = SYNC_FENCE;
+        vk::Semaphore timeline {};                      // Cleaned up explicitly
+        uint64_t lastTicket = 0;
+        deque<BufferCopyReceipt> allInFlightReceipts {}; // Staging resources, in ticket order
+
+        void cleanupReceiptResources(BufferCopyReceipt &receipt) {
+            // Cleanup staging buffers
+            for(unsigned int i = 0; i < receipt.allStageBuffers.size(); i++) {
+                cleanupVulkanBuffer(*refInitData, receipt.allStageBuffers[i]);
+            }
+            receipt.allStageBuffers.clear();
+            if(stagingRing && receipt.stagingRingSpan) {
+                stagingRing->retireSpan(receipt.stagingRingSpan);
+                receipt.stagingRingSpan = 0;
+            }
+            if(receipt.copyFinished) {
+                erase(allPendingFences, receipt.copyFinished);
+                cleanupVulkanFence(*refInitData, receipt.copyFinished);
+            }
+            if(receipt.commandBuffer) {
+                refInitData->device().freeCommandBuffers(transferPool, 1, &receipt.commandBuffer);
+                receipt.commandBuffer = vk::CommandBuffer();
+            }
+        };
+
+        void recordReceiveBarriers(BufferCopyReceipt &receipt, vk::CommandBuffer &graphicsCommandBuffer) {
+            if(!receipt.allReceiveBarriers.empty()) {
+                graphicsCommandBuffer.pipelineBarrier(                        
+                    vk::PipelineStageFlagBits::eTransfer,                        
+                    vk::PipelineStageFlagBits::eVertexInput,                        
+                    vk::DependencyFlags(),
+                    0, nullptr,
+                    (uint32_t)receipt.allReceiveBarriers.size(), 
+                    receipt.allReceiveBarriers.data(),
+                    0, nullptr
+                );
+                receipt.allReceiveBarriers.clear();
+            }
+
+            // Images are sampled in shaders
+            if(!receipt.allImageReceiveBarriers.empty()) {
+                graphicsCommandBuffer.pipelineBarrier(                        
+                    vk::PipelineStageFlagBits::eTransfer,                        
+                    vk::PipelineStageFlagBits::eTransfer 
+                        | vk::PipelineStageFlagBits::eVertexShader 
+                        | vk::PipelineStageFlagBits::eFragmentShader,
+                    vk::DependencyFlags(),
+                    0, nullptr,
+                    0, nullptr,
+                    (uint32_t)receipt.allImageReceiveBarriers.size(), 
+                    receipt.allImageReceiveBarriers.data()
+                );
+                receipt.allImageReceiveBarriers.clear();
+            }
+
+            // Blits have to happen on the graphics queue (after the receive barriers)
+            for(auto &[image, finalLayout] : receipt.allMipmapImages) {
+                recordGenerateMipmaps(graphicsCommandBuffer, image, finalLayout);
+            }
+            receipt.allMipmapImages.clear();
+        };
+
     public:
-        TransferManager(VulkanInitData &vkInitData) {
+        // If stagingRingSize is zero, every copy gets its own staging buffer.
+        // SYNC_TIMELINE needs the (Vulkan 1.2) timelineSemaphore feature.
+        TransferManager(VulkanInitData &vkInitData, 
+                        vk::DeviceSize stagingRingSize = 64 * 1024 * 1024,
+                        TRANSFER_SYNC_TYPE syncType = SYNC_FENCE) {
             // Store init data
             refInitData = &vkInitData;
+            this->syncType = syncType;
 
             // Create pool for transfer queue
             transferPool = createVulkanCommandPool(*refInitData, refInitData->transferQueue().index);            
+
+            // Create staging ring
+            if(stagingRingSize > 0) {
+                stagingRing = make_unique<StagingRing>(*refInitData, stagingRingSize);
+            }
+
+            // Create timeline
+            if(syncType == SYNC_TIMELINE) {
+                timeline = createVulkanTimelineSemaphore(*refInitData, 0);
+            }
         };
 
         ~TransferManager() {            
+            // Copies still in flight read from the staging ring
+            if(syncType == SYNC_TIMELINE) {
+                waitForTicket(lastTicket);
+                retireCompleted();
+                cleanupVulkanSemaphore(*refInitData, timeline);
+            }
+            else if(!allPendingFences.empty()) {
+                vk::Result res = refInitData->device().waitForFences(allPendingFences, true, UINT64_MAX);
+                if(res != vk::Result::eSuccess) {
+                    print_warning("TransferManager", "Waiting for in-flight copies did not succeed: " + vk::to_string(res));
+                }
+            }
             cleanupVulkanCommandPool(*refInitData, transferPool);
+            stagingRing.reset();
         };
 
+        // Copy: forbidden (unique ownership)
+        TransferManager(const TransferManager&)            = delete;
+        TransferManager& operator=(const TransferManager&) = delete;
+
+        TRANSFER_SYNC_TYPE getSyncType() const noexcept { return syncType; };
+
         BufferCopyReceipt submitCopies(vector<PendingBufferCopy> &allPendingCopies) {
+            vector<PendingImageCopy> noImageCopies {};
+            return submitCopies(allPendingCopies, noImageCopies);
+        };
+
+        // Buffers AND images in one submission.
+        // Host data is copied into staging memory immediately (can be freed once this returns).
+        BufferCopyReceipt submitCopies( vector<PendingBufferCopy> &allPendingCopies,
+                                        vector<PendingImageCopy> &allPendingImageCopies) {
             // Create the struct to hold the receipt
             BufferCopyReceipt receipt {};
 
             // Create the fence (but start as UNsignaled)
-            receipt.copyFinished = createVulkanFence(*refInitData, vk::FenceCreateInfo());
+            if(syncType == SYNC_FENCE) {
+                receipt.copyFinished = createVulkanFence(*refInitData, vk::FenceCreateInfo());
+            }
 
             // Create the command buffer
             receipt.commandBuffer = createVulkanCommandBuffers(*refInitData, transferPool).front();
@@ -153,17 +531,29 @@ namespace pro {
             // For each copy...
             vector<vk::BufferMemoryBarrier> srcOwnershipBarriers {};
             for(auto &pendingCopy : allPendingCopies) {
-                // Make the staging buffer
-                VulkanBuffer stageBuffer = createStagingBuffer(
-                    *refInitData, 
-                    pendingCopy.dstBuffer.size,
-                    pendingCopy.hostData);
-                receipt.allStageBuffers.push_back(stageBuffer);
+                // Try to sub-allocate from the staging ring first
+                vk::Buffer srcBuffer {};
+                vk::DeviceSize srcOffset = 0;
+                if(stagingRing && stagingRing->allocate(pendingCopy.size, 16, srcOffset)) {
+                    memcpy(stagingRing->getMapped(srcOffset), pendingCopy.hostData, pendingCopy.size);
+                    srcBuffer = stagingRing->getBuffer().buffer;
+                }
+                else {
+                    // Make a dedicated staging buffer
+                    VulkanBuffer stageBuffer = createStagingBuffer(
+                        *refInitData, 
+                        pendingCopy.size,
+                        pendingCopy.hostData);
+                    receipt.allStageBuffers.push_back(stageBuffer);
+                    srcBuffer = stageBuffer.buffer;
+                }
 
                 // Record the copy
                 vk::BufferCopy copyRegion{};
-                copyRegion.size = pendingCopy.dstBuffer.size;
-                receipt.commandBuffer.copyBuffer(stageBuffer.buffer, pendingCopy.dstBuffer.buffer, 1, &copyRegion);
+                copyRegion.srcOffset = srcOffset;
+                copyRegion.dstOffset = pendingCopy.dstOffset;
+                copyRegion.size = pendingCopy.size;
+                receipt.commandBuffer.copyBuffer(srcBuffer, pendingCopy.dstBuffer.buffer, 1, &copyRegion);
                 
                 // Create the source ownership transfer barrier
                 vk::BufferMemoryBarrier tbarrier{};
@@ -172,7 +562,8 @@ namespace pro {
                 tbarrier.srcQueueFamilyIndex = refInitData->transferQueue().index;
                 tbarrier.dstQueueFamilyIndex = refInitData->graphicsQueue().index; 
                 tbarrier.buffer = pendingCopy.dstBuffer.buffer;
-                tbarrier.size = VK_WHOLE_SIZE;
+                tbarrier.offset = pendingCopy.dstOffset;
+                tbarrier.size = pendingCopy.size;
                 srcOwnershipBarriers.push_back(tbarrier);
 
                 // Create the destination ownership transfer barrier
@@ -182,10 +573,99 @@ namespace pro {
                 gbarrier.srcQueueFamilyIndex = refInitData->transferQueue().index;
                 gbarrier.dstQueueFamilyIndex = refInitData->graphicsQueue().index; 
                 gbarrier.buffer = pendingCopy.dstBuffer.buffer;
-                gbarrier.size = VK_WHOLE_SIZE;
+                gbarrier.offset = pendingCopy.dstOffset;
+                gbarrier.size = pendingCopy.size;
                 receipt.allReceiveBarriers.push_back(gbarrier);
             }
 
+            // Images: UNDEFINED --> TRANSFER_DST, copy, then release (and move to finalLayout)
+            vector<vk::ImageMemoryBarrier> imageSrcBarriers {};
+            if(!allPendingImageCopies.empty()) {
+                vector<vk::ImageMemoryBarrier> toTransferDst {};
+                for(auto &pendingCopy : allPendingImageCopies) {
+                    vk::ImageMemoryBarrier barrier {};
+                    barrier.oldLayout = vk::ImageLayout::eUndefined;
+                    barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+                    barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+                    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                    barrier.image = pendingCopy.dstImage.image;
+                    barrier.subresourceRange = vk::ImageSubresourceRange(   vk::ImageAspectFlagBits::eColor, 
+                                                                            0, pendingCopy.dstImage.mipLevels, 0, 1);
+                    toTransferDst.push_back(barrier);
+                }
+                receipt.commandBuffer.pipelineBarrier(
+                    vk::PipelineStageFlagBits::eTopOfPipe,
+                    vk::PipelineStageFlagBits::eTransfer,
+                    vk::DependencyFlags(),
+                    0, nullptr, 0, nullptr,
+                    (uint32_t)toTransferDst.size(), toTransferDst.data());
+
+                uint32_t transferIndex = refInitData->transferQueue().index;
+                uint32_t graphicsIndex = refInitData->graphicsQueue().index;
+                bool sameFamily = (transferIndex == graphicsIndex);
+
+                for(unsigned int i = 0; i < allPendingImageCopies.size(); i++) {
+                    auto &pendingCopy = allPendingImageCopies[i];
+
+                    // Staging (16 bytes covers texel AND compressed block alignment)
+                    vk::Buffer srcBuffer {};
+                    vk::DeviceSize srcOffset = 0;
+                    if(stagingRing && stagingRing->allocate(pendingCopy.size, 16, srcOffset)) {
+                        memcpy(stagingRing->getMapped(srcOffset), pendingCopy.hostData, pendingCopy.size);
+                        srcBuffer = stagingRing->getBuffer().buffer;
+                    }
+                    else {
+                        VulkanBuffer stageBuffer = createStagingBuffer(*refInitData, pendingCopy.size, pendingCopy.hostData);
+                        receipt.allStageBuffers.push_back(stageBuffer);
+                        srcBuffer = stageBuffer.buffer;
+                    }
+
+                    vector<vk::BufferImageCopy> regions = pendingCopy.regions;
+                    for(auto &region : regions) {
+                        region.bufferOffset += srcOffset;
+                    }
+                    receipt.commandBuffer.copyBufferToImage(srcBuffer, pendingCopy.dstImage.image,
+                                                            vk::ImageLayout::eTransferDstOptimal, regions);
+
+                    // Release (does the layout transition);
+                    // mipmapped images stay in TRANSFER_DST for the blits
+                    vk::ImageLayout releaseLayout = pendingCopy.finalLayout;
+                    vk::AccessFlags releaseDstAccess = vk::AccessFlagBits::eShaderRead;
+                    if(pendingCopy.generateMipmaps && pendingCopy.dstImage.mipLevels > 1) {
+                        releaseLayout = vk::ImageLayout::eTransferDstOptimal;
+                        releaseDstAccess = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite;
+                        receipt.allMipmapImages.push_back({pendingCopy.dstImage, pendingCopy.finalLayout});
+                    }
+
+                    vk::ImageMemoryBarrier tbarrier = toTransferDst[i];
+                    tbarrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+                    tbarrier.newLayout = releaseLayout;
+                    tbarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+                    tbarrier.dstAccessMask = releaseDstAccess;
+                    if(!sameFamily) {
+                        tbarrier.srcQueueFamilyIndex = transferIndex;
+                        tbarrier.dstQueueFamilyIndex = graphicsIndex;
+                    }
+                    imageSrcBarriers.push_back(tbarrier);
+
+                    // Acquire (must repeat the SAME transition); 
+                    // with only one queue family, there is no ownership transfer, so just make it visible
+                    vk::ImageMemoryBarrier gbarrier = tbarrier;
+                    gbarrier.srcAccessMask = vk::AccessFlagBits::eNone;
+                    if(sameFamily) {
+                        gbarrier.oldLayout = releaseLayout;
+                        gbarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+                    }
+                    receipt.allImageReceiveBarriers.push_back(gbarrier);
+                }
+            }
+
+            // Everything this submission used in the staging ring
+            if(stagingRing) {
+                receipt.stagingRingSpan = stagingRing->closeSpan();
+            }
+
             // Do the source ownership barriers at the bottom of the pipeline
             receipt.commandBuffer.pipelineBarrier(
                 vk::PipelineStageFlagBits::eTransfer,
@@ -193,7 +673,7 @@ namespace pro {
                 vk::DependencyFlags(), 
                 0, nullptr, 
                 (uint32_t)srcOwnershipBarriers.size(), srcOwnershipBarriers.data(), 
-                0, nullptr
+                (uint32_t)imageSrcBarriers.size(), imageSrcBarriers.data()
             );
 
             // End recording
@@ -203,45 +683,117 @@ namespace pro {
             vk::SubmitInfo submitInfo{};
             submitInfo.commandBufferCount = 1;
             submitInfo.pCommandBuffers = &receipt.commandBuffer;
-            refInitData->transferQueue().queue.submit(1, &submitInfo, receipt.copyFinished);
-            
-            // Return our receipt
-            return receipt;
+
+            if(syncType == SYNC_FENCE) {
+                refInitData->transferQueue().queue.submit(1, &submitInfo, receipt.copyFinished);
+                allPendingFences.push_back(receipt.copyFinished);
+                
+                // Return our receipt
+                return receipt;
+            }
+
+            // Timeline: signal the next ticket value
+            receipt.ticket = ++lastTicket;
+            vk::TimelineSemaphoreSubmitInfo timelineInfo {};
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &receipt.ticket;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &timeline;
+            submitInfo.setPNext(&timelineInfo);
+            refInitData->transferQueue().queue.submit(1, &submitInfo, nullptr);
+
+            // Keep staging resources here until the ticket retires;
+            // the caller's receipt only needs the ticket and the receive barriers
+            BufferCopyReceipt callerReceipt {};
+            callerReceipt.ticket = receipt.ticket;
+            callerReceipt.allReceiveBarriers = receipt.allReceiveBarriers;
+            callerReceipt.allImageReceiveBarriers = receipt.allImageReceiveBarriers;
+            callerReceipt.allMipmapImages = receipt.allMipmapImages;
+            receipt.allReceiveBarriers.clear();
+            receipt.allImageReceiveBarriers.clear();
+            receipt.allMipmapImages.clear();
+            allInFlightReceipts.push_back(receipt);
+
+            return callerReceipt;
         };
 
+        // FENCE or TIMELINE: non-blocking check; if done, records receive barriers and frees staging data
         bool checkCompleted(BufferCopyReceipt &receipt, vk::CommandBuffer &graphicsCommandBuffer) {
             bool isFinished = false;
 
             // Have we finished copying?            
-            vk::Result status = refInitData->device().getFenceStatus(receipt.copyFinished);
+            if(syncType == SYNC_TIMELINE) {
+                isFinished = isTicketComplete(receipt.ticket);
+            }
+            else {
+                vk::Result status = refInitData->device().getFenceStatus(receipt.copyFinished);
+                isFinished = (status == vk::Result::eSuccess);
+            }
 
-            if (status == vk::Result::eSuccess) {
+            if (isFinished) {
                 // Queue up barriers
-                graphicsCommandBuffer.pipelineBarrier(                        
-                    vk::PipelineStageFlagBits::eTransfer,                        
-                    vk::PipelineStageFlagBits::eVertexInput,                        
-                    vk::DependencyFlags(),
-                    0, nullptr,
-                    (uint32_t)receipt.allReceiveBarriers.size(), 
-                    receipt.allReceiveBarriers.data(),
-                    0, nullptr
-                );
+                recordReceiveBarriers(receipt, graphicsCommandBuffer);
 
-                // Cleanup staging buffers
-                for(unsigned int i = 0; i < receipt.allStageBuffers.size(); i++) {
-                    cleanupVulkanBuffer(*refInitData, receipt.allStageBuffers[i]);
+                // Cleanup staging data
+                if(syncType == SYNC_TIMELINE) {
+                    retireCompleted();
+                }
+                else {
+                    cleanupReceiptResources(receipt);
                 }
-                receipt.allStageBuffers.clear();
-                receipt.allReceiveBarriers.clear();
-                cleanupVulkanFence(*refInitData, receipt.copyFinished);
-                refInitData->device().freeCommandBuffers(transferPool, 1, &receipt.commandBuffer);
-
-                // Completed!
-                isFinished = true;
             }
 
             return isFinished;
         };
+
+        // TIMELINE only: records the receive barriers NOW (no waiting on the CPU), 
+        // and returns the wait the graphics submission must include (see submitToGraphicsQueue())
+        TimelineWait receiveOnGraphics(BufferCopyReceipt &receipt, vk::CommandBuffer &graphicsCommandBuffer) {
+            if(syncType != SYNC_TIMELINE) {
+                print_and_throw_error("TransferManager", "receiveOnGraphics() requires SYNC_TIMELINE!");
+            }
+
+            recordReceiveBarriers(receipt, graphicsCommandBuffer);
+
+            // Receive barriers use the transfer stage as their source stage
+            TimelineWait wait {};
+            wait.semaphore = timeline;
+            wait.value = receipt.ticket;
+            wait.stage = vk::PipelineStageFlagBits::eTransfer;
+            return wait;
+        };
+
+        // TIMELINE only
+        uint64_t getCompletedTicket() {
+            return refInitData->device().getSemaphoreCounterValue(timeline);
+        };
+
+        bool isTicketComplete(uint64_t ticket) {
+            return getCompletedTicket() >= ticket;
+        };
+
+        void waitForTicket(uint64_t ticket) {
+            vk::SemaphoreWaitInfo waitInfo({}, timeline, ticket);
+            vk::Result res = refInitData->device().waitSemaphores(waitInfo, UINT64_MAX);
+            if(res != vk::Result::eSuccess) {
+                print_warning("TransferManager", "waitForTicket() did not succeed: " + vk::to_string(res));
+            }
+        };
+
+        // TIMELINE only: frees staging data for every finished ticket (call once per frame)
+        void retireCompleted() {
+            if(allInFlightReceipts.empty()) {
+                return;
+            }
+
+            uint64_t completed = getCompletedTicket();
+            while(!allInFlightReceipts.empty() && allInFlightReceipts.front().ticket <= completed) {
+                cleanupReceiptResources(allInFlightReceipts.front());
+                allInFlightReceipts.pop_front();
+            }
+        };
+
+        unsigned int getInFlightCount() const noexcept { return (unsigned int)allInFlightReceipts.size(); };
     };
 
     /*
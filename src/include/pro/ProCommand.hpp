@@ -1,5 +1,7 @@
 #pragma once
-#include "ProSetup.hpp"
+#include "ProImage.hpp"
+#include "ProTrace.hpp"
+#include "ProJobs.hpp"
 
 namespace pro {
 
@@ -18,8 +20,36 @@ namespace pro {
         vk::CommandBuffer commandBuffer {};
         vk::Semaphore imageAvailable {};        
         vk::Fence inFlight {};        
+
+        // Optional (see GPUProfiler); only reused once inFlight has signaled
+        vk::QueryPool timestampPool {};
+        uint32_t timestampQueryCnt = 0;
+    };
+
+    // Extra (timeline) semaphore for a queue submission to wait on
+    struct TimelineWait {
+        vk::Semaphore semaphore {};
+        uint64_t value = 0;
+        vk::PipelineStageFlags stage {};
     };
 
+    // Attachment formats that secondary command buffers inherit from the primary's beginRendering()
+    // (defaults match VulkanPipelineCreateInfo)
+    struct SecondaryRenderingInfo {
+        vector<vk::Format> colorFormats {};
+        vk::Format depthFormat = vk::Format::eD32Sfloat;
+        vk::Format stencilFormat = vk::Format::eUndefined;
+        vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1;
+
+        SecondaryRenderingInfo() = default;
+        SecondaryRenderingInfo(const VulkanInitData &vkInitData) {
+            colorFormats = { vkInitData.swapchain().format };
+        };
+    };
+
+    // Records item indices [begin, end) into a secondary command buffer
+    using SecondaryRecordFunc = std::function<void(vk::CommandBuffer&, size_t, size_t)>;
+
     ///////////////////////////////////////////////////////////////////////////
     // FUNCTIONS 
     ///////////////////////////////////////////////////////////////////////////
@@ -70,12 +100,23 @@ namespace pro {
         return vkInitData.device().createSemaphore(createInfo);
     };
 
+    inline vk::Semaphore createVulkanTimelineSemaphore(
+        VulkanInitData &vkInitData,
+        uint64_t initialValue = 0) {
+
+        vk::SemaphoreTypeCreateInfo typeInfo(vk::SemaphoreType::eTimeline, initialValue);
+        vk::SemaphoreCreateInfo createInfo {};
+        createInfo.setPNext(&typeInfo);
+        return vkInitData.device().createSemaphore(createInfo);
+    };
+
     inline void cleanupVulkanSemaphore(VulkanInitData &vkInitData, vk::Semaphore &s) {
         vkInitData.device().destroySemaphore(s);
         s = vk::Semaphore();
     };
 
-    inline FrameCommandData createFrameCommandData(VulkanInitData &vkInitData) {
+    // timestampQueryCnt > 0 also creates a timestamp query pool (if the graphics queue supports timestamps)
+    inline FrameCommandData createFrameCommandData(VulkanInitData &vkInitData, uint32_t timestampQueryCnt = 0) {
 
         // Initial struct
         FrameCommandData commandData {};
@@ -91,6 +132,21 @@ namespace pro {
         
         // Create fence
         commandData.inFlight = createVulkanFence(vkInitData);        
+
+        // Create timestamp queries
+        if(timestampQueryCnt > 0) {
+            auto allFamilies = vkInitData.physicalDevice().getQueueFamilyProperties();
+            if(allFamilies.at(vkInitData.graphicsQueue().index).timestampValidBits == 0) {
+                print_warning("createFrameCommandData", "Graphics queue does not support timestamps!");
+            }
+            else {
+                vk::QueryPoolCreateInfo queryInfo {};
+                queryInfo.queryType = vk::QueryType::eTimestamp;
+                queryInfo.queryCount = timestampQueryCnt;
+                commandData.timestampPool = vkInitData.device().createQueryPool(queryInfo);
+                commandData.timestampQueryCnt = timestampQueryCnt;
+            }
+        }
         
         // Return data
         return commandData;
@@ -100,12 +156,16 @@ namespace pro {
         cleanupVulkanFence(vkInitData, commandData.inFlight);        
         cleanupVulkanSemaphore(vkInitData, commandData.imageAvailable);
         cleanupVulkanCommandPool(vkInitData, commandData.commandPool);
+        if(commandData.timestampPool) {
+            vkInitData.device().destroyQueryPool(commandData.timestampPool);
+        }
         commandData = {};
     };
      
     inline unsigned int acquireNextSwapImage(   VulkanInitData &vkInitData, 
                                                 FrameCommandData &commandData,
                                                 OnResizeFunc resizeFunc) {
+        PRO_PROFILE_SCOPE("acquireNextSwapImage");
 
         // Before a frame-in-flight can start rendering, it needs:
         // - CPU must wait until command buffer has finished all rendering commands (GPU)
@@ -147,16 +207,27 @@ namespace pro {
     inline void submitToGraphicsQueue(  VulkanInitData &vkInitData, 
                                         FrameCommandData &commandData,
                                         unsigned int indexSwap,
-                                        OnResizeFunc resizeFunc) {
+                                        OnResizeFunc resizeFunc,
+                                        const vector<TimelineWait> &extraWaits = {}) {
+        PRO_PROFILE_SCOPE("submitToGraphicsQueue");
 
         // With our submission of render commands, we want:
         // - To WAIT until the swap image is actually available
+        // - To WAIT on any extra timeline semaphores (e.g., uploads from the TransferManager)
         // - When we're done, to SIGNAL the (PER SWAP IMAGE) render finished semaphore
 
         // Set up our semaphores and stages to wait on
-        vk::Semaphore waitSemaphores[] = {commandData.imageAvailable};
+        vector<vk::Semaphore> waitSemaphores = {commandData.imageAvailable};
+        vector<vk::PipelineStageFlags> waitStages = {vk::PipelineStageFlagBits::eAllCommands}; //eColorAttachmentOutput};
+        vector<uint64_t> waitValues = {0};  // Ignored for binary semaphores
         vk::Semaphore signalSemaphores[] = {vkInitData.swapchain().swaps[indexSwap].renderDone};
-        vk::PipelineStageFlags waitStages[] = {vk::PipelineStageFlagBits::eAllCommands}; //eColorAttachmentOutput};
+        uint64_t signalValues[] = {0};
+
+        for(auto &wait : extraWaits) {
+            waitSemaphores.push_back(wait.semaphore);
+            waitStages.push_back(wait.stage);
+            waitValues.push_back(wait.value);
+        }
 
         // Prepare submission and submit
         // (Noting that we will also signal the fence as well)
@@ -165,14 +236,44 @@ namespace pro {
             waitStages,
             commandData.commandBuffer,
             signalSemaphores);
+
+        vk::TimelineSemaphoreSubmitInfo timelineInfo(waitValues, signalValues);
+        if(!extraWaits.empty()) {
+            submitInfo.setPNext(&timelineInfo);
+        }
                     
         vkInitData.graphicsQueue().queue.submit(submitInfo, commandData.inFlight);            
     };
 
+    // Headless/offscreen version (no swap image to wait on or signal)
+    inline void submitOffscreenToGraphicsQueue( VulkanInitData &vkInitData, 
+                                                FrameCommandData &commandData,
+                                                const vector<TimelineWait> &extraWaits = {}) {
+        PRO_PROFILE_SCOPE("submitOffscreenToGraphicsQueue");
+
+        vector<vk::Semaphore> waitSemaphores {};
+        vector<vk::PipelineStageFlags> waitStages {};
+        vector<uint64_t> waitValues {};
+        for(auto &wait : extraWaits) {
+            waitSemaphores.push_back(wait.semaphore);
+            waitStages.push_back(wait.stage);
+            waitValues.push_back(wait.value);
+        }
+
+        vk::SubmitInfo submitInfo(waitSemaphores, waitStages, commandData.commandBuffer);
+        vk::TimelineSemaphoreSubmitInfo timelineInfo(waitValues, {});
+        if(!extraWaits.empty()) {
+            submitInfo.setPNext(&timelineInfo);
+        }
+
+        vkInitData.graphicsQueue().queue.submit(submitInfo, commandData.inFlight);
+    };
+
     inline bool presentSwapImage(   VulkanInitData &vkInitData, 
                                     FrameCommandData &commandData,
                                     unsigned int indexSwap,
                                     OnResizeFunc resizeFunc) {
+        PRO_PROFILE_SCOPE("presentSwapImage");
 
         vk::PresentInfoKHR presentInfo {};
         presentInfo.setWaitSemaphores(vkInitData.swapchain().swaps[indexSwap].renderDone);
@@ -196,4 +297,226 @@ namespace pro {
 
         return successPresent;
     };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES 
+    ///////////////////////////////////////////////////////////////////////////  
+
+    class FrameRing {
+    private:
+        VulkanInitData *refInitData;                // Do NOT clean up!!!
+        vector<FrameCommandData> allFrames {};      // Cleaned up explicitly
+        vector<VulkanImage> allDepthImages {};      // Cleaned up explicitly
+        vector<vk::Fence> swapImageFences {};       // Do NOT clean up (owned by allFrames)
+        unsigned int indexFlight = 0;
+        float lastWaitSeconds = 0.0f;
+
+    public:
+        // timestampQueryCnt: per frame-in-flight, for a GPUProfiler (0 = none)
+        FrameRing(VulkanInitData &vkInitData, unsigned int numberFramesInFlight = 2, uint32_t timestampQueryCnt = 0) {
+            // Store init data
+            refInitData = &vkInitData;
+
+            // Need at least one frame...
+            if(numberFramesInFlight == 0) {
+                print_and_throw_error("FrameRing", "Must have at least one frame in flight!");
+            }
+
+            // Create command data for each frame-in-flight
+            for(unsigned int i = 0; i < numberFramesInFlight; i++) {
+                allFrames.push_back(createFrameCommandData(*refInitData, timestampQueryCnt));
+            }
+
+            // Create depth images for each frame-in-flight
+            recreateDepthImages();
+        };
+
+        ~FrameRing() {
+            refInitData->device().waitIdle();
+            for(auto &frame : allFrames) {
+                cleanupFrameCommandData(*refInitData, frame);
+            }
+            allFrames.clear();
+            cleanupAllVulkanDepthImages(*refInitData, allDepthImages);
+        };
+
+        // Copy: forbidden (unique ownership)
+        FrameRing(const FrameRing&)            = delete;
+        FrameRing& operator=(const FrameRing&) = delete;
+
+        // Getters
+        unsigned int size() const noexcept { return (unsigned int)allFrames.size(); };
+        unsigned int index() const noexcept { return indexFlight; };
+        FrameCommandData& current() { return allFrames.at(indexFlight); };
+        VulkanImage& currentDepthImage() { return allDepthImages.at(indexFlight); };
+
+        // How long the CPU blocked on fences during the last acquire()
+        float getLastWaitSeconds() const noexcept { return lastWaitSeconds; };
+
+        // Call after the swapchain is (re)created
+        void recreateDepthImages() {
+            recreateAllVulkanDepthImages(*refInitData, allDepthImages, (int)allFrames.size());
+
+            // Swap image count may have changed; all old frames are done anyway (device idle)
+            swapImageFences.assign(refInitData->swapchain().swaps.size(), vk::Fence());
+        };
+
+        unsigned int acquire(OnResizeFunc resizeFunc) {
+            PRO_PROFILE_SCOPE("FrameRing::acquire");
+            FrameCommandData &frame = current();
+
+            // Wait for THIS frame-in-flight to finish its previous use
+            // (timed separately; the wait inside acquireNextSwapImage() then returns immediately)
+            auto startWait = getTime();
+            refInitData->device().waitForFences(frame.inFlight, true, UINT64_MAX);
+            lastWaitSeconds = getElapsedSeconds(startWait, getTime());
+
+            unsigned int indexSwap = acquireNextSwapImage(*refInitData, frame, resizeFunc);
+
+            // A resize may have changed the number of swap images
+            if(swapImageFences.size() != refInitData->swapchain().swaps.size()) {
+                swapImageFences.assign(refInitData->swapchain().swaps.size(), vk::Fence());
+            }
+
+            // If more frames-in-flight than swap images (or acquire order is out of sync), 
+            // a different frame may still be rendering to this swap image
+            vk::Fence &imageFence = swapImageFences.at(indexSwap);
+            if(imageFence && imageFence != frame.inFlight) {
+                auto startImageWait = getTime();
+                refInitData->device().waitForFences(imageFence, true, UINT64_MAX);
+                lastWaitSeconds += getElapsedSeconds(startImageWait, getTime());
+            }
+            imageFence = frame.inFlight;
+            
+            return indexSwap;
+        };
+
+        void submit(unsigned int indexSwap, 
+                    OnResizeFunc resizeFunc, 
+                    const vector<TimelineWait> &extraWaits = {}) {
+            submitToGraphicsQueue(*refInitData, current(), indexSwap, resizeFunc, extraWaits);
+        };
+
+        bool present(unsigned int indexSwap, OnResizeFunc resizeFunc) {
+            bool success = presentSwapImage(*refInitData, current(), indexSwap, resizeFunc);
+            
+            // Move to the next frame-in-flight
+            indexFlight = (indexFlight + 1) % allFrames.size();
+            return success;
+        };
+    };
+
+    // Records one pass's draws as jobs on a JobSystem.
+    // Each slice owns a command pool per frame in flight and records a secondary command buffer 
+    // for its part of the items; the primary then executes them all (in slice order).
+    // Per frame, inside beginRendering() with vk::RenderingFlagBits::eContentsSecondaryCommandBuffers:
+    //  - record(primary, indexFrame, renderingInfo, itemCnt, func)
+    // Secondaries start with NO state: func must bind the pipeline, set viewport/scissors, etc.
+    class ParallelCommandRecorder {
+    private:
+        VulkanInitData *refInitData;                        // Do NOT clean up!!!
+        JobSystem *refJobs;                                 // Do NOT clean up!!!
+        vector<vector<vk::CommandPool>> allPools {};        // [frame][slice]; Cleaned up explicitly
+        vector<vector<vk::CommandBuffer>> allBuffers {};    // [frame][slice]; No NEED to clean up (freed with pools)
+        unsigned int sliceCnt = 1;
+
+        void recordSlice(   unsigned int slice,
+                            unsigned int indexFrame,
+                            const vk::CommandBufferInheritanceInfo &inheritance,
+                            size_t itemCnt,
+                            const SecondaryRecordFunc &func) {
+            PRO_PROFILE_SCOPE("recordSecondary");
+
+            // Only this slice uses this pool, and the frame's fence has signaled
+            refInitData->device().resetCommandPool(allPools[indexFrame][slice]);
+
+            vk::CommandBuffer &cmd = allBuffers[indexFrame][slice];
+            cmd.begin(vk::CommandBufferBeginInfo(
+                        vk::CommandBufferUsageFlagBits::eOneTimeSubmit
+                        | vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+                        &inheritance));
+
+            size_t begin = itemCnt * slice / sliceCnt;
+            size_t end = itemCnt * (slice + 1) / sliceCnt;
+            if(begin < end) {
+                func(cmd, begin, end);
+            }
+            cmd.end();
+        };
+
+    public:
+        // threadCnt: number of slices (0 = one per thread of jobs)
+        ParallelCommandRecorder(VulkanInitData &vkInitData, 
+                                unsigned int numberFramesInFlight = 2, 
+                                unsigned int threadCnt = 0,
+                                JobSystem &jobs = JobSystem::getDefault()) {
+            refInitData = &vkInitData;
+            refJobs = &jobs;
+            sliceCnt = (threadCnt == 0) ? jobs.getThreadCnt() : threadCnt;
+
+            if(numberFramesInFlight == 0) {
+                print_and_throw_error("ParallelCommandRecorder", "Must have at least one frame in flight!");
+            }
+
+            for(unsigned int f = 0; f < numberFramesInFlight; f++) {
+                allPools.push_back({});
+                allBuffers.push_back({});
+                for(unsigned int s = 0; s < sliceCnt; s++) {
+                    // Reset as a whole each frame
+                    vk::CommandPool pool = createVulkanCommandPool(*refInitData, refInitData->graphicsQueue().index, {});
+                    allPools.back().push_back(pool);
+                    allBuffers.back().push_back(createVulkanCommandBuffers(
+                                                    *refInitData, pool, vk::CommandBufferLevel::eSecondary).front());
+                }
+            }
+        };
+
+        ~ParallelCommandRecorder() {
+            // Frames in flight may still use any of these
+            refInitData->device().waitIdle();
+            for(auto &framePools : allPools) {
+                for(auto &pool : framePools) {
+                    cleanupVulkanCommandPool(*refInitData, pool);
+                }
+            }
+        };
+
+        // Copy: forbidden (unique ownership)
+        ParallelCommandRecorder(const ParallelCommandRecorder&)            = delete;
+        ParallelCommandRecorder& operator=(const ParallelCommandRecorder&) = delete;
+
+        unsigned int getThreadCnt() const noexcept { return sliceCnt; };
+        unsigned int getFramesInFlight() const noexcept { return (unsigned int)allPools.size(); };
+
+        // Blocks until every slice is recorded, then executes them in the primary.
+        // indexFrame: frame-in-flight whose fence has signaled (e.g., FrameRing::index())
+        void record(vk::CommandBuffer &primary,
+                    unsigned int indexFrame,
+                    const SecondaryRenderingInfo &renderingInfo,
+                    size_t itemCnt,
+                    const SecondaryRecordFunc &func) {
+            PRO_PROFILE_SCOPE("ParallelCommandRecorder::record");
+
+            if(indexFrame >= allPools.size()) {
+                print_and_throw_error("ParallelCommandRecorder", "Invalid frame-in-flight index: " + to_string(indexFrame));
+            }
+
+            vk::CommandBufferInheritanceRenderingInfo inheritRendering {};
+            inheritRendering.setColorAttachmentFormats(renderingInfo.colorFormats)
+                            .setDepthAttachmentFormat(renderingInfo.depthFormat)
+                            .setStencilAttachmentFormat(renderingInfo.stencilFormat)
+                            .setRasterizationSamples(renderingInfo.samples);
+            vk::CommandBufferInheritanceInfo inheritance {};
+            inheritance.setPNext(&inheritRendering);
+
+            // One job per slice (the calling thread records some too); rethrows the first error
+            refJobs->parallelFor(sliceCnt, [&](size_t begin, size_t end) {
+                for(size_t slice = begin; slice < end; slice++) {
+                    recordSlice((unsigned int)slice, indexFrame, inheritance, itemCnt, func);
+                }
+            }, 1);
+
+            primary.executeCommands(allBuffers[indexFrame]);
+        };
+    };
 }
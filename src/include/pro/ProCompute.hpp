@@ -0,0 +1,189 @@
+#pragma once
+#include "ProPipeline.hpp"
+#include "ProCommand.hpp"
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Makes shader writes from earlier dispatches visible to later commands in the SAME queue
+    inline void recordComputeBarrier(   vk::CommandBuffer &commandBuffer,
+                                        vk::PipelineStageFlags dstStage = vk::PipelineStageFlagBits::eComputeShader,
+                                        vk::AccessFlags dstAccess = vk::AccessFlagBits::eShaderRead
+                                                                    | vk::AccessFlagBits::eShaderWrite) {
+        vk::MemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite, dstAccess);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, dstStage, {}, barrier, {}, {});
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Records and submits compute work on the compute queue (the dedicated one if the device has it,
+    // so it can overlap graphics), then hands it to graphics through a timeline semaphore.
+    // Per frame in flight (AFTER that frame's graphics fence has signaled, e.g., FrameRing::acquire()):
+    //  - begin(frame): waits for this slot's previous compute submission, returns its command buffer
+    //  - record dispatches, then releaseBuffer() for every buffer graphics will read
+    //  - submit(frame) --> TimelineWait for submitToGraphicsQueue()/FrameRing::submit()
+    //  - recordAcquireBarriers(graphicsCommandBuffer) before graphics uses the buffers
+    // Needs the (Vulkan 1.2) timelineSemaphore feature.
+    class AsyncCompute {
+    private:
+        struct ComputeFrame {
+            vk::CommandPool commandPool {};
+            vk::CommandBuffer commandBuffer {};
+            uint64_t ticket = 0;                // Signaled when this slot's last submission is done
+        };
+
+        VulkanInitData *refInitData;            // Do NOT clean up!!!
+        VulkanQueue queue {};                   // No NEED to clean up
+        vector<ComputeFrame> allFrames {};      // Cleaned up explicitly
+        vk::Semaphore timeline {};              // Cleaned up explicitly
+        uint64_t lastTicket = 0;
+
+        // Queue family ownership transfers (only if the families differ)
+        vector<vk::BufferMemoryBarrier> allAcquireBarriers {};
+        vk::PipelineStageFlags acquireStages {};
+        int currentFrame = -1;
+
+    public:
+        AsyncCompute(VulkanInitData &vkInitData, unsigned int numberFramesInFlight = 2) {
+            refInitData = &vkInitData;
+
+            if(numberFramesInFlight == 0) {
+                print_and_throw_error("AsyncCompute", "Must have at least one frame in flight!");
+            }
+
+            // Fall back to the graphics queue (still correct, just no overlap)
+            queue = refInitData->isComputeQueueValid() ? refInitData->computeQueue() : refInitData->graphicsQueue();
+
+            for(unsigned int i = 0; i < numberFramesInFlight; i++) {
+                ComputeFrame frame {};
+                frame.commandPool = createVulkanCommandPool(*refInitData, queue.index);
+                frame.commandBuffer = createVulkanCommandBuffers(*refInitData, frame.commandPool).front();
+                allFrames.push_back(frame);
+            }
+
+            timeline = createVulkanTimelineSemaphore(*refInitData, 0);
+        };
+
+        ~AsyncCompute() {
+            waitForTicket(lastTicket);
+            for(auto &frame : allFrames) {
+                cleanupVulkanCommandPool(*refInitData, frame.commandPool);
+            }
+            allFrames.clear();
+            cleanupVulkanSemaphore(*refInitData, timeline);
+        };
+
+        // Copy: forbidden (unique ownership)
+        AsyncCompute(const AsyncCompute&)            = delete;
+        AsyncCompute& operator=(const AsyncCompute&) = delete;
+
+        // True if compute work runs on a different queue than graphics
+        bool isAsync() const noexcept { return queue.queue != refInitData->graphicsQueue().queue; };
+        bool needsOwnershipTransfer() const noexcept { return queue.index != refInitData->graphicsQueue().index; };
+        const VulkanQueue& getQueue() const noexcept { return queue; };
+
+        vk::CommandBuffer& begin(unsigned int indexFrame) {
+            ComputeFrame &frame = allFrames.at(indexFrame);
+            waitForTicket(frame.ticket);
+
+            refInitData->device().resetCommandPool(frame.commandPool);
+            frame.commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+            allAcquireBarriers.clear();
+            acquireStages = {};
+            currentFrame = (int)indexFrame;
+            return frame.commandBuffer;
+        };
+
+        // Call after the last compute write to buffer (before submit());
+        // dstStage/dstAccess: how graphics will use it (e.g., eDrawIndirect/eIndirectCommandRead)
+        void releaseBuffer( const VulkanBuffer &buffer,
+                            vk::PipelineStageFlags dstStage,
+                            vk::AccessFlags dstAccess,
+                            vk::PipelineStageFlags srcStage = vk::PipelineStageFlagBits::eComputeShader,
+                            vk::AccessFlags srcAccess = vk::AccessFlagBits::eShaderWrite) {
+            if(currentFrame < 0) {
+                print_and_throw_error("AsyncCompute", "releaseBuffer() must be called between begin() and submit()!");
+            }
+            acquireStages |= dstStage;
+            if(!needsOwnershipTransfer()) {
+                // The semaphore alone makes the writes visible
+                return;
+            }
+
+            vk::BufferMemoryBarrier release {};
+            release.srcAccessMask = srcAccess;
+            release.dstAccessMask = {};
+            release.srcQueueFamilyIndex = queue.index;
+            release.dstQueueFamilyIndex = refInitData->graphicsQueue().index;
+            release.buffer = buffer.buffer;
+            release.offset = 0;
+            release.size = VK_WHOLE_SIZE;
+            allFrames.at(currentFrame).commandBuffer.pipelineBarrier(
+                srcStage, vk::PipelineStageFlagBits::eBottomOfPipe, {}, {}, release, {});
+
+            vk::BufferMemoryBarrier acquire = release;
+            acquire.srcAccessMask = {};
+            acquire.dstAccessMask = dstAccess;
+            allAcquireBarriers.push_back(acquire);
+        };
+
+        // Returns the wait the graphics submission must include
+        TimelineWait submit(unsigned int indexFrame, const vector<TimelineWait> &extraWaits = {}) {
+            ComputeFrame &frame = allFrames.at(indexFrame);
+            frame.commandBuffer.end();
+
+            vector<vk::Semaphore> waitSemaphores {};
+            vector<vk::PipelineStageFlags> waitStages {};
+            vector<uint64_t> waitValues {};
+            for(auto &wait : extraWaits) {
+                waitSemaphores.push_back(wait.semaphore);
+                waitStages.push_back(wait.stage);
+                waitValues.push_back(wait.value);
+            }
+
+            frame.ticket = ++lastTicket;
+            vk::SubmitInfo submitInfo(waitSemaphores, waitStages, frame.commandBuffer, timeline);
+            vk::TimelineSemaphoreSubmitInfo timelineInfo(waitValues, frame.ticket);
+            submitInfo.setPNext(&timelineInfo);
+            queue.queue.submit(submitInfo);
+            currentFrame = -1;
+
+            TimelineWait wait {};
+            wait.semaphore = timeline;
+            wait.value = frame.ticket;
+            wait.stage = acquireStages ? acquireStages : vk::PipelineStageFlags(vk::PipelineStageFlagBits::eAllCommands);
+            return wait;
+        };
+
+        // Graphics side of the ownership transfers from the last submit() (no-op if none are needed)
+        void recordAcquireBarriers(vk::CommandBuffer &graphicsCommandBuffer) {
+            if(allAcquireBarriers.empty()) {
+                return;
+            }
+            // Same stages as the semaphore wait, so the barrier chains after it
+            graphicsCommandBuffer.pipelineBarrier(  acquireStages, acquireStages,
+                                                    {}, {}, allAcquireBarriers, {});
+            allAcquireBarriers.clear();
+        };
+
+        uint64_t getCompletedTicket() {
+            return refInitData->device().getSemaphoreCounterValue(timeline);
+        };
+
+        void waitForTicket(uint64_t ticket) {
+            if(ticket == 0) {
+                return;
+            }
+            vk::SemaphoreWaitInfo waitInfo({}, timeline, ticket);
+            vk::Result res = refInitData->device().waitSemaphores(waitInfo, UINT64_MAX);
+            if(res != vk::Result::eSuccess) {
+                print_warning("AsyncCompute", "waitForTicket() did not succeed: " + vk::to_string(res));
+            }
+        };
+    };
+}
@@ -2,8 +2,11 @@
 
 #include <iostream>
 #include <vector>
+#include <deque>
 #include <string>
 #include <fstream>
+#include <filesystem>
+#include <cstring>
 #include <cstddef>
 #include <functional>
 #include <thread>
@@ -0,0 +1,303 @@
+#pragma once
+#include "ProMesh.hpp"
+#include <bit>
+
+#if defined(__AVX__)
+    #define PRO_USE_AVX 1
+    #include <immintrin.h>
+#endif
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Planes are (normal, d) with normals pointing INTO the frustum (inside: dot(n, p) + d >= 0)
+    struct Frustum {
+        glm::vec4 planes[6] {};     // Left, right, bottom, top, near, far
+    };
+
+    enum CULL_TEST {
+        CULL_SPHERE,                // Cheapest, loosest
+        CULL_AABB,
+        CULL_SPHERE_AND_AABB        // Must pass both
+    };
+
+    // MeshBounds placed in the world with a model matrix
+    struct WorldBounds {
+        glm::vec3 sphereCenter {0,0,0};
+        float sphereRadius = 0.0f;
+        glm::vec3 boxCenter {0,0,0};
+        glm::vec3 boxExtent {0,0,0};    // Half-extents
+
+        WorldBounds() = default;
+
+        WorldBounds(const MeshBounds &bounds, const glm::mat4 &model = glm::mat4(1.0f)) {
+            // Sphere: move center, scale radius by the largest axis scale
+            sphereCenter = glm::vec3(model * glm::vec4(bounds.center, 1.0f));
+            float maxScale = max(glm::length(glm::vec3(model[0])), max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+            sphereRadius = bounds.radius * maxScale;
+
+            // AABB (Arvo): new half-extents = |upper 3x3| * half-extents
+            boxCenter = glm::vec3(model * glm::vec4((bounds.minPos + bounds.maxPos) * 0.5f, 1.0f));
+            glm::vec3 halfExtent = (bounds.maxPos - bounds.minPos) * 0.5f;
+            boxExtent = glm::abs(glm::vec3(model[0])) * halfExtent.x
+                        + glm::abs(glm::vec3(model[1])) * halfExtent.y
+                        + glm::abs(glm::vec3(model[2])) * halfExtent.z;
+        };
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    // World-space bounds of many objects, stored as structure-of-arrays so they can be tested 8 at a time.
+    // Arrays are padded with zeros to a multiple of 8.
+    class BoundsSoA {
+    private:
+        size_t count = 0;
+
+        void resizeArrays(size_t newCount) {
+            size_t padded = (newCount + 7) & ~size_t(7);
+            for(auto *a : { &sphereX, &sphereY, &sphereZ, &sphereR, &boxX, &boxY, &boxZ, &extentX, &extentY, &extentZ }) {
+                a->resize(padded, 0.0f);
+            }
+        };
+
+    public:
+        // Bounding spheres
+        vector<float> sphereX {}, sphereY {}, sphereZ {}, sphereR {};
+        // AABBs as center and half-extents
+        vector<float> boxX {}, boxY {}, boxZ {};
+        vector<float> extentX {}, extentY {}, extentZ {};
+
+        size_t size() const noexcept { return count; };
+        size_t paddedSize() const noexcept { return sphereX.size(); };
+
+        void reserve(size_t capacity) {
+            size_t padded = (capacity + 7) & ~size_t(7);
+            for(auto *a : { &sphereX, &sphereY, &sphereZ, &sphereR, &boxX, &boxY, &boxZ, &extentX, &extentY, &extentZ }) {
+                a->reserve(padded);
+            }
+        };
+
+        void clear() {
+            count = 0;
+            resizeArrays(0);
+        };
+
+        // Object-space bounds placed with model; returns the object's index
+        uint32_t add(const MeshBounds &bounds, const glm::mat4 &model = glm::mat4(1.0f)) {
+            resizeArrays(count + 1);
+            set(count, bounds, model);
+            return (uint32_t)(count++);
+        };
+
+        void set(size_t index, const MeshBounds &bounds, const glm::mat4 &model = glm::mat4(1.0f)) {
+            WorldBounds world(bounds, model);
+            sphereX[index] = world.sphereCenter.x;
+            sphereY[index] = world.sphereCenter.y;
+            sphereZ[index] = world.sphereCenter.z;
+            sphereR[index] = world.sphereRadius;
+            boxX[index] = world.boxCenter.x;
+            boxY[index] = world.boxCenter.y;
+            boxZ[index] = world.boxCenter.z;
+            extentX[index] = world.boxExtent.x;
+            extentY[index] = world.boxExtent.y;
+            extentZ[index] = world.boxExtent.z;
+        };
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // HELPER FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    inline bool isSphereInFrustum(const Frustum &frustum, const BoundsSoA &bounds, size_t i) {
+        for(const glm::vec4 &p : frustum.planes) {
+            if(p.x*bounds.sphereX[i] + p.y*bounds.sphereY[i] + p.z*bounds.sphereZ[i] + p.w < -bounds.sphereR[i]) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    inline bool isBoxInFrustum(const Frustum &frustum, const BoundsSoA &bounds, size_t i) {
+        for(const glm::vec4 &p : frustum.planes) {
+            float d = p.x*bounds.boxX[i] + p.y*bounds.boxY[i] + p.z*bounds.boxZ[i] + p.w;
+            float r = abs(p.x)*bounds.extentX[i] + abs(p.y)*bounds.extentY[i] + abs(p.z)*bounds.extentZ[i];
+            if(d < -r) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Appends base + (index of each set bit)
+    inline void appendVisibleBits(uint32_t mask, size_t base, vector<uint32_t> &visible) {
+        while(mask) {
+            visible.push_back((uint32_t)base + (uint32_t)countr_zero(mask));
+            mask &= mask - 1;
+        }
+    };
+
+    #if defined(PRO_USE_AVX)
+    inline uint32_t cullBatchAVX(const Frustum &frustum, const BoundsSoA &bounds, size_t i, CULL_TEST test) {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+        if(test != CULL_AABB) {
+            __m256 x = _mm256_loadu_ps(&bounds.sphereX[i]);
+            __m256 y = _mm256_loadu_ps(&bounds.sphereY[i]);
+            __m256 z = _mm256_loadu_ps(&bounds.sphereZ[i]);
+            __m256 negR = _mm256_xor_ps(_mm256_loadu_ps(&bounds.sphereR[i]), signMask);
+            for(const glm::vec4 &p : frustum.planes) {
+                __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(p.x)),
+                                                       _mm256_mul_ps(y, _mm256_set1_ps(p.y))),
+                                         _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(p.z)), _mm256_set1_ps(p.w)));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negR, _CMP_GE_OQ));
+            }
+        }
+
+        if(test != CULL_SPHERE && _mm256_movemask_ps(inside) != 0) {
+            __m256 x = _mm256_loadu_ps(&bounds.boxX[i]);
+            __m256 y = _mm256_loadu_ps(&bounds.boxY[i]);
+            __m256 z = _mm256_loadu_ps(&bounds.boxZ[i]);
+            __m256 ex = _mm256_loadu_ps(&bounds.extentX[i]);
+            __m256 ey = _mm256_loadu_ps(&bounds.extentY[i]);
+            __m256 ez = _mm256_loadu_ps(&bounds.extentZ[i]);
+            for(const glm::vec4 &p : frustum.planes) {
+                __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(p.x)),
+                                                       _mm256_mul_ps(y, _mm256_set1_ps(p.y))),
+                                         _mm256_add_ps(_mm256_mul_ps(z, _mm256_set1_ps(p.z)), _mm256_set1_ps(p.w)));
+                __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, _mm256_set1_ps(abs(p.x))),
+                                                       _mm256_mul_ps(ey, _mm256_set1_ps(abs(p.y)))),
+                                         _mm256_mul_ps(ez, _mm256_set1_ps(abs(p.z))));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_xor_ps(r, signMask), _CMP_GE_OQ));
+            }
+        }
+        return (uint32_t)_mm256_movemask_ps(inside);
+    };
+    #endif
+
+    #if defined(PRO_USE_SSE2)
+    inline uint32_t cullBatchSSE(const Frustum &frustum, const BoundsSoA &bounds, size_t i, CULL_TEST test) {
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+
+        if(test != CULL_AABB) {
+            __m128 x = _mm_loadu_ps(&bounds.sphereX[i]);
+            __m128 y = _mm_loadu_ps(&bounds.sphereY[i]);
+            __m128 z = _mm_loadu_ps(&bounds.sphereZ[i]);
+            __m128 negR = _mm_xor_ps(_mm_loadu_ps(&bounds.sphereR[i]), signMask);
+            for(const glm::vec4 &p : frustum.planes) {
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p.x)), _mm_mul_ps(y, _mm_set1_ps(p.y))),
+                                      _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(p.z)), _mm_set1_ps(p.w)));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+            }
+        }
+
+        if(test != CULL_SPHERE && _mm_movemask_ps(inside) != 0) {
+            __m128 x = _mm_loadu_ps(&bounds.boxX[i]);
+            __m128 y = _mm_loadu_ps(&bounds.boxY[i]);
+            __m128 z = _mm_loadu_ps(&bounds.boxZ[i]);
+            __m128 ex = _mm_loadu_ps(&bounds.extentX[i]);
+            __m128 ey = _mm_loadu_ps(&bounds.extentY[i]);
+            __m128 ez = _mm_loadu_ps(&bounds.extentZ[i]);
+            for(const glm::vec4 &p : frustum.planes) {
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p.x)), _mm_mul_ps(y, _mm_set1_ps(p.y))),
+                                      _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(p.z)), _mm_set1_ps(p.w)));
+                __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(abs(p.x))), _mm_mul_ps(ey, _mm_set1_ps(abs(p.y)))),
+                                      _mm_mul_ps(ez, _mm_set1_ps(abs(p.z))));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_xor_ps(r, signMask)));
+            }
+        }
+        return (uint32_t)_mm_movemask_ps(inside);
+    };
+    #endif
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Gribb/Hartmann plane extraction from projection * view (glm, column-major).
+    // zeroToOneDepth: Vulkan-style clip depth [0, 1] (otherwise OpenGL-style [-1, 1])
+    inline Frustum extractFrustum(const glm::mat4 &viewProj, bool zeroToOneDepth = true) {
+        auto row = [&viewProj](int i) {
+            return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+        };
+
+        Frustum frustum {};
+        frustum.planes[0] = row(3) + row(0);
+        frustum.planes[1] = row(3) - row(0);
+        frustum.planes[2] = row(3) + row(1);
+        frustum.planes[3] = row(3) - row(1);
+        frustum.planes[4] = zeroToOneDepth ? row(2) : (row(3) + row(2));
+        frustum.planes[5] = row(3) - row(2);
+
+        for(glm::vec4 &p : frustum.planes) {
+            float len = glm::length(glm::vec3(p));
+            if(len > 0.0f) {
+                p /= len;
+            }
+        }
+        return frustum;
+    };
+
+    // Scalar reference (one object)
+    inline bool isInFrustum(const Frustum &frustum, const BoundsSoA &bounds, size_t i, CULL_TEST test = CULL_SPHERE_AND_AABB) {
+        if(test != CULL_AABB && !isSphereInFrustum(frustum, bounds, i)) {
+            return false;
+        }
+        return test == CULL_SPHERE || isBoxInFrustum(frustum, bounds, i);
+    };
+
+    // Appends the indices in [begin, end) that are (possibly) visible, in order; returns how many.
+    // Uses AVX (8 per batch) or SSE2 (2 x 4 per batch) when compiled in, otherwise scalar code.
+    // Split [begin, end) over threads (e.g., JobSystem::parallelFor()) for very large counts.
+    inline size_t cullFrustum(  const Frustum &frustum,
+                                const BoundsSoA &bounds,
+                                vector<uint32_t> &visible,
+                                CULL_TEST test = CULL_SPHERE_AND_AABB,
+                                size_t begin = 0,
+                                size_t end = SIZE_MAX) {
+        end = min(end, bounds.size());
+        size_t startSize = visible.size();
+        if(begin >= end) {
+            return 0;
+        }
+        visible.reserve(startSize + (end - begin));
+
+        size_t i = begin;
+        #if defined(PRO_USE_AVX) || defined(PRO_USE_SSE2)
+            // Scalar up to a multiple of 8
+            for(; i < end && (i & 7) != 0; i++) {
+                if(isInFrustum(frustum, bounds, i, test)) {
+                    visible.push_back((uint32_t)i);
+                }
+            }
+
+            // Batches of 8 (arrays are padded, so the last batch can read past end)
+            for(; i < end; i += 8) {
+                #if defined(PRO_USE_AVX)
+                    uint32_t mask = cullBatchAVX(frustum, bounds, i, test);
+                #else
+                    uint32_t mask = cullBatchSSE(frustum, bounds, i, test)
+                                    | (cullBatchSSE(frustum, bounds, i + 4, test) << 4);
+                #endif
+                if(end - i < 8) {
+                    mask &= (1u << (end - i)) - 1;
+                }
+                appendVisibleBits(mask, i, visible);
+            }
+        #else
+            for(; i < end; i++) {
+                if(isInFrustum(frustum, bounds, i, test)) {
+                    visible.push_back((uint32_t)i);
+                }
+            }
+        #endif
+
+        return visible.size() - startSize;
+    };
+}
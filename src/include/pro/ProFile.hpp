@@ -0,0 +1,182 @@
+#pragma once
+#include "ProCore.hpp"
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES 
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Read-only memory-mapped file (whole file mapped at once)
+    class MappedFile {
+    private:
+        const char *data_ = nullptr;
+        size_t size_ = 0;
+
+        #ifdef _WIN32
+            HANDLE file_ = INVALID_HANDLE_VALUE;
+            HANDLE mapping_ = nullptr;
+        #endif
+
+        void close() {
+            #ifdef _WIN32
+                if(data_) UnmapViewOfFile(data_);
+                if(mapping_) CloseHandle(mapping_);
+                if(file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+                file_ = INVALID_HANDLE_VALUE;
+                mapping_ = nullptr;
+            #else
+                if(data_) munmap((void*)data_, size_);
+            #endif
+            data_ = nullptr;
+            size_ = 0;
+        };
+
+    public:
+        MappedFile() = default;
+
+        MappedFile(const string &filename) {
+            open(filename);
+        };
+
+        ~MappedFile() {
+            close();
+        };
+
+        // Copy: forbidden (unique ownership)
+        MappedFile(const MappedFile&)            = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Move: allowed
+        MappedFile(MappedFile &&other) noexcept {
+            *this = std::move(other);
+        };
+
+        MappedFile& operator=(MappedFile &&other) noexcept {
+            if(this != &other) {
+                close();
+                data_ = other.data_;
+                size_ = other.size_;
+                other.data_ = nullptr;
+                other.size_ = 0;
+                #ifdef _WIN32
+                    file_ = other.file_;
+                    mapping_ = other.mapping_;
+                    other.file_ = INVALID_HANDLE_VALUE;
+                    other.mapping_ = nullptr;
+                #endif
+            }
+            return *this;
+        };
+
+        // Returns false if the file cannot be opened/mapped
+        bool open(const string &filename) {
+            close();
+
+            #ifdef _WIN32
+                file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                    OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+                if(file_ == INVALID_HANDLE_VALUE) {
+                    return false;
+                }
+
+                LARGE_INTEGER fileSize {};
+                GetFileSizeEx(file_, &fileSize);
+                size_ = (size_t)fileSize.QuadPart;
+                if(size_ == 0) {
+                    // Cannot map empty files (but they are still "open")
+                    return true;
+                }
+
+                mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if(!mapping_) {
+                    close();
+                    return false;
+                }
+
+                data_ = (const char*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+                if(!data_) {
+                    close();
+                    return false;
+                }
+            #else
+                int fd = ::open(filename.c_str(), O_RDONLY);
+                if(fd < 0) {
+                    return false;
+                }
+
+                struct stat st {};
+                if(fstat(fd, &st) != 0) {
+                    ::close(fd);
+                    return false;
+                }
+                size_ = (size_t)st.st_size;
+                if(size_ == 0) {
+                    ::close(fd);
+                    return true;
+                }
+
+                void *ptr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                ::close(fd);    // Mapping stays valid after closing
+                if(ptr == MAP_FAILED) {
+                    size_ = 0;
+                    return false;
+                }
+                data_ = (const char*)ptr;
+
+                // We generally read front to back
+                madvise(ptr, size_, MADV_SEQUENTIAL);
+            #endif
+
+            return true;
+        };
+
+        const char* data() const noexcept { return data_; };
+        size_t size() const noexcept { return size_; };
+        bool empty() const noexcept { return size_ == 0; };
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // FNV-1a (64-bit)
+    inline uint64_t hashBytes(const char *data, size_t size) {
+        uint64_t hash = 14695981039346656037ull;
+        for(size_t i = 0; i < size; i++) {
+            hash ^= (uint8_t)data[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    };
+
+    inline bool hashFile(const string &filename, uint64_t &hash) {
+        MappedFile file;
+        if(!file.open(filename)) {
+            return false;
+        }
+        hash = hashBytes(file.data(), file.size());
+        return true;
+    };
+
+    inline int64_t getFileModifiedTime(const string &filename) {
+        error_code err;
+        auto t = filesystem::last_write_time(filename, err);
+        return err ? 0 : (int64_t)t.time_since_epoch().count();
+    };
+}
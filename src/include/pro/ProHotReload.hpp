@@ -0,0 +1,360 @@
+#pragma once
+#include "ProPipeline.hpp"
+#include <mutex>
+#include <memory>
+#include <map>
+#include <set>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// Shader hot-reload:
+//  - a background thread watches the .spv files of every added pipeline (plus any GLSL sources mapped to them)
+//    with inotify on Linux (polling elsewhere)
+//  - a changed source is recompiled to its .spv first; every pipeline using a changed .spv is rebuilt on that thread
+//  - beginFrame() swaps the rebuilt pipelines in at a frame boundary and destroys the old ones
+//    once every frame in flight that could still use them has finished
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // HELPER FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Rejects empty/half-written files (the compiler may still be writing)
+    inline bool isValidSPIRVFile(const string &filename) {
+        error_code ec;
+        uintmax_t size = filesystem::file_size(filename, ec);
+        if(ec || size < 20 || (size % 4) != 0) {
+            return false;
+        }
+
+        ifstream file(filename, ios::binary);
+        uint32_t magic = 0;
+        file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+        return file.good() && magic == 0x07230203;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Usage:
+    //  - addPipeline()/addComputePipeline() instead of createVulkanPipeline()/createVulkanComputePipeline()
+    //  - get(id) whenever binding (the pipeline may change between frames)
+    //  - beginFrame() once per frame, AFTER FrameRing::acquire() and BEFORE recording
+    // The reloader owns the pipelines (and their descriptor set layouts, like cleanupVulkanPipeline()).
+    class ShaderHotReloader {
+    private:
+        struct HotPipeline {
+            unique_ptr<VulkanPipelineCreateInfo> graphicsInfo {};
+            unique_ptr<VulkanComputePipelineCreateInfo> computeInfo {};
+            VulkanPipelineData live {};             // Cleaned up explicitly
+            VulkanPipelineData pending {};          // Cleaned up explicitly
+            bool hasPending = false;
+        };
+
+        struct RetiredPipeline {
+            VulkanPipelineData data {};
+            uint64_t retireFrame = 0;
+        };
+
+        VulkanInitData *refInitData;                // Do NOT clean up!!!
+        unsigned int numberFramesInFlight = 2;
+        string compilerCommand = "glslc";
+
+        mutex lock {};
+        vector<unique_ptr<HotPipeline>> allPipelines {};    // Cleaned up explicitly
+        vector<RetiredPipeline> allRetired {};              // Cleaned up explicitly
+        map<string, string> sourceToSPV {};
+        map<string, filesystem::file_time_type> allStamps {};
+        set<string> allWatchedDirs {};
+        uint64_t frameCnt = 0;
+
+        thread watcher {};
+        atomic<bool> isStopping = false;
+        int inotifyFD = -1;                         // Cleaned up explicitly
+
+        static filesystem::file_time_type getStamp(const string &filename) {
+            error_code ec;
+            auto stamp = filesystem::last_write_time(filename, ec);
+            return ec ? filesystem::file_time_type::min() : stamp;
+        };
+
+        // Call with lock held
+        void watchFile(const string &filename) {
+            allStamps[filename] = getStamp(filename);
+
+            // Editors/compilers often replace files, so watch the directory instead of the file
+            string dir = filesystem::absolute(filename).parent_path().string();
+            if(!allWatchedDirs.insert(dir).second) {
+                return;
+            }
+#ifdef __linux__
+            if(inotifyFD >= 0 && inotify_add_watch(inotifyFD, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+                print_warning("ShaderHotReloader", "Cannot watch " + dir + " (falling back to polling it)");
+            }
+#endif
+        };
+
+        size_t addEntry(unique_ptr<HotPipeline> entry, const vector<string> &allSPVFiles) {
+            lock_guard<mutex> guard(lock);
+            for(auto &filename : allSPVFiles) {
+                watchFile(filename);
+            }
+            allPipelines.push_back(std::move(entry));
+            return allPipelines.size() - 1;
+        };
+
+        // Blocks until something MAY have changed (or the poll period passes)
+        void waitForChanges() {
+            const int periodMS = 250;
+#ifdef __linux__
+            if(inotifyFD >= 0) {
+                pollfd pfd { inotifyFD, POLLIN, 0 };
+                if(poll(&pfd, 1, periodMS) > 0) {
+                    // Let the writer finish, then drain; the timestamps say WHAT changed
+                    this_thread::sleep_for(chrono::milliseconds(50));
+                    alignas(inotify_event) char buffer[4096];
+                    while(read(inotifyFD, buffer, sizeof(buffer)) > 0) {}
+                }
+                return;
+            }
+#endif
+            this_thread::sleep_for(chrono::milliseconds(periodMS));
+        };
+
+        void checkForChanges() {
+            // Snapshot what to look at
+            map<string, filesystem::file_time_type> oldStamps {};
+            map<string, string> sources {};
+            vector<HotPipeline*> pipelines {};
+            {
+                lock_guard<mutex> guard(lock);
+                oldStamps = allStamps;
+                sources = sourceToSPV;
+                for(auto &p : allPipelines) {
+                    pipelines.push_back(p.get());
+                }
+            }
+
+            // Recompile changed sources (their .spv then counts as changed)
+            map<string, filesystem::file_time_type> newStamps {};
+            for(auto &[source, spv] : sources) {
+                auto stamp = getStamp(source);
+                newStamps[source] = stamp;
+                if(stamp == oldStamps[source]) {
+                    continue;
+                }
+
+                string cmd = compilerCommand + " \"" + source + "\" -o \"" + spv + "\"";
+                if(std::system(cmd.c_str()) != 0) {
+                    print_warning("ShaderHotReloader", "Failed to compile " + source + " (keeping the old pipelines)");
+                }
+            }
+
+            set<string> changedSPV {};
+            for(auto &[filename, stamp] : oldStamps) {
+                if(sources.count(filename)) {
+                    continue;
+                }
+                newStamps[filename] = getStamp(filename);
+                if(newStamps[filename] != stamp) {
+                    changedSPV.insert(filename);
+                }
+            }
+
+            // Rebuild outside the lock (the pipeline cache is internally synchronized)
+            for(auto *p : pipelines) {
+                vector<VulkanShaderCreateInfo> shaders = p->graphicsInfo ? p->graphicsInfo->shaderInfo
+                                                                         : vector<VulkanShaderCreateInfo> { p->computeInfo->shaderInfo };
+                bool isAffected = false;
+                bool isReady = true;
+                for(auto &shader : shaders) {
+                    isAffected = isAffected || changedSPV.count(shader.filename);
+                    isReady = isReady && isValidSPIRVFile(shader.filename);
+                }
+                if(!isAffected) {
+                    continue;
+                }
+                if(!isReady) {
+                    print_warning("ShaderHotReloader", "Invalid SPIR-V for " + shaders.front().filename + " (keeping the old pipeline)");
+                    continue;
+                }
+
+                VulkanPipelineData data {};
+                try {
+                    data = p->graphicsInfo ? createVulkanPipeline(*refInitData, *(p->graphicsInfo))
+                                           : createVulkanComputePipeline(*refInitData, *(p->computeInfo));
+                }
+                catch(exception &e) {
+                    print_warning("ShaderHotReloader", "Failed to rebuild pipeline with " + shaders.front().filename + ": " + e.what());
+                    continue;
+                }
+
+                lock_guard<mutex> guard(lock);
+                if(p->hasPending) {
+                    // Never swapped in, so the GPU never saw it
+                    cleanupVulkanPipelineOnly(*refInitData, p->pending);
+                }
+                p->pending = data;
+                p->hasPending = true;
+            }
+
+            lock_guard<mutex> guard(lock);
+            for(auto &[filename, stamp] : newStamps) {
+                allStamps[filename] = stamp;
+            }
+        };
+
+        void watchLoop() {
+            while(!isStopping) {
+                waitForChanges();
+                if(isStopping) {
+                    break;
+                }
+                checkForChanges();
+            }
+        };
+
+    public:
+        // compilerCommand: GLSL --> SPIR-V compiler, called as <compilerCommand> "<source>" -o "<spv>"
+        ShaderHotReloader(  VulkanInitData &vkInitData,
+                            unsigned int numberFramesInFlight = 2,
+                            string compilerCommand = "glslc") {
+            refInitData = &vkInitData;
+            this->numberFramesInFlight = numberFramesInFlight;
+            this->compilerCommand = compilerCommand;
+
+#ifdef __linux__
+            inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if(inotifyFD < 0) {
+                print_warning("ShaderHotReloader", "inotify not available (falling back to polling)");
+            }
+#endif
+            watcher = thread(&ShaderHotReloader::watchLoop, this);
+        };
+
+        ~ShaderHotReloader() {
+            isStopping = true;
+            if(watcher.joinable()) {
+                watcher.join();
+            }
+#ifdef __linux__
+            if(inotifyFD >= 0) {
+                close(inotifyFD);
+            }
+#endif
+            // Command buffers may still reference any version
+            refInitData->device().waitIdle();
+
+            for(auto &retired : allRetired) {
+                cleanupVulkanPipelineOnly(*refInitData, retired.data);
+            }
+            allRetired.clear();
+
+            for(auto &p : allPipelines) {
+                if(p->hasPending) {
+                    cleanupVulkanPipelineOnly(*refInitData, p->pending);
+                }
+                cleanupVulkanPipeline(*refInitData, p->live);
+            }
+            allPipelines.clear();
+        };
+
+        // Copy: forbidden (unique ownership)
+        ShaderHotReloader(const ShaderHotReloader&)            = delete;
+        ShaderHotReloader& operator=(const ShaderHotReloader&) = delete;
+
+        // Builds the pipeline now (throws like createVulkanPipeline()) and returns its id for get()
+        size_t addPipeline(const VulkanPipelineCreateInfo &createInfo) {
+            auto entry = make_unique<HotPipeline>();
+            entry->graphicsInfo = make_unique<VulkanPipelineCreateInfo>(createInfo);
+            fixCopiedVulkanPipelineCreateInfo(createInfo, *(entry->graphicsInfo));
+
+            entry->live = createVulkanPipeline(*refInitData, *(entry->graphicsInfo));
+
+            vector<string> allSPVFiles {};
+            for(auto &shader : createInfo.shaderInfo) {
+                allSPVFiles.push_back(shader.filename);
+            }
+            return addEntry(std::move(entry), allSPVFiles);
+        };
+
+        size_t addComputePipeline(const VulkanComputePipelineCreateInfo &createInfo) {
+            auto entry = make_unique<HotPipeline>();
+            entry->computeInfo = make_unique<VulkanComputePipelineCreateInfo>(createInfo);
+            entry->live = createVulkanComputePipeline(*refInitData, *(entry->computeInfo));
+            return addEntry(std::move(entry), { createInfo.shaderInfo.filename });
+        };
+
+        // Recompile sourceFilename into spvFilename whenever it changes
+        void addShaderSource(const string &sourceFilename, const string &spvFilename) {
+            lock_guard<mutex> guard(lock);
+            sourceToSPV[sourceFilename] = spvFilename;
+            watchFile(sourceFilename);
+        };
+
+        // Maps every <sourceDir>/<name>.vert/.frag/.comp to <spvDir>/<name>.<ext>.spv (the CMake layout)
+        void addShaderSourceDirectory(const string &sourceDir, const string &spvDir) {
+            error_code ec;
+            for(auto &file : filesystem::directory_iterator(sourceDir, ec)) {
+                string ext = file.path().extension().string();
+                if(ext == ".vert" || ext == ".frag" || ext == ".comp") {
+                    string name = file.path().filename().string();
+                    addShaderSource(file.path().string(), (filesystem::path(spvDir) / (name + ".spv")).string());
+                }
+            }
+            if(ec) {
+                print_warning("ShaderHotReloader", "Cannot read shader source directory " + sourceDir);
+            }
+        };
+
+        // Current version (only valid until the next beginFrame())
+        VulkanPipelineData& get(size_t id) {
+            return allPipelines.at(id)->live;
+        };
+
+        // Frame boundary: swaps in rebuilt pipelines and destroys retired ones that are no longer in flight.
+        // Never blocks on the watcher thread (if it holds the lock, the swap waits for the next frame).
+        // Returns the number of pipelines swapped in (the watcher itself only prints failures).
+        unsigned int beginFrame() {
+            frameCnt++;
+
+            unique_lock<mutex> guard(lock, try_to_lock);
+            if(!guard.owns_lock()) {
+                return 0;
+            }
+
+            // FrameRing::acquire() waited on this slot's fence, so after numberFramesInFlight frames
+            // every submission that could have used a retired pipeline has finished
+            auto it = allRetired.begin();
+            while(it != allRetired.end()) {
+                if(frameCnt >= it->retireFrame) {
+                    cleanupVulkanPipelineOnly(*refInitData, it->data);
+                    it = allRetired.erase(it);
+                }
+                else {
+                    it++;
+                }
+            }
+
+            unsigned int swapCnt = 0;
+            for(auto &p : allPipelines) {
+                if(!p->hasPending) {
+                    continue;
+                }
+                allRetired.push_back({ p->live, frameCnt + numberFramesInFlight });
+                p->live = p->pending;
+                p->pending = {};
+                p->hasPending = false;
+                swapCnt++;
+            }
+            return swapCnt;
+        };
+    };
+}
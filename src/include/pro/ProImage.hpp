@@ -1,5 +1,11 @@
 #pragma once
 #include "ProSetup.hpp"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PRO_USE_SSE2 1
+    #include <emmintrin.h>
+#endif
 
 namespace pro {
 
@@ -16,7 +22,8 @@ namespace pro {
     enum IMAGE_TRANSITION_TYPE {
         UNDEF_TO_COLOR,        
         COLOR_TO_PRESENT,
-        UNDEF_TO_DEPTH   
+        UNDEF_TO_DEPTH,
+        COLOR_TO_TRANSFER_SRC   
     };
 
     struct VulkanImage {
@@ -28,6 +35,14 @@ namespace pro {
         uint32_t mipLevels{1};
     };
 
+    // 8 bits per channel image in CPU memory (e.g., from a file or read back from the GPU)
+    struct HostImage {
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        vector<unsigned char> data {};
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     // FUNCTIONS 
     ///////////////////////////////////////////////////////////////////////////
@@ -79,6 +94,17 @@ namespace pro {
                 aspectFlags = vk::ImageAspectFlagBits::eDepth;
                 break;
             }            
+            case COLOR_TO_TRANSFER_SRC:
+            {
+                oldLayout = vk::ImageLayout::eColorAttachmentOptimal;
+                newLayout = vk::ImageLayout::eTransferSrcOptimal;
+                srcMask = vk::AccessFlagBits::eColorAttachmentWrite;
+                dstMask = vk::AccessFlagBits::eTransferRead;
+
+                transitionData.srcFlags = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+                transitionData.dstFlags = vk::PipelineStageFlagBits::eTransfer;
+                break;
+            }
             default:
             {
                 throw invalid_argument("Unsupported layout transition!");
@@ -171,7 +197,7 @@ namespace pro {
         viewInfo.image = imageData.image;
         viewInfo.format = format;
         viewInfo.viewType = vk::ImageViewType::e2D;
-        viewInfo.subresourceRange = { aspectFlags, 0, 1, 0, 1 }; 
+        viewInfo.subresourceRange = { aspectFlags, 0, mipLevels, 0, 1 }; 
         // Aspect that are visible (also mipmap level and array ranges)
    
         imageData.view = vkInitData.device().createImageView(viewInfo);
@@ -189,6 +215,406 @@ namespace pro {
         imageData = {};
     };
 
+    // Color target for headless/offscreen rendering (same size and format as the "swapchain")
+    inline VulkanImage createOffscreenColorImage(const VulkanInitData &vkInitData) {
+        return createVulkanImage(   vkInitData,
+                                    vk::Extent3D { 
+                                        vkInitData.swapchain().extent.width, 
+                                        vkInitData.swapchain().extent.height, 
+                                        1 },
+                                    vkInitData.swapchain().format,
+                                    vk::ImageUsageFlagBits::eColorAttachment 
+                                        | vk::ImageUsageFlagBits::eTransferSrc,
+                                    vk::ImageAspectFlagBits::eColor,
+                                    1, vk::SampleCountFlagBits::e1);
+    };
+
+    inline HostImage loadHostImage(const string &filename, int desiredChannels = 4) {
+        HostImage image {};
+        int fileChannels = 0;
+        unsigned char *pixels = stbi_load(  filename.c_str(), 
+                                            &image.width, &image.height, 
+                                            &fileChannels, desiredChannels);
+        if(!pixels) {
+            print_and_throw_error("loadHostImage", "Cannot load " + filename + ": " + stbi_failure_reason());
+        }
+
+        image.channels = (desiredChannels > 0) ? desiredChannels : fileChannels;
+        image.data.assign(pixels, pixels + (size_t)image.width * image.height * image.channels);
+        stbi_image_free(pixels);
+        return image;
+    };
+
+    inline bool saveHostImagePNG(const string &filename, const HostImage &image) {
+        return stbi_write_png(  filename.c_str(), 
+                                image.width, image.height, image.channels, 
+                                image.data.data(), image.width * image.channels) != 0;
+    };
+
+    // Number of channel values that differ by more than tolerance 
+    // (-1 if the images are not even the same size)
+    inline long long countHostImageDifferences( const HostImage &a, 
+                                                const HostImage &b, 
+                                                int tolerance = 0) {
+        if(a.width != b.width || a.height != b.height || a.channels != b.channels) {
+            return -1;
+        }
+
+        long long diffCnt = 0;
+        for(size_t i = 0; i < a.data.size(); i++) {
+            if(abs((int)a.data[i] - (int)b.data[i]) > tolerance) {
+                diffCnt++;
+            }
+        }
+        return diffCnt;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // MIPMAPS
+    ///////////////////////////////////////////////////////////////////////////
+
+    enum MIPMAP_FILTER_TYPE {
+        MIPMAP_BOX,         // 2x2 average (fast; SIMD)
+        MIPMAP_KAISER       // Kaiser-windowed sinc (sharper, less aliasing)
+    };
+
+    // Full chain down to 1x1
+    inline uint32_t getMipLevelCount(uint32_t width, uint32_t height) {
+        uint32_t levels = 1;
+        while(width > 1 || height > 1) {
+            width = max(1u, width / 2);
+            height = max(1u, height / 2);
+            levels++;
+        }
+        return levels;
+    };
+
+    // Blitting mips needs linear filtering support for the format (optimal tiling)
+    inline bool canBlitMipmaps(const VulkanInitData &vkInitData, vk::Format format) {
+        vk::FormatProperties props = vkInitData.physicalDevice().getFormatProperties(format);
+        vk::FormatFeatureFlags needed = vk::FormatFeatureFlagBits::eBlitSrc 
+                                        | vk::FormatFeatureFlagBits::eBlitDst
+                                        | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+        return (props.optimalTilingFeatures & needed) == needed;
+    };
+
+    // GPU mip generation (GRAPHICS queue; blits are not allowed on transfer-only queues).
+    // Expects ALL levels in eTransferDstOptimal with level 0 filled in;
+    // leaves ALL levels in finalLayout. Image needs eTransferSrc | eTransferDst usage.
+    inline void recordGenerateMipmaps(  vk::CommandBuffer &commandBuffer,
+                                        const VulkanImage &imageData,
+                                        vk::ImageLayout finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal) {
+        vk::ImageMemoryBarrier barrier {};
+        barrier.image = imageData.image;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+        int32_t mipWidth = (int32_t)imageData.extent.width;
+        int32_t mipHeight = (int32_t)imageData.extent.height;
+
+        for(uint32_t i = 1; i < imageData.mipLevels; i++) {
+            // Previous level: DST --> SRC
+            barrier.subresourceRange.baseMipLevel = i - 1;
+            barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+            barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+            barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+            commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+                                            {}, nullptr, nullptr, barrier);
+
+            int32_t nextWidth = max(1, mipWidth / 2);
+            int32_t nextHeight = max(1, mipHeight / 2);
+
+            vk::ImageBlit blit {};
+            blit.srcOffsets[0] = vk::Offset3D(0, 0, 0);
+            blit.srcOffsets[1] = vk::Offset3D(mipWidth, mipHeight, 1);
+            blit.srcSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i - 1, 0, 1);
+            blit.dstOffsets[0] = vk::Offset3D(0, 0, 0);
+            blit.dstOffsets[1] = vk::Offset3D(nextWidth, nextHeight, 1);
+            blit.dstSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i, 0, 1);
+            commandBuffer.blitImage(imageData.image, vk::ImageLayout::eTransferSrcOptimal,
+                                    imageData.image, vk::ImageLayout::eTransferDstOptimal,
+                                    blit, vk::Filter::eLinear);
+
+            // Previous level is done: SRC --> final
+            barrier.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
+            barrier.newLayout = finalLayout;
+            barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+            barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+            commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTransfer, 
+                                            vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader,
+                                            {}, nullptr, nullptr, barrier);
+
+            mipWidth = nextWidth;
+            mipHeight = nextHeight;
+        }
+
+        // Last level was only ever written
+        barrier.subresourceRange.baseMipLevel = imageData.mipLevels - 1;
+        barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+        barrier.newLayout = finalLayout;
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+        commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTransfer, 
+                                        vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eFragmentShader,
+                                        {}, nullptr, nullptr, barrier);
+    };
+
+    // sRGB <--> linear (8-bit)
+    inline float srgbToLinear(float c) {
+        return (c <= 0.04045f) ? (c / 12.92f) : powf((c + 0.055f) / 1.055f, 2.4f);
+    };
+
+    inline float linearToSRGB(float c) {
+        return (c <= 0.0031308f) ? (c * 12.92f) : (1.055f * powf(c, 1.0f / 2.4f) - 0.055f);
+    };
+
+    inline const float* getSRGBToLinearTable() {
+        static const vector<float> table = []() {
+            vector<float> t(256);
+            for(int i = 0; i < 256; i++) {
+                t[i] = srgbToLinear(i / 255.0f);
+            }
+            return t;
+        }();
+        return table.data();
+    };
+
+    inline unsigned char floatToUnorm8(float v) {
+        return (unsigned char)glm::clamp((int)lroundf(v * 255.0f), 0, 255);
+    };
+
+    // 2x2 box filter of an RGBA8 image, UNORM data (SSE2 when available)
+    inline HostImage downsampleBoxUnorm(const HostImage &src) {
+        HostImage dst {};
+        dst.width = max(1, src.width / 2);
+        dst.height = max(1, src.height / 2);
+        dst.channels = 4;
+        dst.data.resize((size_t)dst.width * dst.height * 4);
+
+        const uint32_t *srcPixels = reinterpret_cast<const uint32_t*>(src.data.data());
+        uint32_t *dstPixels = reinterpret_cast<uint32_t*>(dst.data.data());
+
+        for(int y = 0; y < dst.height; y++) {
+            const uint32_t *row0 = srcPixels + (size_t)min(2*y, src.height - 1) * src.width;
+            const uint32_t *row1 = srcPixels + (size_t)min(2*y + 1, src.height - 1) * src.width;
+            uint32_t *out = dstPixels + (size_t)y * dst.width;
+            int x = 0;
+
+            #ifdef PRO_USE_SSE2
+                // 2 output pixels (4 input pixels per row) at a time
+                if(src.width >= 2) {
+                    const __m128i zero = _mm_setzero_si128();
+                    const __m128i two = _mm_set1_epi16(2);
+                    for(; x + 2 <= dst.width && 2*x + 4 <= src.width; x += 2) {
+                        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2*x));
+                        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2*x));
+
+                        // Widen to 16 bits and sum the two rows
+                        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+                        // Sum horizontal neighbors (pixel 0 + 1, pixel 2 + 3)
+                        __m128i sumLo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                        __m128i sumHi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+                        __m128i sums = _mm_unpacklo_epi64(sumLo, sumHi);
+
+                        // Round and divide by 4
+                        sums = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+                        __m128i packed = _mm_packus_epi16(sums, zero);
+                        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), packed);
+                    }
+                }
+            #endif
+
+            // Scalar (remainder / fallback)
+            for(; x < dst.width; x++) {
+                int x0 = min(2*x, src.width - 1);
+                int x1 = min(2*x + 1, src.width - 1);
+                const unsigned char *p00 = reinterpret_cast<const unsigned char*>(row0 + x0);
+                const unsigned char *p01 = reinterpret_cast<const unsigned char*>(row0 + x1);
+                const unsigned char *p10 = reinterpret_cast<const unsigned char*>(row1 + x0);
+                const unsigned char *p11 = reinterpret_cast<const unsigned char*>(row1 + x1);
+                unsigned char *o = reinterpret_cast<unsigned char*>(out + x);
+                for(int c = 0; c < 4; c++) {
+                    o[c] = (unsigned char)((p00[c] + p01[c] + p10[c] + p11[c] + 2) >> 2);
+                }
+            }
+        }
+        return dst;
+    };
+
+    // 2x2 box filter in linear space (color channels are sRGB; alpha is linear)
+    inline HostImage downsampleBoxSRGB(const HostImage &src) {
+        HostImage dst {};
+        dst.width = max(1, src.width / 2);
+        dst.height = max(1, src.height / 2);
+        dst.channels = 4;
+        dst.data.resize((size_t)dst.width * dst.height * 4);
+        const float *toLinear = getSRGBToLinearTable();
+
+        for(int y = 0; y < dst.height; y++) {
+            int y0 = min(2*y, src.height - 1);
+            int y1 = min(2*y + 1, src.height - 1);
+            for(int x = 0; x < dst.width; x++) {
+                int x0 = min(2*x, src.width - 1);
+                int x1 = min(2*x + 1, src.width - 1);
+                const unsigned char *p[4] = {
+                    &src.data[((size_t)y0 * src.width + x0) * 4], &src.data[((size_t)y0 * src.width + x1) * 4],
+                    &src.data[((size_t)y1 * src.width + x0) * 4], &src.data[((size_t)y1 * src.width + x1) * 4]
+                };
+                unsigned char *o = &dst.data[((size_t)y * dst.width + x) * 4];
+                for(int c = 0; c < 3; c++) {
+                    float sum = toLinear[p[0][c]] + toLinear[p[1][c]] + toLinear[p[2][c]] + toLinear[p[3][c]];
+                    o[c] = floatToUnorm8(linearToSRGB(sum * 0.25f));
+                }
+                o[3] = (unsigned char)((p[0][3] + p[1][3] + p[2][3] + p[3][3] + 2) >> 2);
+            }
+        }
+        return dst;
+    };
+
+    inline float besselI0(float x) {
+        // Series expansion (converges quickly for the alphas used here)
+        float sum = 1.0f, term = 1.0f, halfX = x * 0.5f;
+        for(int k = 1; k < 20; k++) {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+        }
+        return sum;
+    };
+
+    // Kaiser-windowed sinc, half-resolution, separable (width taps on each side);
+    // one RGBA texel per SSE2 register when available
+    inline HostImage downsampleKaiser(const HostImage &src, bool isSRGB, float alpha = 4.0f, int width = 3) {
+        HostImage dst {};
+        dst.width = max(1, src.width / 2);
+        dst.height = max(1, src.height / 2);
+        dst.channels = 4;
+        dst.data.resize((size_t)dst.width * dst.height * 4);
+
+        // Output texel i is centered at source 2i + 0.5; taps at 2i - width + 1 ... 2i + width
+        int tapCnt = 2 * width;
+        vector<float> weights(tapCnt);
+        float weightSum = 0.0f;
+        for(int t = 0; t < tapCnt; t++) {
+            float d = (t - width + 0.5f) * 0.5f;       // Distance in OUTPUT texels
+            float sinc = (d == 0.0f) ? 1.0f : sinf(glm::pi<float>() * d) / (glm::pi<float>() * d);
+            float r = d / (width * 0.5f);
+            float window = (fabsf(r) < 1.0f) ? besselI0(alpha * sqrtf(1.0f - r*r)) / besselI0(alpha) : 0.0f;
+            weights[t] = sinc * window;
+            weightSum += weights[t];
+        }
+        for(auto &w : weights) {
+            w /= weightSum;
+        }
+
+        // Convert to linear floats once
+        const float *toLinear = getSRGBToLinearTable();
+        vector<float> linear(src.data.size());
+        for(size_t i = 0; i < src.data.size(); i++) {
+            bool isColor = (i % 4) != 3;
+            linear[i] = (isSRGB && isColor) ? toLinear[src.data[i]] : src.data[i] / 255.0f;
+        }
+
+        // Horizontal pass (clamp at edges)
+        int srcW = src.width;
+        vector<float> horiz((size_t)dst.width * src.height * 4, 0.0f);
+        for(int y = 0; y < src.height; y++) {
+            for(int x = 0; x < dst.width; x++) {
+                float *o = &horiz[((size_t)y * dst.width + x) * 4];
+                #ifdef PRO_USE_SSE2
+                    __m128 acc = _mm_setzero_ps();
+                    for(int t = 0; t < tapCnt; t++) {
+                        int sx = glm::clamp(2*x - width + 1 + t, 0, srcW - 1);
+                        __m128 p = _mm_loadu_ps(&linear[((size_t)y * srcW + sx) * 4]);
+                        acc = _mm_add_ps(acc, _mm_mul_ps(p, _mm_set1_ps(weights[t])));
+                    }
+                    _mm_storeu_ps(o, acc);
+                #else
+                    for(int t = 0; t < tapCnt; t++) {
+                        int sx = glm::clamp(2*x - width + 1 + t, 0, srcW - 1);
+                        const float *p = &linear[((size_t)y * srcW + sx) * 4];
+                        for(int c = 0; c < 4; c++) {
+                            o[c] += p[c] * weights[t];
+                        }
+                    }
+                #endif
+            }
+        }
+
+        // Vertical pass
+        for(int y = 0; y < dst.height; y++) {
+            for(int x = 0; x < dst.width; x++) {
+                float sum[4] = {0,0,0,0};
+                #ifdef PRO_USE_SSE2
+                    __m128 acc = _mm_setzero_ps();
+                    for(int t = 0; t < tapCnt; t++) {
+                        int sy = glm::clamp(2*y - width + 1 + t, 0, src.height - 1);
+                        __m128 p = _mm_loadu_ps(&horiz[((size_t)sy * dst.width + x) * 4]);
+                        acc = _mm_add_ps(acc, _mm_mul_ps(p, _mm_set1_ps(weights[t])));
+                    }
+                    acc = _mm_min_ps(_mm_max_ps(acc, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                    _mm_storeu_ps(sum, acc);
+                #else
+                    for(int t = 0; t < tapCnt; t++) {
+                        int sy = glm::clamp(2*y - width + 1 + t, 0, src.height - 1);
+                        const float *p = &horiz[((size_t)sy * dst.width + x) * 4];
+                        for(int c = 0; c < 4; c++) {
+                            sum[c] += p[c] * weights[t];
+                        }
+                    }
+                    for(int c = 0; c < 4; c++) {
+                        sum[c] = glm::clamp(sum[c], 0.0f, 1.0f);
+                    }
+                #endif
+                unsigned char *o = &dst.data[((size_t)y * dst.width + x) * 4];
+                for(int c = 0; c < 4; c++) {
+                    bool isColor = (c != 3);
+                    o[c] = floatToUnorm8((isSRGB && isColor) ? linearToSRGB(sum[c]) : sum[c]);
+                }
+            }
+        }
+        return dst;
+    };
+
+    // Full mip chain on the CPU (level 0 = copy of src); src must be RGBA8
+    inline vector<HostImage> generateHostMipChain(  const HostImage &src, 
+                                                    bool isSRGB, 
+                                                    MIPMAP_FILTER_TYPE filter = MIPMAP_BOX) {
+        if(src.channels != 4) {
+            print_and_throw_error("generateHostMipChain", "Only 4-channel (RGBA) host images are supported!");
+        }
+
+        vector<HostImage> levels { src };
+        uint32_t levelCnt = getMipLevelCount((uint32_t)src.width, (uint32_t)src.height);
+        for(uint32_t i = 1; i < levelCnt; i++) {
+            const HostImage &prev = levels.back();
+            if(filter == MIPMAP_KAISER)     levels.push_back(downsampleKaiser(prev, isSRGB));
+            else if(isSRGB)                 levels.push_back(downsampleBoxSRGB(prev));
+            else                            levels.push_back(downsampleBoxUnorm(prev));
+        }
+        return levels;
+    };
+
+    // Packs every level back to back; regions are for a single buffer-to-image copy
+    inline void packHostMipChain(   const vector<HostImage> &levels,
+                                    vector<unsigned char> &data,
+                                    vector<vk::BufferImageCopy> &regions) {
+        data.clear();
+        regions.clear();
+        for(uint32_t i = 0; i < levels.size(); i++) {
+            vk::BufferImageCopy region {};
+            region.bufferOffset = data.size();
+            region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i, 0, 1);
+            region.imageExtent = vk::Extent3D((uint32_t)levels[i].width, (uint32_t)levels[i].height, 1);
+            regions.push_back(region);
+
+            data.insert(data.end(), levels[i].data.begin(), levels[i].data.end());
+        }
+    };
+
     inline vk::RenderingAttachmentInfoKHR createColorAttachment(
         const vk::ImageView &swapImageView,
         vk::ClearColorValue clearColor) {
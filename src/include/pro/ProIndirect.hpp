@@ -0,0 +1,255 @@
+#pragma once
+#include "ProCompute.hpp"
+#include "ProCull.hpp"
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // One object for GPU culling (std430 layout; must match the cull compute shader).
+    // Every object must live in the SAME vertex/index buffers (e.g., one MeshArena block).
+    struct GPUDrawObject {
+        glm::vec4 sphere {};                // World-space center (xyz) and radius (w)
+        glm::vec4 boxCenter {};             // World-space AABB center (xyz)
+        glm::vec4 boxExtent {};             // World-space AABB half-extents (xyz)
+        uint32_t indexCnt = 0;
+        uint32_t firstIndex = 0;
+        int32_t vertexOffset = 0;
+        uint32_t firstInstance = 0;         // Passed through (e.g., index of per-object data via gl_InstanceIndex)
+    };
+
+    // Push constants of the cull compute shader
+    struct GPUCullParams {
+        glm::vec4 planes[6] {};
+        uint32_t objectCnt = 0;
+        uint32_t test = CULL_SPHERE_AND_AABB;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    inline GPUDrawObject makeGPUDrawObject( const VulkanMesh &mesh,
+                                            const glm::mat4 &model = glm::mat4(1.0f),
+                                            uint32_t firstInstance = 0) {
+        WorldBounds world(mesh.bounds, model);
+        GPUDrawObject object {};
+        object.sphere = glm::vec4(world.sphereCenter, world.sphereRadius);
+        object.boxCenter = glm::vec4(world.boxCenter, 0.0f);
+        object.boxExtent = glm::vec4(world.boxExtent, 0.0f);
+        object.indexCnt = mesh.indexCnt;
+        object.firstIndex = mesh.firstIndex;
+        object.vertexOffset = mesh.vertexOffset;
+        object.firstInstance = firstInstance;
+        return object;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    // GPU-driven drawing: a compute shader frustum culls the objects and writes one
+    // vk::DrawIndexedIndirectCommand per visible object plus a draw count, then ONE
+    // drawIndexedIndirectCount() draws them all (no per-object CPU work at all).
+    // Buffers are per frame in flight. Per frame:
+    //  - setObjects(frame, ...) (only when objects change; host-visible, so no upload)
+    //  - recordCull(cmd, frame, frustum) OUTSIDE of rendering; either in the graphics command buffer,
+    //      or on the compute queue (AsyncCompute::begin(), then releaseToGraphics() and AsyncCompute::submit())
+    //  - recordDraw(cmd, frame, anyMesh) inside rendering, with the graphics pipeline bound
+    // The device needs VkPhysicalDeviceVulkan12Features::drawIndirectCount
+    // (set VulkanInitCreateInfo::reqFeatures12.drawIndirectCount = true).
+    // shaderFilename: SPIR-V of cull.comp (see vulkanshaders/ProBench/cull.comp).
+    class GPUCuller {
+    private:
+        struct FrameBuffers {
+            VulkanBuffer objects {};            // Host-visible, mapped
+            VulkanBuffer commands {};           // Written by the cull shader
+            VulkanBuffer count {};              // Draw count (uint32_t)
+            vk::DescriptorSet descSet {};       // Freed with the pool
+            uint32_t objectCnt = 0;
+        };
+
+        VulkanInitData *refInitData;            // Do NOT clean up!!!
+        uint32_t maxObjectCnt = 0;
+        uint32_t workGroupSize = 64;            // Must match local_size_x in the shader
+        VulkanPipelineData pipelineData {};     // Cleaned up explicitly
+        vk::DescriptorPool descPool {};         // Cleaned up explicitly
+        vector<FrameBuffers> allFrames {};      // Cleaned up explicitly
+
+        void createPipeline(const string &shaderFilename) {
+            // Objects, commands, count
+            vector<vk::DescriptorSetLayoutBinding> allBindings {};
+            for(uint32_t b = 0; b < 3; b++) {
+                allBindings.push_back(vk::DescriptorSetLayoutBinding(
+                    b, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute));
+            }
+            vk::DescriptorSetLayout setLayout = refInitData->device().createDescriptorSetLayout(
+                                                    vk::DescriptorSetLayoutCreateInfo({}, allBindings));
+
+            VulkanComputePipelineCreateInfo createInfo(shaderFilename);
+            createInfo.allDescSetLayouts = { setLayout };
+            createInfo.pushConstantRanges = { vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(GPUCullParams)) };
+            try {
+                pipelineData = createVulkanComputePipeline(*refInitData, createInfo);
+            }
+            catch(...) {
+                refInitData->device().destroyDescriptorSetLayout(setLayout);
+                throw;
+            }
+        };
+
+        void createFrameBuffers(unsigned int numberFramesInFlight) {
+            vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, 3 * numberFramesInFlight);
+            descPool = refInitData->device().createDescriptorPool(
+                        vk::DescriptorPoolCreateInfo({}, numberFramesInFlight, poolSize));
+
+            vector<vk::DescriptorSetLayout> allLayouts(numberFramesInFlight, pipelineData.allDescSetLayouts.front());
+            vector<vk::DescriptorSet> allSets = refInitData->device().allocateDescriptorSets(
+                                                    vk::DescriptorSetAllocateInfo(descPool, allLayouts));
+
+            vk::DeviceSize objectBytes = max<vk::DeviceSize>(1, maxObjectCnt) * sizeof(GPUDrawObject);
+            vk::DeviceSize commandBytes = max<vk::DeviceSize>(1, maxObjectCnt) * sizeof(vk::DrawIndexedIndirectCommand);
+
+            for(unsigned int i = 0; i < numberFramesInFlight; i++) {
+                FrameBuffers frame {};
+                frame.objects = createVulkanBuffer( *refInitData, objectBytes,
+                                                    vk::BufferUsageFlagBits::eStorageBuffer,
+                                                    createVMAHostVisibleInfo());
+                frame.commands = createVulkanBuffer(*refInitData, commandBytes,
+                                                    vk::BufferUsageFlagBits::eStorageBuffer
+                                                        | vk::BufferUsageFlagBits::eIndirectBuffer,
+                                                    createVMADeviceLocalInfo());
+                frame.count = createVulkanBuffer(   *refInitData, sizeof(uint32_t),
+                                                    vk::BufferUsageFlagBits::eStorageBuffer
+                                                        | vk::BufferUsageFlagBits::eIndirectBuffer
+                                                        | vk::BufferUsageFlagBits::eTransferDst,
+                                                    createVMADeviceLocalInfo());
+                frame.descSet = allSets.at(i);
+
+                vk::DescriptorBufferInfo allBufferInfo[] = {
+                    vk::DescriptorBufferInfo(frame.objects.buffer, 0, VK_WHOLE_SIZE),
+                    vk::DescriptorBufferInfo(frame.commands.buffer, 0, VK_WHOLE_SIZE),
+                    vk::DescriptorBufferInfo(frame.count.buffer, 0, VK_WHOLE_SIZE)
+                };
+                vector<vk::WriteDescriptorSet> allWrites {};
+                for(uint32_t b = 0; b < 3; b++) {
+                    allWrites.push_back(vk::WriteDescriptorSet(
+                        frame.descSet, b, 0, vk::DescriptorType::eStorageBuffer, {}, allBufferInfo[b]));
+                }
+                refInitData->device().updateDescriptorSets(allWrites, {});
+
+                allFrames.push_back(frame);
+            }
+        };
+
+    public:
+        GPUCuller(  VulkanInitData &vkInitData,
+                    const string &shaderFilename,
+                    uint32_t maxObjectCnt,
+                    unsigned int numberFramesInFlight = 2) {
+            refInitData = &vkInitData;
+            this->maxObjectCnt = maxObjectCnt;
+
+            if(numberFramesInFlight == 0) {
+                print_and_throw_error("GPUCuller", "Must have at least one frame in flight!");
+            }
+
+            createPipeline(shaderFilename);
+            createFrameBuffers(numberFramesInFlight);
+        };
+
+        ~GPUCuller() {
+            refInitData->device().waitIdle();
+            for(auto &frame : allFrames) {
+                cleanupVulkanBuffer(*refInitData, frame.objects);
+                cleanupVulkanBuffer(*refInitData, frame.commands);
+                cleanupVulkanBuffer(*refInitData, frame.count);
+            }
+            allFrames.clear();
+            refInitData->device().destroyDescriptorPool(descPool);
+            cleanupVulkanPipeline(*refInitData, pipelineData);
+        };
+
+        // Copy: forbidden (unique ownership)
+        GPUCuller(const GPUCuller&)            = delete;
+        GPUCuller& operator=(const GPUCuller&) = delete;
+
+        uint32_t getMaxObjectCount() const noexcept { return maxObjectCnt; };
+        uint32_t getObjectCount(unsigned int indexFrame) const { return allFrames.at(indexFrame).objectCnt; };
+
+        // Frame indexFrame must not be in flight (i.e., after waiting on its fence)
+        void setObjects(unsigned int indexFrame, const vector<GPUDrawObject> &allObjects) {
+            FrameBuffers &frame = allFrames.at(indexFrame);
+            if(allObjects.size() > maxObjectCnt) {
+                print_warning("GPUCuller", "Too many objects (" + to_string(allObjects.size())
+                                            + " > " + to_string(maxObjectCnt) + "); extra objects are ignored.");
+            }
+            frame.objectCnt = (uint32_t)min<size_t>(allObjects.size(), maxObjectCnt);
+            if(frame.objectCnt > 0) {
+                memcpy(frame.objects.mapped, allObjects.data(), frame.objectCnt * sizeof(GPUDrawObject));
+                vmaFlushAllocation(refInitData->allocator(), frame.objects.allocation, 0, VK_WHOLE_SIZE);
+            }
+        };
+
+        // Resets the count, dispatches the cull shader, and makes its output visible to indirect draws
+        void recordCull(vk::CommandBuffer &commandBuffer,
+                        unsigned int indexFrame,
+                        const Frustum &frustum,
+                        CULL_TEST test = CULL_SPHERE_AND_AABB) {
+            FrameBuffers &frame = allFrames.at(indexFrame);
+
+            commandBuffer.fillBuffer(frame.count.buffer, 0, sizeof(uint32_t), 0);
+            vk::MemoryBarrier resetBarrier( vk::AccessFlagBits::eTransferWrite,
+                                            vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+            commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eTransfer,
+                                            vk::PipelineStageFlagBits::eComputeShader,
+                                            {}, resetBarrier, {}, {});
+
+            if(frame.objectCnt > 0) {
+                GPUCullParams params {};
+                for(int p = 0; p < 6; p++) {
+                    params.planes[p] = frustum.planes[p];
+                }
+                params.objectCnt = frame.objectCnt;
+                params.test = (uint32_t)test;
+
+                recordDispatchCompute(  commandBuffer, pipelineData,
+                                        getDispatchGroupCount(frame.objectCnt, workGroupSize), 1, 1,
+                                        { frame.descSet }, &params, sizeof(GPUCullParams));
+            }
+
+            vk::MemoryBarrier cullBarrier(  vk::AccessFlagBits::eShaderWrite,
+                                            vk::AccessFlagBits::eIndirectCommandRead);
+            commandBuffer.pipelineBarrier(  vk::PipelineStageFlagBits::eComputeShader,
+                                            vk::PipelineStageFlagBits::eDrawIndirect,
+                                            {}, cullBarrier, {}, {});
+        };
+
+        // Async compute: call after recordCull() into compute.begin(indexFrame)'s command buffer
+        void releaseToGraphics(AsyncCompute &compute, unsigned int indexFrame) {
+            FrameBuffers &frame = allFrames.at(indexFrame);
+            compute.releaseBuffer(frame.commands, vk::PipelineStageFlagBits::eDrawIndirect, vk::AccessFlagBits::eIndirectCommandRead);
+            compute.releaseBuffer(frame.count, vk::PipelineStageFlagBits::eDrawIndirect, vk::AccessFlagBits::eIndirectCommandRead);
+        };
+
+        // Draws whatever recordCull() kept; sharedMesh is ANY mesh in the objects' shared buffers
+        void recordDraw(vk::CommandBuffer &commandBuffer,
+                        unsigned int indexFrame,
+                        const VulkanMesh &sharedMesh) {
+            FrameBuffers &frame = allFrames.at(indexFrame);
+            if(frame.objectCnt == 0) {
+                return;
+            }
+
+            vk::Buffer vertexBuffers[] = { sharedMesh.vertices.buffer };
+            vk::DeviceSize offsets[] = { 0 };
+            commandBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
+            commandBuffer.bindIndexBuffer(sharedMesh.indices.buffer, 0, sharedMesh.indexType);
+            commandBuffer.drawIndexedIndirectCount( frame.commands.buffer, 0,
+                                                    frame.count.buffer, 0,
+                                                    frame.objectCnt, sizeof(vk::DrawIndexedIndirectCommand));
+        };
+    };
+}
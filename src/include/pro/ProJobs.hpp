@@ -0,0 +1,528 @@
+#pragma once
+#include "ProTrace.hpp"
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <exception>
+
+// Work-stealing job system:
+//  - each thread of a JobSystem owns a Chase-Lev deque (push/pop at the bottom; other threads steal from the top)
+//  - JobCounter: counts unfinished jobs; wait() runs other jobs instead of blocking, so jobs may wait too
+//  - runAfter(): starts a job once a counter reaches zero (dependencies)
+//  - runBackground(): long jobs only picked up by idle workers, never by wait() (so they can't stall its caller)
+//  - parallelFor(): splits [0, count) into chunks and waits for them
+//  - runInParallel(): one item at a time over the default system (for uneven items, e.g., files)
+// The thread that creates a JobSystem is its worker 0; other non-worker threads submit through a shared queue.
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    class JobSystem;
+    class JobCounter;
+
+    struct Job {
+        function<void()> func {};
+        JobCounter *counter = nullptr;      // Signaled when done (may be nullptr)
+        bool isBackground = false;          // See JobSystem::runBackground()
+    };
+
+    // Chase-Lev deque (Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models", 2013).
+    // push()/pop(): owning thread only; steal(): any thread.
+    template<typename T>
+    class WorkStealingDeque {
+    private:
+        struct RingArray {
+            int64_t capacity = 0;
+            int64_t mask = 0;
+            unique_ptr<atomic<T>[]> data {};
+
+            explicit RingArray(int64_t capacity) : capacity(capacity), mask(capacity - 1), data(new atomic<T>[capacity]) {};
+
+            T get(int64_t i) const noexcept { return data[i & mask].load(memory_order_relaxed); };
+            void put(int64_t i, T x) noexcept { data[i & mask].store(x, memory_order_relaxed); };
+        };
+
+        alignas(64) atomic<int64_t> top {0};
+        alignas(64) atomic<int64_t> bottom {0};
+        atomic<RingArray*> array {nullptr};
+        vector<unique_ptr<RingArray>> allArrays {};     // Old arrays are kept (thieves may still read them)
+
+        RingArray* grow(RingArray *old, int64_t b, int64_t t) {
+            allArrays.push_back(make_unique<RingArray>(old->capacity * 2));
+            RingArray *bigger = allArrays.back().get();
+            for(int64_t i = t; i < b; i++) {
+                bigger->put(i, old->get(i));
+            }
+            array.store(bigger, memory_order_release);
+            return bigger;
+        };
+
+    public:
+        explicit WorkStealingDeque(int64_t capacity = 1024) {
+            int64_t size = 1;
+            while(size < capacity) {
+                size <<= 1;
+            }
+            allArrays.push_back(make_unique<RingArray>(size));
+            array.store(allArrays.back().get(), memory_order_relaxed);
+        };
+
+        // Copy: forbidden (unique ownership)
+        WorkStealingDeque(const WorkStealingDeque&)            = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        // Approximate (other threads may be changing it)
+        bool empty() const noexcept {
+            return bottom.load(memory_order_relaxed) <= top.load(memory_order_relaxed);
+        };
+
+        void push(T x) {
+            int64_t b = bottom.load(memory_order_relaxed);
+            int64_t t = top.load(memory_order_acquire);
+            RingArray *a = array.load(memory_order_relaxed);
+            if(b - t > a->capacity - 1) {
+                a = grow(a, b, t);
+            }
+            a->put(b, x);
+            atomic_thread_fence(memory_order_release);
+            bottom.store(b + 1, memory_order_relaxed);
+        };
+
+        bool pop(T &out) {
+            int64_t b = bottom.load(memory_order_relaxed) - 1;
+            RingArray *a = array.load(memory_order_relaxed);
+            bottom.store(b, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            int64_t t = top.load(memory_order_relaxed);
+
+            if(t > b) {
+                // Empty
+                bottom.store(b + 1, memory_order_relaxed);
+                return false;
+            }
+
+            out = a->get(b);
+            if(t == b) {
+                // Last item: race against thieves
+                bool won = top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+                bottom.store(b + 1, memory_order_relaxed);
+                return won;
+            }
+            return true;
+        };
+
+        bool steal(T &out) {
+            int64_t t = top.load(memory_order_acquire);
+            atomic_thread_fence(memory_order_seq_cst);
+            int64_t b = bottom.load(memory_order_acquire);
+            if(t >= b) {
+                return false;
+            }
+
+            RingArray *a = array.load(memory_order_acquire);
+            T x = a->get(t);
+            if(!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+                return false;
+            }
+            out = x;
+            return true;
+        };
+    };
+
+    // Number of unfinished jobs (plus jobs to start once it reaches zero; see JobSystem::runAfter())
+    class JobCounter {
+    private:
+        friend class JobSystem;
+
+        atomic<int64_t> count {0};
+        atomic<int64_t> activeSignals {0};  // Threads still touching this counter after decrementing
+        mutex continuationMutex {};
+        vector<Job*> continuations {};      // Guarded by continuationMutex
+        exception_ptr firstError = nullptr; // Guarded by continuationMutex
+
+    public:
+        JobCounter() = default;
+
+        // Copy: forbidden (unique ownership)
+        JobCounter(const JobCounter&)            = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        // Once true, the counter may be destroyed
+        bool isDone() const noexcept {
+            return count.load(memory_order_acquire) == 0 && activeSignals.load(memory_order_acquire) == 0;
+        };
+    };
+
+    class JobSystem {
+    private:
+        unsigned int threadCnt = 1;
+        vector<unique_ptr<WorkStealingDeque<Job*>>> allDeques {};  // [worker]
+        vector<thread> allWorkers {};                               // Workers 1..threadCnt-1
+        atomic<bool> stopping {false};
+
+        // Jobs from threads that are not workers of this system
+        mutex injectMutex {};
+        deque<Job*> injectQueue {};
+        atomic<size_t> injectCnt {0};
+
+        // Background jobs (any thread submits; only workers take them)
+        mutex backgroundMutex {};
+        deque<Job*> backgroundQueue {};
+        atomic<size_t> backgroundCnt {0};
+
+        // Idle workers sleep here
+        mutex sleepMutex {};
+        condition_variable wakeUp {};
+        atomic<unsigned int> sleepingCnt {0};
+
+        // This thread's worker index in tlsSystem
+        inline static thread_local JobSystem *tlsSystem = nullptr;
+        inline static thread_local unsigned int tlsIndex = 0;
+        inline static thread_local uint32_t tlsRandom = 0;
+
+        bool isWorkerThread() const noexcept { return tlsSystem == this; };
+
+        void submit(Job *job) {
+            if(job->isBackground) {
+                lock_guard<mutex> lock(backgroundMutex);
+                backgroundQueue.push_back(job);
+                backgroundCnt.fetch_add(1, memory_order_seq_cst);
+            }
+            else if(isWorkerThread()) {
+                allDeques[tlsIndex]->push(job);
+            }
+            else {
+                lock_guard<mutex> lock(injectMutex);
+                injectQueue.push_back(job);
+                injectCnt.fetch_add(1, memory_order_seq_cst);
+            }
+
+            // Pairs with the re-check in idle()
+            atomic_thread_fence(memory_order_seq_cst);
+            if(sleepingCnt.load(memory_order_relaxed) > 0) {
+                lock_guard<mutex> lock(sleepMutex);
+                wakeUp.notify_one();
+            }
+        };
+
+        bool hasWork() const {
+            if(injectCnt.load(memory_order_relaxed) > 0 || backgroundCnt.load(memory_order_relaxed) > 0) {
+                return true;
+            }
+            for(auto &d : allDeques) {
+                if(!d->empty()) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        // takeBackground: also background jobs (after everything else)
+        Job* findJob(bool takeBackground) {
+            Job *job = nullptr;
+
+            // Own work first (newest = likely still in cache)
+            if(isWorkerThread() && allDeques[tlsIndex]->pop(job)) {
+                return job;
+            }
+
+            if(injectCnt.load(memory_order_relaxed) > 0) {
+                lock_guard<mutex> lock(injectMutex);
+                if(!injectQueue.empty()) {
+                    job = injectQueue.front();
+                    injectQueue.pop_front();
+                    injectCnt.fetch_sub(1, memory_order_relaxed);
+                    return job;
+                }
+            }
+
+            // Steal (oldest = likely the biggest piece of work), starting at a random victim
+            if(tlsRandom == 0) {
+                tlsRandom = (uint32_t)hash<thread::id>{}(this_thread::get_id()) | 1u;
+            }
+            tlsRandom ^= tlsRandom << 13;
+            tlsRandom ^= tlsRandom >> 17;
+            tlsRandom ^= tlsRandom << 5;
+            unsigned int start = tlsRandom % threadCnt;
+            for(unsigned int i = 0; i < threadCnt; i++) {
+                unsigned int victim = (start + i) % threadCnt;
+                if(isWorkerThread() && victim == tlsIndex) {
+                    continue;
+                }
+                if(allDeques[victim]->steal(job)) {
+                    return job;
+                }
+            }
+
+            if(takeBackground && backgroundCnt.load(memory_order_relaxed) > 0) {
+                lock_guard<mutex> lock(backgroundMutex);
+                if(!backgroundQueue.empty()) {
+                    job = backgroundQueue.front();
+                    backgroundQueue.pop_front();
+                    backgroundCnt.fetch_sub(1, memory_order_relaxed);
+                    return job;
+                }
+            }
+            return nullptr;
+        };
+
+        void signal(JobCounter *counter, exception_ptr error) {
+            counter->activeSignals.fetch_add(1, memory_order_acq_rel);
+            if(error) {
+                lock_guard<mutex> lock(counter->continuationMutex);
+                if(!counter->firstError) {
+                    counter->firstError = error;
+                }
+            }
+
+            if(counter->count.fetch_sub(1, memory_order_acq_rel) == 1) {
+                vector<Job*> ready {};
+                {
+                    lock_guard<mutex> lock(counter->continuationMutex);
+                    ready.swap(counter->continuations);
+                }
+                for(Job *job : ready) {
+                    submit(job);
+                }
+            }
+
+            // Last touch of the counter (waiters may destroy it right after)
+            counter->activeSignals.fetch_sub(1, memory_order_release);
+        };
+
+        void execute(Job *job) {
+            exception_ptr error = nullptr;
+            try {
+                job->func();
+            }
+            catch(...) {
+                error = current_exception();
+            }
+
+            if(job->counter) {
+                signal(job->counter, error);
+            }
+            else if(error) {
+                try {
+                    rethrow_exception(error);
+                }
+                catch(const exception &e) {
+                    print_error("JobSystem", string("Uncaught exception in job: ") + e.what());
+                }
+                catch(...) {
+                    print_error("JobSystem", "Uncaught exception in job.");
+                }
+            }
+            delete job;
+        };
+
+        void idle() {
+            unique_lock<mutex> lock(sleepMutex);
+            sleepingCnt.fetch_add(1, memory_order_seq_cst);
+            atomic_thread_fence(memory_order_seq_cst);
+            if(!stopping.load(memory_order_relaxed) && !hasWork()) {
+                // Timeout is only a safety net
+                wakeUp.wait_for(lock, chrono::milliseconds(10));
+            }
+            sleepingCnt.fetch_sub(1, memory_order_relaxed);
+        };
+
+        void workerLoop(unsigned int index) {
+            tlsSystem = this;
+            tlsIndex = index;
+            PRO_PROFILE_THREAD_NAME("JobSystem " + to_string(index));
+
+            int spinCnt = 0;
+            while(!stopping.load(memory_order_relaxed)) {
+                Job *job = findJob(true);
+                if(job) {
+                    execute(job);
+                    spinCnt = 0;
+                }
+                else if(++spinCnt < 64) {
+                    this_thread::yield();
+                }
+                else {
+                    idle();
+                }
+            }
+        };
+
+        void addJob(function<void()> func, JobCounter *counter, JobCounter *dependency, bool isBackground) {
+            Job *job = new Job {std::move(func), counter, isBackground};
+            if(counter) {
+                counter->count.fetch_add(1, memory_order_relaxed);
+            }
+
+            if(dependency) {
+                lock_guard<mutex> lock(dependency->continuationMutex);
+                if(dependency->count.load(memory_order_acquire) > 0) {
+                    dependency->continuations.push_back(job);
+                    return;
+                }
+            }
+            submit(job);
+        };
+
+    public:
+        // threadCnt: total, INCLUDING the calling thread (0 = hardware concurrency)
+        JobSystem(unsigned int threadCnt = 0) {
+            this->threadCnt = (threadCnt == 0) ? max(1u, thread::hardware_concurrency()) : threadCnt;
+
+            for(unsigned int i = 0; i < this->threadCnt; i++) {
+                allDeques.push_back(make_unique<WorkStealingDeque<Job*>>());
+            }
+
+            // Calling thread is worker 0 (unless it already belongs to another JobSystem)
+            if(!tlsSystem) {
+                tlsSystem = this;
+                tlsIndex = 0;
+            }
+
+            for(unsigned int i = 1; i < this->threadCnt; i++) {
+                allWorkers.emplace_back([this, i]() { workerLoop(i); });
+            }
+        };
+
+        // Jobs that have not started are dropped (wait() on them first)
+        ~JobSystem() {
+            {
+                lock_guard<mutex> lock(sleepMutex);
+                stopping.store(true);
+            }
+            wakeUp.notify_all();
+            for(auto &worker : allWorkers) {
+                worker.join();
+            }
+
+            Job *job = nullptr;
+            for(auto &d : allDeques) {
+                while(d->steal(job)) {
+                    delete job;
+                }
+            }
+            for(Job *j : injectQueue) {
+                delete j;
+            }
+            for(Job *j : backgroundQueue) {
+                delete j;
+            }
+            if(tlsSystem == this) {
+                tlsSystem = nullptr;
+            }
+        };
+
+        // Copy: forbidden (unique ownership)
+        JobSystem(const JobSystem&)            = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        unsigned int getThreadCnt() const noexcept { return threadCnt; };
+
+        void run(function<void()> func, JobCounter *counter = nullptr) {
+            addJob(std::move(func), counter, nullptr, false);
+        };
+
+        // Starts func once dependency reaches zero (right away if it already has)
+        void runAfter(JobCounter &dependency, function<void()> func, JobCounter *counter = nullptr) {
+            addJob(std::move(func), counter, &dependency, false);
+        };
+
+        // For long jobs (e.g., decoding files, compiling pipelines): only idle workers run them, never wait(),
+        // so a thread waiting on its own jobs is not stuck in one of these.
+        // Exception: with a single thread there is no one else, so wait() runs them too.
+        void runBackground(function<void()> func, JobCounter *counter = nullptr) {
+            addJob(std::move(func), counter, nullptr, true);
+        };
+
+        // Runs other (non-background) jobs until counter is done; rethrows the first exception of its jobs.
+        // helpBackground: also runs background jobs (for callers that block on them anyway, e.g., a loading screen)
+        void wait(JobCounter &counter, bool helpBackground = false) {
+            int spinCnt = 0;
+            while(!counter.isDone()) {
+                Job *job = findJob(helpBackground || allWorkers.empty());
+                if(job) {
+                    execute(job);
+                    spinCnt = 0;
+                }
+                else if(++spinCnt < 64) {
+                    this_thread::yield();
+                }
+                else {
+                    this_thread::sleep_for(chrono::microseconds(50));
+                }
+            }
+
+            exception_ptr error = nullptr;
+            {
+                lock_guard<mutex> lock(counter.continuationMutex);
+                swap(error, counter.firstError);
+            }
+            if(error) {
+                rethrow_exception(error);
+            }
+        };
+
+        // Calls func(begin, end) over chunks of [0, count) and waits for all of them.
+        // grainSize: items per chunk (0 = about 4 chunks per thread)
+        void parallelFor(size_t count, const function<void(size_t, size_t)> &func, size_t grainSize = 0) {
+            if(count == 0) {
+                return;
+            }
+            if(grainSize == 0) {
+                grainSize = max<size_t>(1, count / (threadCnt * 4));
+            }
+            if(grainSize >= count) {
+                func(0, count);
+                return;
+            }
+
+            JobCounter counter {};
+            for(size_t begin = 0; begin < count; begin += grainSize) {
+                size_t end = min(count, begin + grainSize);
+                run([&func, begin, end]() { func(begin, end); }, &counter);
+            }
+            wait(counter);
+        };
+
+        // Shared by everything that does not need its own (created on first use by the calling thread).
+        // Always has a worker besides that thread, so background jobs (e.g., streaming) run without a wait().
+        static JobSystem& getDefault() {
+            static JobSystem system(max(2u, thread::hardware_concurrency()));
+            return system;
+        };
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Calls func(i) for i in [0, count) on JobSystem::getDefault(), using at most threadCnt threads 
+    // (0 = all of them); the calling thread also does work.
+    // If func throws, the remaining items are skipped and the first exception is rethrown on the caller.
+    inline void runInParallel(  size_t count, 
+                                const function<void(size_t)> &func, 
+                                unsigned int threadCnt = 0) {
+        JobSystem &jobs = JobSystem::getDefault();
+        if(threadCnt == 0) {
+            threadCnt = jobs.getThreadCnt();
+        }
+        threadCnt = (unsigned int)min<size_t>(threadCnt, count);
+
+        // One job per thread, each pulling items (uneven items balance out)
+        atomic<size_t> next = 0;
+        jobs.parallelFor(threadCnt, [&](size_t, size_t) {
+            try {
+                for(size_t i = next++; i < count; i = next++) {
+                    func(i);
+                }
+            }
+            catch(...) {
+                next = count;
+                throw;
+            }
+        }, 1);
+    };
+}
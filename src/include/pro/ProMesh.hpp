@@ -6,26 +6,228 @@ namespace pro {
     // STRUCTS 
     ///////////////////////////////////////////////////////////////////////////
         
+    // Generic per-vertex attributes produced by the model loaders
+    struct LoaderVertex {
+        glm::vec3 pos {};
+        glm::vec3 normal {};
+        glm::vec2 uv {};
+        glm::vec4 color {1,1,1,1};
+    };
+
+    enum VERTEX_ATTRIB_TYPE {
+        ATTRIB_POS,
+        ATTRIB_NORMAL,
+        ATTRIB_UV,
+        ATTRIB_COLOR
+    };
+
+    // Where one attribute lives inside a vertex (bytes)
+    struct VertexAttribute {
+        uint32_t type = ATTRIB_POS;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    // Controls how a LoaderVertex becomes a T.
+    // By default, fills in whichever of pos/normal/uv/color T has (matching glm types).
+    // Specialize it for vertex types with different names/formats.
+    template<typename T>
+    struct VertexTraits {
+        // Which attributes T actually uses (loaders can skip/generate data accordingly)
+        static constexpr bool hasNormal = requires (T v) { v.normal = glm::vec3(); };
+        static constexpr bool hasUV = requires (T v) { v.uv = glm::vec2(); };
+        static constexpr bool hasColor = requires (T v) { v.color = glm::vec4(); };
+
+        static T fromLoaderVertex(const LoaderVertex &lv) {
+            T v {};
+            if constexpr (requires { v.pos = lv.pos; })         v.pos = lv.pos;
+            if constexpr (requires { v.normal = lv.normal; })   v.normal = lv.normal;
+            if constexpr (requires { v.uv = lv.uv; })           v.uv = lv.uv;
+            if constexpr (requires { v.color = lv.color; })     v.color = lv.color;
+            return v;
+        };
+
+        static LoaderVertex toLoaderVertex(const T &v) {
+            LoaderVertex lv {};
+            if constexpr (requires { lv.pos = v.pos; })         lv.pos = v.pos;
+            if constexpr (requires { lv.normal = v.normal; })   lv.normal = v.normal;
+            if constexpr (requires { lv.uv = v.uv; })           lv.uv = v.uv;
+            if constexpr (requires { lv.color = v.color; })     lv.color = v.color;
+            return lv;
+        };
+
+        // Describes the attributes of T (used to check binary caches still match T)
+        static vector<VertexAttribute> getLayout() {
+            T v {};
+            auto offsetOf = [&v](const auto &member) {
+                return (uint32_t)(reinterpret_cast<const char*>(&member) - reinterpret_cast<const char*>(&v));
+            };
+
+            vector<VertexAttribute> layout {};
+            if constexpr (requires { v.pos = glm::vec3(); })    layout.push_back({ATTRIB_POS, offsetOf(v.pos), sizeof(v.pos)});
+            if constexpr (hasNormal)                            layout.push_back({ATTRIB_NORMAL, offsetOf(v.normal), sizeof(v.normal)});
+            if constexpr (hasUV)                                layout.push_back({ATTRIB_UV, offsetOf(v.uv), sizeof(v.uv)});
+            if constexpr (hasColor)                             layout.push_back({ATTRIB_COLOR, offsetOf(v.color), sizeof(v.color)});
+            return layout;
+        };
+    };
+
+    // Object space
+    struct MeshBounds {
+        // Axis-aligned bounding box
+        glm::vec3 minPos {0,0,0};
+        glm::vec3 maxPos {0,0,0};
+
+        // Bounding sphere (centered on the box)
+        glm::vec3 center {0,0,0};
+        float radius = 0.0f;
+    };
+
     template<typename T>
     struct HostMesh {
         vector<T> vertices {};
         vector<unsigned int> indices {};
+
+        // What the indices are uploaded as; if eUint16, indices16 holds the narrowed copy
+        // (call narrowHostMeshIndices() BEFORE createVulkanMesh() to get 16-bit indices)
+        vk::IndexType indexType = vk::IndexType::eUint32;
+        vector<uint16_t> indices16 {};
+
+        // Set when the positions can't be read back directly (e.g., packHostMesh(); see computeMeshBounds())
+        bool hasBounds = false;
+        MeshBounds bounds {};
     };
     
     struct VulkanMesh {
         VulkanBuffer vertices;
         VulkanBuffer indices;
+        vk::IndexType indexType = vk::IndexType::eUint32;
         unsigned int indexCnt = 0;
+        int32_t vertexOffset = 0;           // First vertex (in vertices, NOT bytes)
+        uint32_t firstIndex = 0;            // First index (in indices, NOT bytes)
+        bool ownsBuffers = true;            // False if buffers belong to a MeshArena
+        MeshBounds bounds {};               // Object space (see computeMeshBounds())
+    };
+
+    // Remembers what is currently bound, so consecutive meshes 
+    // that share buffers (e.g., from a MeshArena) skip redundant binds
+    struct VulkanMeshBindState {
+        vk::Buffer vertices {};
+        vk::Buffer indices {};
+        vk::IndexType indexType = vk::IndexType::eUint32;
     };
         
     ///////////////////////////////////////////////////////////////////////////
     // FUNCTIONS 
     ///////////////////////////////////////////////////////////////////////////  
 
+    // Positions readable as glm::vec3 (T::pos, or T is glm::vec3 itself)
     template<typename T>
-    VulkanMesh createVulkanMesh(    VulkanInitData &vkInitData,                                     
-                                    HostMesh<T> &hostMesh,
-                                    bool isDeviceLocal) {
+    constexpr bool hasReadablePosition = is_same_v<T, glm::vec3> || requires (const T &v) { glm::vec3(v.pos); };
+
+    template<typename T>
+    MeshBounds computeMeshBounds(const T *vertices, size_t vertexCnt) {
+        static_assert(hasReadablePosition<T>, "computeMeshBounds(): T has no glm::vec3 pos "
+                                                "(packed meshes carry their bounds; see packHostMesh())");
+        auto getPos = [vertices](size_t i) {
+            if constexpr (is_same_v<T, glm::vec3>)  return vertices[i];
+            else                                    return glm::vec3(vertices[i].pos);
+        };
+
+        MeshBounds bounds {};
+        if(vertexCnt > 0) {
+            bounds.minPos = bounds.maxPos = getPos(0);
+            for(size_t i = 1; i < vertexCnt; i++) {
+                bounds.minPos = glm::min(bounds.minPos, getPos(i));
+                bounds.maxPos = glm::max(bounds.maxPos, getPos(i));
+            }
+
+            // Tighter than half the box diagonal
+            bounds.center = (bounds.minPos + bounds.maxPos) * 0.5f;
+            float maxDist2 = 0.0f;
+            for(size_t i = 0; i < vertexCnt; i++) {
+                glm::vec3 offset = getPos(i) - bounds.center;
+                maxDist2 = max(maxDist2, glm::dot(offset, offset));
+            }
+            bounds.radius = sqrt(maxDist2);
+        }
+        return bounds;
+    };
+
+    // Uses hostMesh.bounds if set; otherwise T must have a readable position
+    template<typename T>
+    MeshBounds computeMeshBounds(const HostMesh<T> &hostMesh) {
+        if(hostMesh.hasBounds) {
+            return hostMesh.bounds;
+        }
+        if constexpr (hasReadablePosition<T>) {
+            return computeMeshBounds(hostMesh.vertices.data(), hostMesh.vertices.size());
+        }
+        else {
+            print_and_throw_error("computeMeshBounds", "Cannot read the vertex positions and no bounds were set (see packHostMesh())");
+            return {};
+        }
+    };
+
+    inline vk::DeviceSize getIndexSize(vk::IndexType indexType) {
+        switch(indexType) {
+            case vk::IndexType::eUint8EXT:  return 1;
+            case vk::IndexType::eUint16:    return 2;
+            default:                        return 4;
+        }
+    };
+
+    // Picks eUint16 if every index fits in 16 bits (0xFFFF itself is avoided, 
+    // since that is the primitive restart value) and fills in indices16.
+    template<typename T>
+    void narrowHostMeshIndices(HostMesh<T> &hostMesh) {
+        unsigned int maxIndex = 0;
+        for(unsigned int index : hostMesh.indices) {
+            maxIndex = max(maxIndex, index);
+        }
+
+        if(!hostMesh.indices.empty() && maxIndex < 0xFFFF) {
+            hostMesh.indices16.resize(hostMesh.indices.size());
+            for(size_t i = 0; i < hostMesh.indices.size(); i++) {
+                hostMesh.indices16[i] = (uint16_t)hostMesh.indices[i];
+            }
+            hostMesh.indexType = vk::IndexType::eUint16;
+        }
+        else {
+            hostMesh.indices16.clear();
+            hostMesh.indexType = vk::IndexType::eUint32;
+        }
+    };
+
+    // Index data in whatever format hostMesh.indexType says
+    template<typename T>
+    void* getHostMeshIndexData(HostMesh<T> &hostMesh) {
+        if(hostMesh.indexType == vk::IndexType::eUint16) {
+            return hostMesh.indices16.data();
+        }
+        return hostMesh.indices.data();
+    };
+
+    template<typename T>
+    vk::DeviceSize getHostMeshIndexBufferSize(const HostMesh<T> &hostMesh) {
+        return getIndexSize(hostMesh.indexType) * hostMesh.indices.size();
+    };
+
+    // The index buffer was sized for mesh.indexType, so uploading anything else reads the wrong bytes
+    template<typename T>
+    void checkHostMeshIndexType(const string &origin, const HostMesh<T> &hostMesh, const VulkanMesh &mesh) {
+        bool isNarrowed = (hostMesh.indexType == vk::IndexType::eUint16);
+        if(hostMesh.indexType != mesh.indexType
+            || (isNarrowed && hostMesh.indices16.size() != hostMesh.indices.size())) {
+            print_and_throw_error(origin, "Host mesh indices do not match the Vulkan mesh (call narrowHostMeshIndices() BEFORE createVulkanMesh())");
+        }
+    };
+
+    // Creates (empty) vertex/index buffers of the given sizes
+    inline VulkanMesh createVulkanMesh( VulkanInitData &vkInitData,
+                                        vk::DeviceSize vertBufferSize,
+                                        vk::DeviceSize indexBufferSize,
+                                        bool isDeviceLocal) {
         // Set up Vulkan mesh                            
         VulkanMesh mesh;
 
@@ -44,24 +246,38 @@ namespace pro {
         }
 
         // Create vertex buffer and index buffer
-        vk::DeviceSize vertBufferSize = sizeof(hostMesh.vertices[0]) * hostMesh.vertices.size();    
         mesh.vertices = createVulkanBuffer(vkInitData, vertBufferSize, vertUsageFlags, vmaInfo);
-
-        vk::DeviceSize indexBufferSize = sizeof(hostMesh.indices[0]) * hostMesh.indices.size();
         mesh.indices = createVulkanBuffer(vkInitData, indexBufferSize, indexUsageFlags, vmaInfo);
 
         // Return mesh
         return mesh;
     };
 
+    // Uses hostMesh.indexType as is (see narrowHostMeshIndices()); 
+    // upload the SAME host mesh afterwards
+    template<typename T>
+    VulkanMesh createVulkanMesh(    VulkanInitData &vkInitData,                                     
+                                    const HostMesh<T> &hostMesh,
+                                    bool isDeviceLocal) {
+        VulkanMesh mesh = createVulkanMesh( vkInitData,
+                                            sizeof(hostMesh.vertices[0]) * hostMesh.vertices.size(),
+                                            getHostMeshIndexBufferSize(hostMesh),
+                                            isDeviceLocal);
+        mesh.indexType = hostMesh.indexType;
+        mesh.bounds = computeMeshBounds(hostMesh);
+        return mesh;
+    };
+
     template<typename T>
     void copyToHostVisibleVulkanMesh(   VulkanInitData &vkInitData,  
                                         VulkanMesh &mesh,                                   
                                         HostMesh<T> &hostMesh) {
         
+        checkHostMeshIndexType("copyToHostVisibleVulkanMesh", hostMesh, mesh);
+
         // Copy to buffers
         copyToHostVisibleVulkanBuffer(vkInitData, mesh.vertices, hostMesh.vertices.data());
-        copyToHostVisibleVulkanBuffer(vkInitData, mesh.indices, hostMesh.indices.data());
+        copyToHostVisibleVulkanBuffer(vkInitData, mesh.indices, getHostMeshIndexData(hostMesh));
         
         // Set index count
         mesh.indexCnt = hostMesh.indices.size();
@@ -71,26 +287,171 @@ namespace pro {
     void addPendingBufferCopies (   VulkanMesh &mesh,                                   
                                     HostMesh<T> &hostMesh,
                                     vector<PendingBufferCopy> &pendingCopies) {
+        checkHostMeshIndexType("addPendingBufferCopies", hostMesh, mesh);
 
         pendingCopies.push_back(PendingBufferCopy(mesh.vertices, hostMesh.vertices.data(), vk::AccessFlagBits::eVertexAttributeRead));
-        pendingCopies.push_back(PendingBufferCopy(mesh.indices, hostMesh.indices.data(), vk::AccessFlagBits::eIndexRead));
+        pendingCopies.push_back(PendingBufferCopy(mesh.indices, getHostMeshIndexData(hostMesh), vk::AccessFlagBits::eIndexRead));
         
         // Still set index count
         mesh.indexCnt = hostMesh.indices.size();
     };
 
-    void recordDrawVulkanMesh(vk::CommandBuffer &commandBuffer, VulkanMesh &mesh) {
+    inline void recordDrawVulkanMesh(   vk::CommandBuffer &commandBuffer, 
+                                        VulkanMesh &mesh,
+                                        VulkanMeshBindState &bindState) {
         
-        vk::Buffer vertexBuffers[] = {mesh.vertices.buffer};
-        vk::DeviceSize offsets[] = {0};
-        commandBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
-        commandBuffer.bindIndexBuffer(mesh.indices.buffer, 0, vk::IndexType::eUint32);
+        // Only bind if different from what is already bound
+        if(bindState.vertices != mesh.vertices.buffer) {
+            vk::Buffer vertexBuffers[] = {mesh.vertices.buffer};
+            vk::DeviceSize offsets[] = {0};
+            commandBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
+            bindState.vertices = mesh.vertices.buffer;
+        }
+
+        if(bindState.indices != mesh.indices.buffer || bindState.indexType != mesh.indexType) {
+            commandBuffer.bindIndexBuffer(mesh.indices.buffer, 0, mesh.indexType);
+            bindState.indices = mesh.indices.buffer;
+            bindState.indexType = mesh.indexType;
+        }
         
-        commandBuffer.drawIndexed(mesh.indexCnt, 1, 0, 0, 0);
+        commandBuffer.drawIndexed(mesh.indexCnt, 1, mesh.firstIndex, mesh.vertexOffset, 0);
+    };
+
+    inline void recordDrawVulkanMesh(vk::CommandBuffer &commandBuffer, VulkanMesh &mesh) {
+        VulkanMeshBindState bindState {};
+        recordDrawVulkanMesh(commandBuffer, mesh, bindState);
     };   
 
-    void cleanupVulkanMesh(VulkanInitData &vkInitData, VulkanMesh &mesh) {
-        cleanupVulkanBuffer(vkInitData, mesh.vertices);
-        cleanupVulkanBuffer(vkInitData, mesh.indices);
+    inline void cleanupVulkanMesh(VulkanInitData &vkInitData, VulkanMesh &mesh) {
+        // Arena meshes are cleaned up by their MeshArena
+        if(mesh.ownsBuffers) {
+            cleanupVulkanBuffer(vkInitData, mesh.vertices);
+            cleanupVulkanBuffer(vkInitData, mesh.indices);
+        }
+        mesh = {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES 
+    ///////////////////////////////////////////////////////////////////////////  
+
+    // Packs many meshes (with the same vertex type) into a few large 
+    // device-local vertex/index buffers. Meshes from the same block share 
+    // buffers, so drawing them back-to-back only needs one bind.
+    // (Indices stay 32-bit here, since every mesh in a block shares one index buffer.)
+    template<typename T>
+    class MeshArena {
+    private:
+        struct MeshArenaBlock {
+            VulkanBuffer vertices {};
+            VulkanBuffer indices {};
+            vk::DeviceSize vertexCnt = 0;       // Vertices used so far
+            vk::DeviceSize indexCnt = 0;        // Indices used so far
+            vk::DeviceSize vertexCapacity = 0;
+            vk::DeviceSize indexCapacity = 0;
+        };
+
+        VulkanInitData *refInitData;             // Do NOT clean up!!!
+        vector<MeshArenaBlock> allBlocks {};     // Cleaned up explicitly
+        vk::DeviceSize verticesPerBlock = 0;
+        vk::DeviceSize indicesPerBlock = 0;
+
+        MeshArenaBlock& createBlock(vk::DeviceSize vertexCapacity, vk::DeviceSize indexCapacity) {
+            MeshArenaBlock block {};
+            block.vertexCapacity = vertexCapacity;
+            block.indexCapacity = indexCapacity;
+            block.vertices = createVulkanBuffer(*refInitData, 
+                                                vertexCapacity * sizeof(T), 
+                                                vk::BufferUsageFlagBits::eVertexBuffer 
+                                                    | vk::BufferUsageFlagBits::eTransferDst,
+                                                createVMADeviceLocalInfo());
+            block.indices = createVulkanBuffer( *refInitData, 
+                                                indexCapacity * sizeof(unsigned int), 
+                                                vk::BufferUsageFlagBits::eIndexBuffer 
+                                                    | vk::BufferUsageFlagBits::eTransferDst,
+                                                createVMADeviceLocalInfo());
+            allBlocks.push_back(block);
+            return allBlocks.back();
+        };
+
+    public:
+        MeshArena(  VulkanInitData &vkInitData, 
+                    vk::DeviceSize verticesPerBlock = 1 << 20,
+                    vk::DeviceSize indicesPerBlock = 3 << 20) {
+            refInitData = &vkInitData;
+            this->verticesPerBlock = verticesPerBlock;
+            this->indicesPerBlock = indicesPerBlock;
+        };
+
+        ~MeshArena() {
+            for(auto &block : allBlocks) {
+                cleanupVulkanBuffer(*refInitData, block.vertices);
+                cleanupVulkanBuffer(*refInitData, block.indices);
+            }
+            allBlocks.clear();
+        };
+
+        // Copy: forbidden (unique ownership)
+        MeshArena(const MeshArena&)            = delete;
+        MeshArena& operator=(const MeshArena&) = delete;
+
+        unsigned int getBlockCount() const noexcept { return (unsigned int)allBlocks.size(); };
+
+        // Reserves space for hostMesh and queues up its copies.
+        // (hostMesh must stay alive until the copies are submitted)
+        VulkanMesh addMesh( HostMesh<T> &hostMesh,
+                            vector<PendingBufferCopy> &pendingCopies) {
+
+            vk::DeviceSize vertexCnt = hostMesh.vertices.size();
+            vk::DeviceSize indexCnt = hostMesh.indices.size();
+
+            // Find a block with room (only check the most recent one; blocks are filled in order)
+            MeshArenaBlock *block = nullptr;
+            if(!allBlocks.empty()) {
+                MeshArenaBlock &last = allBlocks.back();
+                if(last.vertexCnt + vertexCnt <= last.vertexCapacity 
+                    && last.indexCnt + indexCnt <= last.indexCapacity) {
+                    block = &last;
+                }
+            }
+
+            // Otherwise, start a new block (big enough for this mesh at least)
+            if(!block) {
+                block = &createBlock(   max(verticesPerBlock, vertexCnt), 
+                                        max(indicesPerBlock, indexCnt));
+            }
+
+            // Set up mesh that points into the block
+            VulkanMesh mesh {};
+            mesh.vertices = block->vertices;
+            mesh.indices = block->indices;
+            mesh.indexCnt = (unsigned int)indexCnt;
+            mesh.vertexOffset = (int32_t)block->vertexCnt;
+            mesh.firstIndex = (uint32_t)block->indexCnt;
+            mesh.ownsBuffers = false;
+            mesh.bounds = computeMeshBounds(hostMesh);
+
+            // Queue up copies into the correct ranges (zero-size copies are invalid)
+            if(vertexCnt > 0) {
+                pendingCopies.push_back(PendingBufferCopy(  block->vertices, 
+                                                            hostMesh.vertices.data(), 
+                                                            vk::AccessFlagBits::eVertexAttributeRead,
+                                                            block->vertexCnt * sizeof(T),
+                                                            vertexCnt * sizeof(T)));
+            }
+            if(indexCnt > 0) {
+                pendingCopies.push_back(PendingBufferCopy(  block->indices, 
+                                                            hostMesh.indices.data(), 
+                                                            vk::AccessFlagBits::eIndexRead,
+                                                            block->indexCnt * sizeof(unsigned int),
+                                                            indexCnt * sizeof(unsigned int)));
+            }
+            
+            // Move forward in block
+            block->vertexCnt += vertexCnt;
+            block->indexCnt += indexCnt;
+
+            return mesh;
+        };
     };
 }
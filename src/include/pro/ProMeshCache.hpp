@@ -0,0 +1,306 @@
+#pragma once
+#include "ProFile.hpp"
+#include "ProObj.hpp"
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Bump whenever the file layout changes (old caches are then rebuilt)
+    const uint32_t MESH_CACHE_VERSION = 3;
+    const char MESH_CACHE_MAGIC[4] = {'P','M','S','H'};
+    const uint64_t MESH_CACHE_BLOB_ALIGNMENT = 16;
+
+    // File layout:
+    //  MeshCacheHeader
+    //  VertexAttribute[attributeCnt]
+    //  (padding) vertex blob at vertexBlobOffset
+    //  (padding) index blob at indexBlobOffset (uint16_t or uint32_t; see indexSize)
+    struct MeshCacheHeader {
+        char magic[4] = {'P','M','S','H'};
+        uint32_t version = MESH_CACHE_VERSION;
+
+        // Source file info (cache is stale if either changes)
+        uint64_t sourceHash = 0;
+        int64_t sourceModifiedTime = 0;
+        uint64_t sourceSize = 0;
+
+        // Vertex layout
+        uint32_t vertexStride = 0;
+        uint32_t attributeCnt = 0;
+
+        // 2 or 4 bytes (16-bit whenever the indices fit)
+        uint32_t indexSize = 4;
+        uint32_t reserved = 0;
+
+        // Blobs
+        uint64_t vertexCnt = 0;
+        uint64_t indexCnt = 0;
+        uint64_t vertexBlobOffset = 0;
+        uint64_t indexBlobOffset = 0;
+
+        // Bounds
+        float boundsMin[3] = {0,0,0};
+        float boundsMax[3] = {0,0,0};
+        float boundsSphere[4] = {0,0,0,0};      // Center, radius
+    };
+
+    struct MeshCacheOptions {
+        // Empty = source filename + ".pmesh"
+        string cacheFilename = "";
+
+        // If false, only mtime/size are compared (skips reading the whole source)
+        bool verifySourceHash = true;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // HELPER FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    inline uint64_t alignMeshCacheOffset(uint64_t offset) {
+        return (offset + MESH_CACHE_BLOB_ALIGNMENT - 1) & ~(MESH_CACHE_BLOB_ALIGNMENT - 1);
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    // A mesh read straight out of a memory-mapped cache file.
+    // vertices()/indexData() point INTO the mapping (no copies),
+    // so this must stay alive until any uploads from it are submitted.
+    template<typename T>
+    class MappedHostMesh {
+    private:
+        MappedFile file {};
+        const MeshCacheHeader *header = nullptr;
+
+    public:
+        MappedHostMesh() = default;
+
+        // Maps filename and checks it is a valid cache for T (returns false otherwise)
+        bool open(const string &filename) {
+            header = nullptr;
+            if(!file.open(filename) || file.size() < sizeof(MeshCacheHeader)) {
+                return false;
+            }
+
+            const MeshCacheHeader *h = reinterpret_cast<const MeshCacheHeader*>(file.data());
+            if(memcmp(h->magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0
+                || h->version != MESH_CACHE_VERSION) {
+                return false;
+            }
+
+            // Vertex layout must match T exactly
+            vector<VertexAttribute> layout = VertexTraits<T>::getLayout();
+            if(h->vertexStride != sizeof(T) || h->attributeCnt != layout.size()
+                || file.size() < sizeof(MeshCacheHeader) + layout.size()*sizeof(VertexAttribute)) {
+                return false;
+            }
+            const VertexAttribute *fileLayout = reinterpret_cast<const VertexAttribute*>(file.data() + sizeof(MeshCacheHeader));
+            for(size_t i = 0; i < layout.size(); i++) {
+                if(fileLayout[i].type != layout[i].type
+                    || fileLayout[i].offset != layout[i].offset
+                    || fileLayout[i].size != layout[i].size) {
+                    return false;
+                }
+            }
+
+            // Blobs must actually be in the file (truncated writes, etc.)
+            if((h->indexSize != 2 && h->indexSize != 4)
+                || h->vertexBlobOffset + h->vertexCnt*sizeof(T) > file.size()
+                || h->indexBlobOffset + h->indexCnt*h->indexSize > file.size()) {
+                return false;
+            }
+
+            header = h;
+            return true;
+        };
+
+        bool isOpen() const noexcept { return header != nullptr; };
+        const MeshCacheHeader& getHeader() const { return *header; };
+
+        const T* vertices() const { return reinterpret_cast<const T*>(file.data() + header->vertexBlobOffset); };
+        const void* indexData() const { return file.data() + header->indexBlobOffset; };
+        size_t vertexCnt() const { return (size_t)header->vertexCnt; };
+        size_t indexCnt() const { return (size_t)header->indexCnt; };
+        vk::IndexType indexType() const { return (header->indexSize == 2) ? vk::IndexType::eUint16 : vk::IndexType::eUint32; };
+
+        unsigned int getIndex(size_t i) const {
+            if(header->indexSize == 2) {
+                return reinterpret_cast<const uint16_t*>(indexData())[i];
+            }
+            return reinterpret_cast<const uint32_t*>(indexData())[i];
+        };
+
+        MeshBounds bounds() const {
+            MeshBounds b {};
+            b.minPos = glm::vec3(header->boundsMin[0], header->boundsMin[1], header->boundsMin[2]);
+            b.maxPos = glm::vec3(header->boundsMax[0], header->boundsMax[1], header->boundsMax[2]);
+            b.center = glm::vec3(header->boundsSphere[0], header->boundsSphere[1], header->boundsSphere[2]);
+            b.radius = header->boundsSphere[3];
+            return b;
+        };
+
+        // Only for when a real HostMesh is needed (this DOES copy)
+        HostMesh<T> toHostMesh() const {
+            HostMesh<T> mesh {};
+            mesh.vertices.assign(vertices(), vertices() + vertexCnt());
+            mesh.indices.resize(indexCnt());
+            for(size_t i = 0; i < indexCnt(); i++) {
+                mesh.indices[i] = getIndex(i);
+            }
+            mesh.bounds = bounds();
+            mesh.hasBounds = true;
+            return mesh;
+        };
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    template<typename T>
+    bool writeMeshCache(const string &cacheFilename,
+                        HostMesh<T> &hostMesh,
+                        uint64_t sourceHash, int64_t sourceModifiedTime, uint64_t sourceSize) {
+        vector<VertexAttribute> layout = VertexTraits<T>::getLayout();
+        MeshBounds bounds = computeMeshBounds(hostMesh);
+        narrowHostMeshIndices(hostMesh);
+
+        MeshCacheHeader header {};
+        header.sourceHash = sourceHash;
+        header.sourceModifiedTime = sourceModifiedTime;
+        header.sourceSize = sourceSize;
+        header.vertexStride = sizeof(T);
+        header.attributeCnt = (uint32_t)layout.size();
+        header.indexSize = (uint32_t)getIndexSize(hostMesh.indexType);
+        header.vertexCnt = hostMesh.vertices.size();
+        header.indexCnt = hostMesh.indices.size();
+        header.vertexBlobOffset = alignMeshCacheOffset(sizeof(MeshCacheHeader) + layout.size()*sizeof(VertexAttribute));
+        header.indexBlobOffset = alignMeshCacheOffset(header.vertexBlobOffset + header.vertexCnt*sizeof(T));
+        for(int i = 0; i < 3; i++) {
+            header.boundsMin[i] = bounds.minPos[i];
+            header.boundsMax[i] = bounds.maxPos[i];
+            header.boundsSphere[i] = bounds.center[i];
+        }
+        header.boundsSphere[3] = bounds.radius;
+
+        // Same trick as the pipeline cache: write temp file, then rename
+        string tempFilename = cacheFilename + ".tmp";
+        {
+            ofstream file(tempFilename, ios::binary | ios::trunc);
+            if(!file.is_open()) {
+                print_warning("writeMeshCache", "Cannot open file: " + tempFilename);
+                return false;
+            }
+
+            const char zeros[MESH_CACHE_BLOB_ALIGNMENT] = {};
+            auto padTo = [&file, &zeros](uint64_t offset) {
+                uint64_t pos = (uint64_t)file.tellp();
+                file.write(zeros, offset - pos);
+            };
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(layout.data()), layout.size()*sizeof(VertexAttribute));
+            padTo(header.vertexBlobOffset);
+            file.write(reinterpret_cast<const char*>(hostMesh.vertices.data()), header.vertexCnt*sizeof(T));
+            padTo(header.indexBlobOffset);
+            file.write(reinterpret_cast<const char*>(getHostMeshIndexData(hostMesh)), getHostMeshIndexBufferSize(hostMesh));
+
+            if(!file) {
+                print_warning("writeMeshCache", "Failed writing file: " + tempFilename);
+                return false;
+            }
+        }
+
+        error_code err;
+        filesystem::rename(tempFilename, cacheFilename, err);
+        if(err) {
+            print_warning("writeMeshCache", "Cannot replace " + cacheFilename + ": " + err.message());
+            filesystem::remove(tempFilename, err);
+            return false;
+        }
+        return true;
+    };
+
+    // Maps the binary cache for sourceFilename, (re)building it with loadFunc
+    // if it is missing, for a different T, or the source has changed.
+    template<typename T>
+    MappedHostMesh<T> loadMeshCached(   const string &sourceFilename,
+                                        function<HostMesh<T>(const string&)> loadFunc = [](const string &f) { return loadOBJ<T>(f); },
+                                        MeshCacheOptions options = {}) {
+        string cacheFilename = options.cacheFilename.empty() ? (sourceFilename + ".pmesh") : options.cacheFilename;
+
+        error_code err;
+        uint64_t sourceSize = (uint64_t)filesystem::file_size(sourceFilename, err);
+        if(err) {
+            print_and_throw_error("loadMeshCached", "Cannot open source: " + sourceFilename);
+        }
+        int64_t sourceModifiedTime = getFileModifiedTime(sourceFilename);
+
+        // Only hash if we need to (cheap checks first)
+        uint64_t sourceHash = 0;
+        bool haveHash = false;
+        auto getSourceHash = [&]() {
+            if(!haveHash) {
+                if(!hashFile(sourceFilename, sourceHash)) {
+                    print_and_throw_error("loadMeshCached", "Cannot read source: " + sourceFilename);
+                }
+                haveHash = true;
+            }
+            return sourceHash;
+        };
+
+        // Try existing cache
+        MappedHostMesh<T> cached {};
+        if(cached.open(cacheFilename)) {
+            const MeshCacheHeader &h = cached.getHeader();
+            bool isValid = (h.sourceModifiedTime == sourceModifiedTime && h.sourceSize == sourceSize);
+            if(isValid && options.verifySourceHash) {
+                isValid = (h.sourceHash == getSourceHash());
+            }
+            if(isValid) {
+                return cached;
+            }
+        }
+
+        // Rebuild (unmap the stale cache first; Windows cannot replace a mapped file)
+        cached = MappedHostMesh<T>();
+        HostMesh<T> hostMesh = loadFunc(sourceFilename);
+        if(!writeMeshCache(cacheFilename, hostMesh, getSourceHash(), sourceModifiedTime, sourceSize)
+            || !cached.open(cacheFilename)) {
+            print_and_throw_error("loadMeshCached", "Cannot create cache: " + cacheFilename);
+        }
+        return cached;
+    };
+
+    // Upload directly from the mapping (the staging copy reads the mapped pages)
+    template<typename T>
+    VulkanMesh createVulkanMesh(VulkanInitData &vkInitData,
+                                const MappedHostMesh<T> &mappedMesh,
+                                bool isDeviceLocal) {
+        VulkanMesh mesh = createVulkanMesh( vkInitData,
+                                            mappedMesh.vertexCnt()*sizeof(T),
+                                            mappedMesh.indexCnt()*getIndexSize(mappedMesh.indexType()),
+                                            isDeviceLocal);
+        mesh.indexType = mappedMesh.indexType();
+        mesh.bounds = mappedMesh.bounds();
+        return mesh;
+    };
+
+    template<typename T>
+    void addPendingBufferCopies (   VulkanMesh &mesh,
+                                    const MappedHostMesh<T> &mappedMesh,
+                                    vector<PendingBufferCopy> &pendingCopies) {
+        // Transfers only read from hostData, so the read-only mapping is fine
+        pendingCopies.push_back(PendingBufferCopy(  mesh.vertices,
+                                                    const_cast<T*>(mappedMesh.vertices()),
+                                                    vk::AccessFlagBits::eVertexAttributeRead));
+        pendingCopies.push_back(PendingBufferCopy(  mesh.indices,
+                                                    const_cast<void*>(mappedMesh.indexData()),
+                                                    vk::AccessFlagBits::eIndexRead));
+        mesh.indexCnt = (unsigned int)mappedMesh.indexCnt();
+    };
+}
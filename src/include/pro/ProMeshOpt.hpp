@@ -0,0 +1,368 @@
+#pragma once
+#include "ProMesh.hpp"
+#include <algorithm>
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    struct VertexCacheStats {
+        float acmr = 0.0f;      // Average Cache Miss Ratio (vertex shader runs per triangle; 0.5 is ideal, 3 is worst)
+        float atvr = 0.0f;      // Average Transformed Vertex Ratio (vertex shader runs per used vertex; 1 is ideal)
+    };
+
+    struct MeshOptOptions {
+        unsigned int cacheSize = 16;        // Post-transform cache size to optimize for
+        bool optimizeVertexCache = true;    // Tipsify
+        bool optimizeOverdraw = true;       // Sort Tipsify clusters front-to-back-ish (needs T::pos)
+        float clusterACMR = 0.75f;          // Lambda: a cluster also ends once its own ACMR drops to this
+                                            // (soft boundary; 0 = only where Tipsify jumped)
+        bool optimizeVertexFetch = true;    // Reorder vertices into first-use order
+    };
+
+    struct MeshOptReport {
+        VertexCacheStats before {};
+        VertexCacheStats after {};
+        size_t hardClusterCnt = 0;          // Clusters from Tipsify's jumps alone
+        size_t clusterCnt = 0;              // After the soft boundaries (what the overdraw pass sorts)
+        size_t removedVertexCnt = 0;        // Vertices no triangle used (dropped by vertex fetch pass)
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Simulates a FIFO post-transform cache of cacheSize vertices
+    inline VertexCacheStats computeVertexCacheStats(const vector<unsigned int> &indices,
+                                                    size_t vertexCnt,
+                                                    unsigned int cacheSize = 16) {
+        VertexCacheStats stats {};
+        if(indices.empty()) {
+            return stats;
+        }
+
+        // Vertex is in the cache if fewer than cacheSize misses happened since it was loaded
+        vector<int64_t> loadedAt(vertexCnt, -(int64_t)cacheSize - 1);
+        vector<bool> used(vertexCnt, false);
+        int64_t misses = 0;
+        size_t usedCnt = 0;
+
+        for(unsigned int v : indices) {
+            if(misses - loadedAt[v] > (int64_t)cacheSize - 1) {
+                loadedAt[v] = misses;
+                misses++;
+            }
+            if(!used[v]) {
+                used[v] = true;
+                usedCnt++;
+            }
+        }
+
+        stats.acmr = (float)misses / (float)(indices.size() / 3);
+        stats.atvr = (float)misses / (float)usedCnt;
+        return stats;
+    };
+
+    // Tipsify (Sander et al. 2007, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+    // Returns reordered indices; clusterStarts gets the first triangle of each
+    // "hard boundary" cluster (where the fan had to jump somewhere else).
+    inline vector<unsigned int> optimizeVertexCacheTipsify( const vector<unsigned int> &indices,
+                                                            size_t vertexCnt,
+                                                            unsigned int cacheSize,
+                                                            vector<size_t> &clusterStarts) {
+        size_t triCnt = indices.size() / 3;
+        vector<unsigned int> output {};
+        output.reserve(triCnt * 3);
+        clusterStarts.clear();
+        if(triCnt == 0) {
+            return output;
+        }
+
+        // Vertex -> triangle adjacency (CSR)
+        vector<unsigned int> live(vertexCnt, 0);
+        for(size_t i = 0; i < triCnt * 3; i++) {
+            live[indices[i]]++;
+        }
+        vector<size_t> adjStart(vertexCnt + 1, 0);
+        for(size_t v = 0; v < vertexCnt; v++) {
+            adjStart[v + 1] = adjStart[v] + live[v];
+        }
+        vector<unsigned int> adj(adjStart[vertexCnt]);
+        {
+            vector<size_t> fill(adjStart.begin(), adjStart.end() - 1);
+            for(size_t t = 0; t < triCnt; t++) {
+                for(int k = 0; k < 3; k++) {
+                    adj[fill[indices[t*3 + k]]++] = (unsigned int)t;
+                }
+            }
+        }
+
+        vector<int64_t> cacheTime(vertexCnt, 0);
+        vector<bool> emitted(triCnt, false);
+        vector<unsigned int> deadEnd {};
+        vector<unsigned int> candidates {};
+        int64_t time = (int64_t)cacheSize + 1;
+        size_t cursor = 0;
+
+        auto skipDeadEnd = [&]() -> int64_t {
+            while(!deadEnd.empty()) {
+                unsigned int d = deadEnd.back();
+                deadEnd.pop_back();
+                if(live[d] > 0) {
+                    return d;
+                }
+            }
+            while(cursor < vertexCnt) {
+                if(live[cursor] > 0) {
+                    return (int64_t)cursor;
+                }
+                cursor++;
+            }
+            return -1;
+        };
+
+        int64_t fanning = skipDeadEnd();
+        clusterStarts.push_back(0);
+
+        while(fanning >= 0) {
+            // Emit all remaining triangles around the fanning vertex
+            candidates.clear();
+            for(size_t a = adjStart[fanning]; a < adjStart[fanning + 1]; a++) {
+                unsigned int t = adj[a];
+                if(emitted[t]) {
+                    continue;
+                }
+                for(int k = 0; k < 3; k++) {
+                    unsigned int v = indices[t*3 + k];
+                    output.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if(time - cacheTime[v] > (int64_t)cacheSize) {
+                        cacheTime[v] = time;
+                        time++;
+                    }
+                }
+                emitted[t] = true;
+            }
+
+            // Next fanning vertex: the one that will stay in the cache longest after its fan
+            int64_t best = -1;
+            int64_t bestPriority = -1;
+            for(unsigned int v : candidates) {
+                if(live[v] > 0) {
+                    int64_t priority = 0;
+                    if(time - cacheTime[v] + 2*(int64_t)live[v] <= (int64_t)cacheSize) {
+                        priority = time - cacheTime[v];
+                    }
+                    if(priority > bestPriority) {
+                        bestPriority = priority;
+                        best = v;
+                    }
+                }
+            }
+
+            if(best == -1) {
+                best = skipDeadEnd();
+                if(best >= 0) {
+                    clusterStarts.push_back(output.size() / 3);
+                }
+            }
+            fanning = best;
+        }
+
+        return output;
+    };
+
+    // Sander et al.'s soft boundaries: walks the Tipsify order and also ends a cluster once its ACMR
+    // (cache cold at each cluster start, since the clusters get reordered) drops to lambda.
+    // Connected meshes have few dead ends, so without these there is little for optimizeOverdraw() to sort.
+    // clusterStarts: hard boundaries in, hard + soft boundaries out.
+    inline void addSoftClusterBoundaries(   const vector<unsigned int> &indices,
+                                            size_t vertexCnt,
+                                            unsigned int cacheSize,
+                                            float lambda,
+                                            vector<size_t> &clusterStarts) {
+        size_t triCnt = indices.size() / 3;
+        if(lambda <= 0.0f || triCnt == 0) {
+            return;
+        }
+
+        vector<size_t> hardStarts = clusterStarts;
+        clusterStarts.clear();
+
+        // In the cache if loaded since the cluster began and fewer than cacheSize misses ago
+        vector<int64_t> loadedAt(vertexCnt, -1);
+        int64_t misses = 0;
+        int64_t clusterMissStart = 0;
+        size_t clusterTriStart = 0;
+        size_t nextHard = 0;
+
+        auto startCluster = [&](size_t t) {
+            clusterStarts.push_back(t);
+            clusterTriStart = t;
+            clusterMissStart = misses;
+        };
+
+        for(size_t t = 0; t < triCnt; t++) {
+            if(nextHard < hardStarts.size() && hardStarts[nextHard] == t) {
+                nextHard++;
+                if(clusterStarts.empty() || clusterStarts.back() != t) {
+                    startCluster(t);
+                }
+            }
+
+            for(int k = 0; k < 3; k++) {
+                unsigned int v = indices[t*3 + k];
+                if(loadedAt[v] < clusterMissStart || misses - loadedAt[v] > (int64_t)cacheSize - 1) {
+                    loadedAt[v] = misses;
+                    misses++;
+                }
+            }
+
+            float clusterACMR = (float)(misses - clusterMissStart) / (float)(t - clusterTriStart + 1);
+            bool isNextHard = (nextHard < hardStarts.size() && hardStarts[nextHard] == t + 1);
+            if(clusterACMR <= lambda && t + 1 < triCnt && !isNextHard) {
+                startCluster(t + 1);
+            }
+        }
+    };
+
+    // Reorders whole clusters so ones facing "outward" (likely occluders) draw first.
+    // Keeps the triangle order inside each cluster, so cache efficiency is (mostly) kept.
+    inline vector<unsigned int> optimizeOverdraw(   const vector<unsigned int> &indices,
+                                                    const vector<glm::vec3> &positions,
+                                                    const vector<size_t> &clusterStarts) {
+        size_t triCnt = indices.size() / 3;
+        size_t clusterCnt = clusterStarts.size();
+        if(clusterCnt <= 1) {
+            return indices;
+        }
+
+        // Mesh center (area-weighted)
+        auto triangleCross = [&](size_t t) {
+            const glm::vec3 &a = positions[indices[t*3]];
+            const glm::vec3 &b = positions[indices[t*3 + 1]];
+            const glm::vec3 &c = positions[indices[t*3 + 2]];
+            return glm::cross(b - a, c - a);
+        };
+        auto triangleCenter = [&](size_t t) {
+            return (positions[indices[t*3]] + positions[indices[t*3 + 1]] + positions[indices[t*3 + 2]]) / 3.0f;
+        };
+
+        glm::vec3 meshCenter(0,0,0);
+        float meshArea = 0.0f;
+        for(size_t t = 0; t < triCnt; t++) {
+            float area = glm::length(triangleCross(t));
+            meshCenter += triangleCenter(t) * area;
+            meshArea += area;
+        }
+        if(meshArea > 0.0f) {
+            meshCenter /= meshArea;
+        }
+
+        // Sort key per cluster: how much it faces away from the center
+        vector<float> clusterKey(clusterCnt, 0.0f);
+        for(size_t c = 0; c < clusterCnt; c++) {
+            size_t start = clusterStarts[c];
+            size_t end = (c + 1 < clusterCnt) ? clusterStarts[c + 1] : triCnt;
+
+            glm::vec3 center(0,0,0);
+            glm::vec3 normal(0,0,0);
+            float area = 0.0f;
+            for(size_t t = start; t < end; t++) {
+                glm::vec3 cross = triangleCross(t);
+                float triArea = glm::length(cross);
+                center += triangleCenter(t) * triArea;
+                normal += cross;
+                area += triArea;
+            }
+            if(area > 0.0f && glm::length(normal) > 0.0f) {
+                center /= area;
+                clusterKey[c] = glm::dot(center - meshCenter, glm::normalize(normal));
+            }
+        }
+
+        vector<size_t> order(clusterCnt);
+        for(size_t c = 0; c < clusterCnt; c++) {
+            order[c] = c;
+        }
+        stable_sort(order.begin(), order.end(), [&clusterKey](size_t a, size_t b) {
+            return clusterKey[a] > clusterKey[b];
+        });
+
+        vector<unsigned int> output {};
+        output.reserve(indices.size());
+        for(size_t c : order) {
+            size_t start = clusterStarts[c];
+            size_t end = (c + 1 < clusterCnt) ? clusterStarts[c + 1] : triCnt;
+            output.insert(output.end(), indices.begin() + start*3, indices.begin() + end*3);
+        }
+        return output;
+    };
+
+    // Reorders vertices into the order the indices first use them (and drops unused ones).
+    // Returns the number of vertices removed.
+    template<typename T>
+    size_t optimizeVertexFetch(HostMesh<T> &hostMesh) {
+        const unsigned int UNUSED = ~0u;
+        vector<unsigned int> remap(hostMesh.vertices.size(), UNUSED);
+        vector<T> newVertices {};
+        newVertices.reserve(hostMesh.vertices.size());
+
+        for(auto &index : hostMesh.indices) {
+            if(remap[index] == UNUSED) {
+                remap[index] = (unsigned int)newVertices.size();
+                newVertices.push_back(hostMesh.vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        size_t removedCnt = hostMesh.vertices.size() - newVertices.size();
+        hostMesh.vertices = std::move(newVertices);
+        return removedCnt;
+    };
+
+    // Runs the whole optimization pipeline on hostMesh (in place)
+    template<typename T>
+    MeshOptReport optimizeHostMesh(HostMesh<T> &hostMesh, MeshOptOptions options = {}) {
+        MeshOptReport report {};
+        report.before = computeVertexCacheStats(hostMesh.indices, hostMesh.vertices.size(), options.cacheSize);
+
+        if(options.optimizeVertexCache) {
+            vector<size_t> clusterStarts {};
+            hostMesh.indices = optimizeVertexCacheTipsify(  hostMesh.indices, hostMesh.vertices.size(),
+                                                            options.cacheSize, clusterStarts);
+            report.hardClusterCnt = clusterStarts.size();
+
+            if constexpr (requires (T v) { glm::vec3(v.pos); }) {
+                if(options.optimizeOverdraw) {
+                    addSoftClusterBoundaries(   hostMesh.indices, hostMesh.vertices.size(), options.cacheSize,
+                                                options.clusterACMR, clusterStarts);
+                    vector<glm::vec3> positions(hostMesh.vertices.size());
+                    for(size_t i = 0; i < positions.size(); i++) {
+                        positions[i] = glm::vec3(hostMesh.vertices[i].pos);
+                    }
+                    hostMesh.indices = optimizeOverdraw(hostMesh.indices, positions, clusterStarts);
+                }
+            }
+            report.clusterCnt = clusterStarts.size();
+        }
+
+        if(options.optimizeVertexFetch) {
+            report.removedVertexCnt = optimizeVertexFetch(hostMesh);
+        }
+
+        report.after = computeVertexCacheStats(hostMesh.indices, hostMesh.vertices.size(), options.cacheSize);
+        return report;
+    };
+
+    inline void printMeshOptReport(const MeshOptReport &report) {
+        cout << "ACMR: " << report.before.acmr << " -> " << report.after.acmr << endl;
+        cout << "ATVR: " << report.before.atvr << " -> " << report.after.atvr << endl;
+        cout << "Clusters: " << report.clusterCnt << " (" << report.hardClusterCnt << " from Tipsify jumps)"
+                << ", unused vertices removed: " << report.removedVertexCnt << endl;
+    };
+}
@@ -0,0 +1,227 @@
+#pragma once
+#include "ProMesh.hpp"
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    struct ModelLoadOptions {
+        // Always applied
+        unsigned int postProcessFlags = aiProcess_Triangulate 
+                                        | aiProcess_JoinIdenticalVertices 
+                                        | aiProcess_SortByPType;
+
+        // If true, adds flags based on VertexTraits<T> 
+        // (e.g., generate smooth normals only if T has normals)
+        bool addFlagsFromTraits = true;
+
+        // Threads for converting meshes (0 = all of JobSystem::getDefault())
+        unsigned int threadCnt = 0;
+
+        // false: one mesh per aiMesh, placed by HostModel::instances (shared geometry stays shared)
+        // true: one mesh per instance, already transformed into model space (instance transforms are identity)
+        bool bakeTransforms = false;
+    };
+
+    // One placement of a mesh by the node hierarchy
+    struct ModelInstance {
+        unsigned int meshIndex = 0;                 // Into HostModel::meshes
+        glm::mat4 transform = glm::mat4(1.0f);      // Mesh --> model space (all parent nodes applied)
+    };
+
+    template<typename T>
+    struct HostModel {
+        vector<HostMesh<T>> meshes {};
+        vector<unsigned int> materialIndices {};    // One per mesh (index into the aiScene's materials)
+        vector<ModelInstance> instances {};         // What to draw (a mesh may appear several times, or not at all)
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // HELPER FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // assimp matrices are row-major
+    inline glm::mat4 toGLMMatrix(const aiMatrix4x4 &m) {
+        return glm::transpose(glm::make_mat4(&m.a1));
+    };
+
+    // Walks the node hierarchy, accumulating transforms
+    inline void collectModelInstances(  const aiNode *node, 
+                                        const glm::mat4 &parentTransform,
+                                        vector<ModelInstance> &allInstances) {
+        glm::mat4 transform = parentTransform * toGLMMatrix(node->mTransformation);
+        for(unsigned int k = 0; k < node->mNumMeshes; k++) {
+            allInstances.push_back({ node->mMeshes[k], transform });
+        }
+        for(unsigned int c = 0; c < node->mNumChildren; c++) {
+            collectModelInstances(node->mChildren[c], transform, allInstances);
+        }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    template<typename T>
+    unsigned int getModelPostProcessFlags(const ModelLoadOptions &options) {
+        unsigned int flags = options.postProcessFlags;
+        if(options.addFlagsFromTraits) {
+            if constexpr (VertexTraits<T>::hasNormal) {
+                flags |= aiProcess_GenSmoothNormals;
+            }
+            else {
+                // Don't pay for normals we'll throw away
+                flags &= ~(aiProcess_GenNormals | aiProcess_GenSmoothNormals);
+            }
+            if constexpr (VertexTraits<T>::hasUV) {
+                flags |= aiProcess_GenUVCoords;
+            }
+        }
+        return flags;
+    };
+
+    // transform: if given, positions/normals are moved into that space (for baking instances)
+    template<typename T>
+    HostMesh<T> convertAssimpMesh(const aiMesh *aim, const glm::mat4 *transform = nullptr) {
+        HostMesh<T> mesh {};
+        mesh.vertices.reserve(aim->mNumVertices);
+        mesh.indices.reserve((size_t)aim->mNumFaces * 3);
+
+        bool hasNormals = aim->HasNormals();
+        bool hasUVs = aim->HasTextureCoords(0);
+        bool hasColors = aim->HasVertexColors(0);
+
+        glm::mat3 normalTransform = transform ? glm::transpose(glm::inverse(glm::mat3(*transform))) : glm::mat3(1.0f);
+        bool isMirrored = transform && glm::determinant(glm::mat3(*transform)) < 0.0f;
+
+        for(unsigned int v = 0; v < aim->mNumVertices; v++) {
+            LoaderVertex lv {};
+            lv.pos = glm::vec3(aim->mVertices[v].x, aim->mVertices[v].y, aim->mVertices[v].z);
+            if(transform) {
+                lv.pos = glm::vec3((*transform) * glm::vec4(lv.pos, 1.0f));
+            }
+
+            if constexpr (VertexTraits<T>::hasNormal) {
+                if(hasNormals) {
+                    lv.normal = glm::vec3(aim->mNormals[v].x, aim->mNormals[v].y, aim->mNormals[v].z);
+                    if(transform) {
+                        lv.normal = glm::normalize(normalTransform * lv.normal);
+                    }
+                }
+            }
+            if constexpr (VertexTraits<T>::hasUV) {
+                if(hasUVs) {
+                    lv.uv = glm::vec2(aim->mTextureCoords[0][v].x, aim->mTextureCoords[0][v].y);
+                }
+            }
+            if constexpr (VertexTraits<T>::hasColor) {
+                if(hasColors) {
+                    const aiColor4D &c = aim->mColors[0][v];
+                    lv.color = glm::vec4(c.r, c.g, c.b, c.a);
+                }
+            }
+
+            mesh.vertices.push_back(VertexTraits<T>::fromLoaderVertex(lv));
+        }
+
+        for(unsigned int f = 0; f < aim->mNumFaces; f++) {
+            const aiFace &face = aim->mFaces[f];
+            // Only triangles (points/lines are skipped)
+            if(face.mNumIndices == 3) {
+                // A mirroring transform flips the winding, so flip it back
+                mesh.indices.push_back(face.mIndices[0]);
+                mesh.indices.push_back(face.mIndices[isMirrored ? 2 : 1]);
+                mesh.indices.push_back(face.mIndices[isMirrored ? 1 : 2]);
+            }
+        }
+
+        return mesh;
+    };
+
+    // Imports a whole scene (any format assimp supports) and converts 
+    // every triangle mesh into a HostMesh<T> (in parallel), placed by the node hierarchy.
+    template<typename T>
+    HostModel<T> loadModel(const string &filename, ModelLoadOptions options = {}) {
+        Assimp::Importer importer;
+
+        // Drop points and lines entirely
+        importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
+
+        const aiScene *scene = importer.ReadFile(filename, getModelPostProcessFlags<T>(options));
+        if(!scene || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || !scene->HasMeshes()) {
+            print_and_throw_error("loadModel", "Cannot load " + filename + ": " + importer.GetErrorString());
+        }
+
+        vector<ModelInstance> allInstances {};
+        if(scene->mRootNode) {
+            collectModelInstances(scene->mRootNode, glm::mat4(1.0f), allInstances);
+        }
+        else {
+            for(unsigned int i = 0; i < scene->mNumMeshes; i++) {
+                allInstances.push_back({ i, glm::mat4(1.0f) });
+            }
+        }
+
+        HostModel<T> model {};
+        if(!options.bakeTransforms) {
+            model.meshes.resize(scene->mNumMeshes);
+            model.materialIndices.resize(scene->mNumMeshes);
+            model.instances = allInstances;
+
+            // Each mesh is independent, so convert them all at once
+            runInParallel(scene->mNumMeshes, [&](size_t i) {
+                model.meshes[i] = convertAssimpMesh<T>(scene->mMeshes[i]);
+                model.materialIndices[i] = scene->mMeshes[i]->mMaterialIndex;
+            }, options.threadCnt);
+        }
+        else {
+            model.meshes.resize(allInstances.size());
+            model.materialIndices.resize(allInstances.size());
+            model.instances.resize(allInstances.size());
+
+            runInParallel(allInstances.size(), [&](size_t i) {
+                const aiMesh *aim = scene->mMeshes[allInstances[i].meshIndex];
+                model.meshes[i] = convertAssimpMesh<T>(aim, &(allInstances[i].transform));
+                model.materialIndices[i] = aim->mMaterialIndex;
+                model.instances[i].meshIndex = (unsigned int)i;
+            }, options.threadCnt);
+        }
+
+        return model;
+    };
+
+    // Creates device-local buffers for every mesh and submits ALL copies in ONE batch.
+    // (model must stay alive until the copies are submitted)
+    template<typename T>
+    BufferCopyReceipt submitModelUploads(   VulkanInitData &vkInitData,
+                                            TransferManager &transferManager,
+                                            HostModel<T> &model,
+                                            vector<VulkanMesh> &allMeshes) {
+        vector<PendingBufferCopy> pendingCopies {};
+        for(auto &hostMesh : model.meshes) {
+            narrowHostMeshIndices(hostMesh);
+            VulkanMesh mesh = createVulkanMesh(vkInitData, hostMesh, true);
+            addPendingBufferCopies(mesh, hostMesh, pendingCopies);
+            allMeshes.push_back(mesh);
+        }
+        return transferManager.submitCopies(pendingCopies);
+    };
+
+    // Same, but packs every mesh into a MeshArena (far fewer buffers/allocations)
+    template<typename T>
+    BufferCopyReceipt submitModelUploads(   TransferManager &transferManager,
+                                            MeshArena<T> &arena,
+                                            HostModel<T> &model,
+                                            vector<VulkanMesh> &allMeshes) {
+        vector<PendingBufferCopy> pendingCopies {};
+        for(auto &hostMesh : model.meshes) {
+            allMeshes.push_back(arena.addMesh(hostMesh, pendingCopies));
+        }
+        return transferManager.submitCopies(pendingCopies);
+    };
+}
@@ -0,0 +1,395 @@
+#pragma once
+#include "ProFile.hpp"
+#include "ProMesh.hpp"
+#include <unordered_map>
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Position/uv/normal indices of one face corner.
+    // Missing uv/normal = -1.
+    struct ObjCorner {
+        int64_t v = -1;
+        int64_t vt = -1;
+        int64_t vn = -1;
+
+        bool operator==(const ObjCorner &other) const = default;
+    };
+
+    struct ObjCornerHash {
+        size_t operator()(const ObjCorner &c) const noexcept {
+            // Mix the three indices (64-bit multiplicative hashing)
+            uint64_t h = (uint64_t)c.v * 0x9E3779B97F4A7C15ull;
+            h ^= ((uint64_t)c.vt + 0x7F4A7C15ull) * 0xC2B2AE3D27D4EB4Full;
+            h ^= ((uint64_t)c.vn + 0x165667B1ull) * 0x165667B19E3779F9ull;
+            return (size_t)(h ^ (h >> 32));
+        };
+    };
+
+    // Everything parsed from one chunk of the file
+    struct ObjChunkData {
+        vector<glm::vec3> positions {};
+        vector<glm::vec3> colors {};        // One per position (white if not given)
+        vector<glm::vec3> normals {};
+        vector<glm::vec2> uvs {};
+        vector<ObjCorner> corners {};       // 3 per triangle (polygons are fan-triangulated)
+        vector<uint8_t> relativeMasks {};   // Per corner: bit 0/1/2 = v/vt/vn is chunk-relative
+        bool hasColors = false;
+    };
+
+    struct ObjLoadOptions {
+        unsigned int threadCnt = 0;         // 0 = all threads of JobSystem::getDefault()
+        size_t minChunkBytes = 256 * 1024;  // Don't split files into chunks smaller than this
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // HELPER FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    inline bool isObjSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    };
+
+    inline const char* skipObjSpaces(const char *p, const char *end) {
+        while(p < end && isObjSpace(*p)) p++;
+        return p;
+    };
+
+    inline const char* skipObjLine(const char *p, const char *end) {
+        while(p < end && *p != '\n') p++;
+        return (p < end) ? p + 1 : end;
+    };
+
+    // Hand-written float parser (no locale, no allocation, no strtod).
+    // Handles sign, fraction, and exponent; returns false if no digits were found.
+    inline bool parseObjFloat(const char *&p, const char *end, float &out) {
+        static const double POW10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+            1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+        };
+
+        p = skipObjSpaces(p, end);
+        const char *start = p;
+
+        bool negative = false;
+        if(p < end && (*p == '-' || *p == '+')) {
+            negative = (*p == '-');
+            p++;
+        }
+
+        // Integer and fraction digits go into one 64-bit mantissa
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        int digitCnt = 0;
+        bool anyDigits = false;
+        // (leading zeros don't count toward the 18 digits, so 0.000...0123 keeps its precision)
+        while(p < end && *p >= '0' && *p <= '9') {
+            anyDigits = true;
+            if(digitCnt < 18) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digitCnt += (mantissa != 0) ? 1 : 0;
+            }
+            else {
+                exponent++;     // Too many digits to keep; just scale
+            }
+            p++;
+        }
+
+        if(p < end && *p == '.') {
+            p++;
+            while(p < end && *p >= '0' && *p <= '9') {
+                if(digitCnt < 18) {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    digitCnt += (mantissa != 0) ? 1 : 0;
+                    exponent--;
+                }
+                anyDigits = true;
+                p++;
+            }
+        }
+
+        if(!anyDigits) {
+            p = start;
+            return false;
+        }
+
+        if(p < end && (*p == 'e' || *p == 'E')) {
+            const char *expStart = p;
+            p++;
+            bool expNegative = false;
+            if(p < end && (*p == '-' || *p == '+')) {
+                expNegative = (*p == '-');
+                p++;
+            }
+            if(p < end && *p >= '0' && *p <= '9') {
+                int e = 0;
+                while(p < end && *p >= '0' && *p <= '9') {
+                    if(e < 10000) e = e * 10 + (*p - '0');
+                    p++;
+                }
+                exponent += expNegative ? -e : e;
+            }
+            else {
+                p = expStart;   // Not actually an exponent
+            }
+        }
+
+        double value = (double)mantissa;
+        while(exponent > 18)  { value *= 1e18; exponent -= 18; }
+        while(exponent < -18) { value /= 1e18; exponent += 18; }
+        value = (exponent >= 0) ? value * POW10[exponent] : value / POW10[-exponent];
+
+        out = (float)(negative ? -value : value);
+        return true;
+    };
+
+    inline bool parseObjInt(const char *&p, const char *end, int64_t &out) {
+        bool negative = false;
+        if(p < end && (*p == '-' || *p == '+')) {
+            negative = (*p == '-');
+            p++;
+        }
+        if(p >= end || *p < '0' || *p > '9') {
+            return false;
+        }
+        int64_t value = 0;
+        while(p < end && *p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            p++;
+        }
+        out = negative ? -value : value;
+        return true;
+    };
+
+    // Converts a raw OBJ index (1-based, or negative = relative to the end)
+    // into a 0-based index. Relative indices can only be resolved
+    // against what this chunk has seen so far, so they are flagged for later.
+    inline int64_t resolveObjIndex(int64_t raw, int64_t localCnt, bool &isRelative) {
+        if(raw > 0) {
+            isRelative = false;
+            return raw - 1;
+        }
+        isRelative = true;
+        return localCnt + raw;  // Chunk's base count is added afterwards
+    };
+
+    inline void parseObjChunk(const char *p, const char *end, ObjChunkData &chunk) {
+        vector<ObjCorner> polygon {};
+        vector<uint8_t> polygonMasks {};
+
+        while(p < end) {
+            p = skipObjSpaces(p, end);
+            if(p >= end) break;
+
+            if(p[0] == 'v') {
+                if(p + 1 < end && isObjSpace(p[1])) {
+                    // Position (and optional color)
+                    p += 2;
+                    glm::vec3 pos {};
+                    parseObjFloat(p, end, pos.x);
+                    parseObjFloat(p, end, pos.y);
+                    parseObjFloat(p, end, pos.z);
+                    chunk.positions.push_back(pos);
+
+                    // "v x y z r g b" (color extension) vs. "v x y z w" (ignored)
+                    glm::vec3 color {1,1,1};
+                    float extra[3] = {};
+                    int extraCnt = 0;
+                    while(extraCnt < 3 && parseObjFloat(p, end, extra[extraCnt])) {
+                        extraCnt++;
+                    }
+                    if(extraCnt == 3) {
+                        color = glm::vec3(extra[0], extra[1], extra[2]);
+                        chunk.hasColors = true;
+                    }
+                    chunk.colors.push_back(color);
+                }
+                else if(p + 2 < end && p[1] == 'n' && isObjSpace(p[2])) {
+                    p += 3;
+                    glm::vec3 normal {};
+                    parseObjFloat(p, end, normal.x);
+                    parseObjFloat(p, end, normal.y);
+                    parseObjFloat(p, end, normal.z);
+                    chunk.normals.push_back(normal);
+                }
+                else if(p + 2 < end && p[1] == 't' && isObjSpace(p[2])) {
+                    p += 3;
+                    glm::vec2 uv {};
+                    parseObjFloat(p, end, uv.x);
+                    parseObjFloat(p, end, uv.y);
+                    chunk.uvs.push_back(uv);
+                }
+            }
+            else if(p[0] == 'f' && p + 1 < end && isObjSpace(p[1])) {
+                p += 2;
+                polygon.clear();
+                polygonMasks.clear();
+
+                // Each corner: v, v/vt, v//vn, or v/vt/vn
+                while(true) {
+                    p = skipObjSpaces(p, end);
+                    int64_t raw = 0;
+                    if(!parseObjInt(p, end, raw)) break;
+
+                    ObjCorner corner {};
+                    uint8_t mask = 0;
+                    bool rel = false;
+
+                    corner.v = resolveObjIndex(raw, (int64_t)chunk.positions.size(), rel);
+                    if(rel) mask |= 1;
+
+                    if(p < end && *p == '/') {
+                        p++;
+                        if(parseObjInt(p, end, raw)) {
+                            corner.vt = resolveObjIndex(raw, (int64_t)chunk.uvs.size(), rel);
+                            if(rel) mask |= 2;
+                        }
+                        if(p < end && *p == '/') {
+                            p++;
+                            if(parseObjInt(p, end, raw)) {
+                                corner.vn = resolveObjIndex(raw, (int64_t)chunk.normals.size(), rel);
+                                if(rel) mask |= 4;
+                            }
+                        }
+                    }
+
+                    polygon.push_back(corner);
+                    polygonMasks.push_back(mask);
+                }
+
+                // Fan triangulation
+                for(size_t i = 2; i < polygon.size(); i++) {
+                    chunk.corners.push_back(polygon[0]);
+                    chunk.corners.push_back(polygon[i - 1]);
+                    chunk.corners.push_back(polygon[i]);
+                    chunk.relativeMasks.push_back(polygonMasks[0]);
+                    chunk.relativeMasks.push_back(polygonMasks[i - 1]);
+                    chunk.relativeMasks.push_back(polygonMasks[i]);
+                }
+            }
+
+            // Everything else (comments, o, g, s, usemtl, mtllib, ...) is ignored
+            p = skipObjLine(p, end);
+        }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Loads an OBJ file into ONE HostMesh<T> (all groups/objects merged).
+    // The file is memory-mapped, split at line boundaries, and parsed in parallel;
+    // identical position/uv/normal corners become a single vertex.
+    // Vertices are built with VertexTraits<T>::fromLoaderVertex().
+    template<typename T>
+    HostMesh<T> loadOBJ(const string &filename, ObjLoadOptions options = {}) {
+        MappedFile file;
+        if(!file.open(filename)) {
+            print_and_throw_error("loadOBJ", "Cannot open file: " + filename);
+        }
+
+        const char *begin = file.data();
+        const char *end = begin + file.size();
+
+        // How many chunks?
+        unsigned int threadCnt = options.threadCnt;
+        if(threadCnt == 0) {
+            threadCnt = JobSystem::getDefault().getThreadCnt();
+        }
+        size_t maxChunks = max<size_t>(1, file.size() / max<size_t>(1, options.minChunkBytes));
+        unsigned int chunkCnt = (unsigned int)min<size_t>(threadCnt, maxChunks);
+
+        // Split at line boundaries
+        vector<const char*> allSplits { begin };
+        for(unsigned int i = 1; i < chunkCnt; i++) {
+            const char *split = begin + (file.size() * i) / chunkCnt;
+            split = max(split, allSplits.back());
+            split = skipObjLine(split, end);
+            allSplits.push_back(split);
+        }
+        allSplits.push_back(end);
+
+        // PASS 1: parse each chunk independently
+        vector<ObjChunkData> allChunks(chunkCnt);
+        runInParallel(chunkCnt, [&](size_t i) {
+            parseObjChunk(allSplits[i], allSplits[i + 1], allChunks[i]);
+        }, chunkCnt);
+
+        // Where does each chunk's data start globally?
+        vector<int64_t> basePositions(chunkCnt, 0), baseUVs(chunkCnt, 0), baseNormals(chunkCnt, 0);
+        vector<size_t> baseCorners(chunkCnt, 0);
+        size_t positionCnt = 0, uvCnt = 0, normalCnt = 0, cornerCnt = 0;
+        bool hasColors = false;
+        for(unsigned int i = 0; i < chunkCnt; i++) {
+            basePositions[i] = (int64_t)positionCnt;
+            baseUVs[i] = (int64_t)uvCnt;
+            baseNormals[i] = (int64_t)normalCnt;
+            baseCorners[i] = cornerCnt;
+            positionCnt += allChunks[i].positions.size();
+            uvCnt += allChunks[i].uvs.size();
+            normalCnt += allChunks[i].normals.size();
+            cornerCnt += allChunks[i].corners.size();
+            hasColors = hasColors || allChunks[i].hasColors;
+        }
+
+        // PASS 2: merge attributes and resolve relative indices (in parallel again)
+        vector<glm::vec3> allPositions(positionCnt);
+        vector<glm::vec3> allColors(hasColors ? positionCnt : 0);
+        vector<glm::vec2> allUVs(uvCnt);
+        vector<glm::vec3> allNormals(normalCnt);
+        vector<ObjCorner> allCorners(cornerCnt);
+        runInParallel(chunkCnt, [&](size_t i) {
+            ObjChunkData &chunk = allChunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), allPositions.begin() + basePositions[i]);
+            if(hasColors) {
+                std::copy(chunk.colors.begin(), chunk.colors.end(), allColors.begin() + basePositions[i]);
+            }
+            std::copy(chunk.uvs.begin(), chunk.uvs.end(), allUVs.begin() + baseUVs[i]);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), allNormals.begin() + baseNormals[i]);
+
+            for(size_t c = 0; c < chunk.corners.size(); c++) {
+                ObjCorner corner = chunk.corners[c];
+                uint8_t mask = chunk.relativeMasks[c];
+                if(mask & 1) corner.v += basePositions[i];
+                if(mask & 2) corner.vt += baseUVs[i];
+                if(mask & 4) corner.vn += baseNormals[i];
+                allCorners[baseCorners[i] + c] = corner;
+            }
+
+            // Free chunk memory early
+            chunk = {};
+        }, chunkCnt);
+
+        // PASS 3: deduplicate corners into vertices
+        HostMesh<T> mesh {};
+        mesh.indices.reserve(cornerCnt);
+
+        unordered_map<ObjCorner, unsigned int, ObjCornerHash> cornerToVertex {};
+        cornerToVertex.reserve(min(cornerCnt, positionCnt * 2));
+
+        for(auto &corner : allCorners) {
+            // Out-of-range uv/normal indices are treated as missing
+            if(corner.v < 0 || corner.v >= (int64_t)positionCnt) {
+                print_and_throw_error("loadOBJ", "Invalid position index in " + filename);
+            }
+            if(corner.vt >= (int64_t)uvCnt || corner.vt < 0) corner.vt = -1;
+            if(corner.vn >= (int64_t)normalCnt || corner.vn < 0) corner.vn = -1;
+
+            auto [iter, isNew] = cornerToVertex.try_emplace(corner, (unsigned int)mesh.vertices.size());
+            if(isNew) {
+                LoaderVertex lv {};
+                lv.pos = allPositions[corner.v];
+                if(hasColors) lv.color = glm::vec4(allColors[corner.v], 1.0f);
+                if(corner.vt >= 0) lv.uv = allUVs[corner.vt];
+                if(corner.vn >= 0) lv.normal = allNormals[corner.vn];
+                mesh.vertices.push_back(VertexTraits<T>::fromLoaderVertex(lv));
+            }
+            mesh.indices.push_back(iter->second);
+        }
+
+        return mesh;
+    };
+}
@@ -38,6 +38,11 @@ namespace pro {
         return vk::Rect2D({0,0}, vkInitData.swapchain().extent);
     };
 
+    // Work groups needed to cover itemCnt items (groupSize = local_size in the shader)
+    inline uint32_t getDispatchGroupCount(uint64_t itemCnt, uint32_t groupSize) {
+        return (uint32_t)((itemCnt + groupSize - 1) / groupSize);
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     // STRUCTS 
     ///////////////////////////////////////////////////////////////////////////
@@ -131,8 +136,19 @@ namespace pro {
         };
     };
 
+    struct VulkanComputePipelineCreateInfo {
+        // Shader (one compute stage)
+        VulkanShaderCreateInfo shaderInfo;
+
+        // Uniform and layout info
+        vector<vk::PushConstantRange> pushConstantRanges {};
+        vector<vk::DescriptorSetLayout> allDescSetLayouts {};
+
+        VulkanComputePipelineCreateInfo(string filename) 
+            : shaderInfo(filename, vk::ShaderStageFlagBits::eCompute) {};
+    };
+
     struct VulkanPipelineData {
-        vk::PipelineCache cache;
         vk::PipelineLayout layout;
         vk::Pipeline pipeline;
         vector<vk::DescriptorSetLayout> allDescSetLayouts {};        
@@ -170,17 +186,12 @@ namespace pro {
         vkInitData.device().destroyShaderModule(shaderModule);
     };
 
-    inline VulkanPipelineData createVulkanPipeline( VulkanInitData &vkInitData, 
-                                                    VulkanPipelineCreateInfo &creationInfo) {
-
-        // Create data struct
-        VulkanPipelineData data;
-
-        // Shaders        
-        vector<vk::ShaderModule> shaderModules {};
+    // One module per shader (destroy them once the pipeline is created)
+    inline vector<vk::PipelineShaderStageCreateInfo> createVulkanShaderStages(  VulkanInitData &vkInitData, 
+                                                                                const vector<VulkanShaderCreateInfo> &shaderInfo,
+                                                                                vector<vk::ShaderModule> &shaderModules) {
         vector<vk::PipelineShaderStageCreateInfo> shaderStages {};
-
-        for(auto shaderData : creationInfo.shaderInfo) {
+        for(auto &shaderData : shaderInfo) {
             auto shaderCode = readBinaryFile(shaderData.filename);
             vk::ShaderModule shaderMod = createVulkanShaderModule(vkInitData, shaderCode);
             shaderModules.push_back(shaderMod);
@@ -189,6 +200,28 @@ namespace pro {
                 {}, shaderData.stage, shaderMod, "main");  
             shaderStages.push_back(shaderStageInfo);
         }
+        return shaderStages;
+    };
+
+    inline vk::PipelineLayout createVulkanPipelineLayout(   VulkanInitData &vkInitData,
+                                                            const vector<vk::DescriptorSetLayout> &allDescSetLayouts,
+                                                            const vector<vk::PushConstantRange> &pushConstantRanges) {
+        vk::PipelineLayoutCreateInfo pipelineLayoutInfo(
+            {}, 
+            allDescSetLayouts,
+            pushConstantRanges);
+        return vkInitData.device().createPipelineLayout(pipelineLayoutInfo);
+    };
+
+    inline VulkanPipelineData createVulkanPipeline( VulkanInitData &vkInitData, 
+                                                    VulkanPipelineCreateInfo &creationInfo) {
+
+        // Create data struct
+        VulkanPipelineData data;
+
+        // Shaders        
+        vector<vk::ShaderModule> shaderModules {};
+        vector<vk::PipelineShaderStageCreateInfo> shaderStages = createVulkanShaderStages(vkInitData, creationInfo.shaderInfo, shaderModules);
 
         // Vertex information
         vk::PipelineVertexInputStateCreateInfo vertexInputInfo(
@@ -204,18 +237,9 @@ namespace pro {
         };
         vk::PipelineDynamicStateCreateInfo dynamicStateInfo({}, dynamicStates);  
 
-        // Set all layout info
-        vk::PipelineLayoutCreateInfo pipelineLayoutInfo(
-            {}, 
-            creationInfo.allDescSetLayouts,
-            creationInfo.pushConstantRanges);
-        data.allDescSetLayouts = creationInfo.allDescSetLayouts;
-
         // Create the layouts
-        data.layout = vkInitData.device().createPipelineLayout(pipelineLayoutInfo);
-
-        // Create the cache
-        data.cache = vkInitData.device().createPipelineCache(vk::PipelineCacheCreateInfo());    
+        data.layout = createVulkanPipelineLayout(vkInitData, creationInfo.allDescSetLayouts, creationInfo.pushConstantRanges);
+        data.allDescSetLayouts = creationInfo.allDescSetLayouts;
 
         // Create the master info
         vk::GraphicsPipelineCreateInfo pinfo {};
@@ -232,7 +256,7 @@ namespace pro {
         pinfo.setLayout(data.layout);
         pinfo.setPNext(&(creationInfo.renderInfo));
         pinfo.setRenderPass(nullptr);        
-        auto ret = vkInitData.device().createGraphicsPipeline(data.cache, pinfo);
+        auto ret = vkInitData.device().createGraphicsPipeline(vkInitData.pipelineCache(), pinfo);
 
         // Did we create the pipeline?
         if (ret.result != vk::Result::eSuccess) {
@@ -251,13 +275,86 @@ namespace pro {
         return data;
     };      
 
+    inline VulkanPipelineData createVulkanComputePipeline(  VulkanInitData &vkInitData, 
+                                                            VulkanComputePipelineCreateInfo &creationInfo) {
+        // Create data struct
+        VulkanPipelineData data;
+
+        // Shader
+        vector<vk::ShaderModule> shaderModules {};
+        vector<vk::PipelineShaderStageCreateInfo> shaderStages = createVulkanShaderStages(vkInitData, { creationInfo.shaderInfo }, shaderModules);
+
+        // Create the layouts
+        data.layout = createVulkanPipelineLayout(vkInitData, creationInfo.allDescSetLayouts, creationInfo.pushConstantRanges);
+        data.allDescSetLayouts = creationInfo.allDescSetLayouts;
+
+        // Create the pipeline
+        vk::ComputePipelineCreateInfo pinfo({}, shaderStages.front(), data.layout);
+        auto ret = vkInitData.device().createComputePipeline(vkInitData.pipelineCache(), pinfo);
+
+        // Cleanup modules
+        for(auto shaderMod : shaderModules) {
+            vkInitData.device().destroyShaderModule(shaderMod);
+        }
+
+        // Did we create the pipeline?
+        if (ret.result != vk::Result::eSuccess) {
+            vkInitData.device().destroyPipelineLayout(data.layout);
+            throw runtime_error("Failed to create compute pipeline!");
+        }
+
+        // Set pipeline
+        data.pipeline = ret.value;
+        
+        // Return data
+        return data;
+    };
+
+    // Binds the compute pipeline (plus any descriptor sets and push constants) and dispatches
+    inline void recordDispatchCompute(  vk::CommandBuffer &commandBuffer,
+                                        VulkanPipelineData &pipelineData,
+                                        uint32_t groupCntX,
+                                        uint32_t groupCntY = 1,
+                                        uint32_t groupCntZ = 1,
+                                        const vector<vk::DescriptorSet> &allDescSets = {},
+                                        const void *pushData = nullptr,
+                                        uint32_t pushSize = 0) {
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipelineData.pipeline);
+        if(!allDescSets.empty()) {
+            commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineData.layout, 0, allDescSets, {});
+        }
+        if(pushData && pushSize > 0) {
+            commandBuffer.pushConstants(pipelineData.layout, vk::ShaderStageFlagBits::eCompute, 0, pushSize, pushData);
+        }
+        commandBuffer.dispatch(groupCntX, groupCntY, groupCntZ);
+    };
+
+    // renderInfo and colorBlendInfo point at the create info's OWN colorFormat/colorBlendAttachment;
+    // call on a copy (at its final address) so they point at the copy's instead of the original's
+    inline void fixCopiedVulkanPipelineCreateInfo(  const VulkanPipelineCreateInfo &original,
+                                                    VulkanPipelineCreateInfo &copy) {
+        if(original.renderInfo.pColorAttachmentFormats == &(original.colorFormat)) {
+            copy.renderInfo.pColorAttachmentFormats = &(copy.colorFormat);
+        }
+        if(original.colorBlendInfo.pAttachments == &(original.colorBlendAttachment)) {
+            copy.colorBlendInfo.pAttachments = &(copy.colorBlendAttachment);
+        }
+    };
+
+    // Destroys the pipeline and its layout, but NOT the descriptor set layouts (e.g., shared by several pipelines)
+    inline void cleanupVulkanPipelineOnly(VulkanInitData &vkInitData, VulkanPipelineData &pipelineData) {
+        vkInitData.device().destroyPipelineLayout(pipelineData.layout);
+        vkInitData.device().destroyPipeline(pipelineData.pipeline);
+        pipelineData.layout = nullptr;
+        pipelineData.pipeline = nullptr;
+    };
+
     inline void cleanupVulkanPipeline(VulkanInitData &vkInitData, VulkanPipelineData &pipelineData) {        
         for(int i = 0; i < pipelineData.allDescSetLayouts.size(); i++) {
             vkInitData.device().destroyDescriptorSetLayout(pipelineData.allDescSetLayouts.at(i));
         }
         pipelineData.allDescSetLayouts.clear();
 
-        vkInitData.device().destroyPipelineCache(pipelineData.cache);
         vkInitData.device().destroyPipelineLayout(pipelineData.layout);
         vkInitData.device().destroyPipeline(pipelineData.pipeline);
     };
@@ -0,0 +1,201 @@
+#pragma once
+#include "ProPipeline.hpp"
+#include "ProJobs.hpp"
+#include "ProTime.hpp"
+
+// Asynchronous pipeline compilation:
+//  - submit()/submitCompute() copy the create info and compile it as a pro::JobSystem background job
+//    (so a thread waiting on other jobs, e.g., the render thread, never ends up compiling), returning an id right away
+//  - every job goes through the shared VulkanInitData::pipelineCache() (internally synchronized, so it is safe
+//    from several threads), so permutations reuse each other's work and the next launch starts warm
+//  - addFallback() compiles right away on the calling thread (e.g., a cheap flat-shaded variant)
+//  - get(id, fallbackID) never blocks: the real pipeline once it is ready, the fallback until then
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    // The compiler owns the pipelines (and their layouts) but NOT the descriptor set layouts,
+    // since permutations usually share them.
+    // Background jobs need a worker besides the render thread (JobSystem::getDefault() has one);
+    // with a single-thread JobSystem, pipelines only compile inside wait()/waitAll().
+    class PipelineCompiler {
+    private:
+        struct PipelineJob {
+            unique_ptr<VulkanPipelineCreateInfo> graphicsInfo {};
+            unique_ptr<VulkanComputePipelineCreateInfo> computeInfo {};
+            VulkanPipelineData data {};             // Cleaned up explicitly
+            JobCounter counter {};
+            atomic<bool> isDone = false;            // Set (release) after data/error are written
+            bool hasFailed = false;
+            string error = "";
+            float compileSeconds = 0.0f;
+        };
+
+        VulkanInitData *refInitData;                // Do NOT clean up!!!
+        JobSystem *refJobs;                         // Do NOT clean up!!!
+
+        mutable mutex lock {};
+        vector<unique_ptr<PipelineJob>> allJobs {}; // Cleaned up explicitly
+
+        PipelineJob* getJob(size_t id) const {
+            lock_guard<mutex> guard(lock);
+            return allJobs.at(id).get();
+        };
+
+        static void compile(VulkanInitData &vkInitData, PipelineJob *p) {
+            auto start = getTime();
+            try {
+                p->data = p->graphicsInfo ? createVulkanPipeline(vkInitData, *(p->graphicsInfo))
+                                          : createVulkanComputePipeline(vkInitData, *(p->computeInfo));
+            }
+            catch(exception &e) {
+                p->hasFailed = true;
+                p->error = e.what();
+            }
+            p->compileSeconds = getElapsedSeconds(start, getTime());
+            p->isDone.store(true, memory_order_release);
+        };
+
+        // isSync: compile on this thread (throws if that fails)
+        size_t addJob(unique_ptr<PipelineJob> job, bool isSync) {
+            PipelineJob *p = job.get();
+            if(isSync) {
+                compile(*refInitData, p);
+                if(p->hasFailed) {
+                    print_and_throw_error("PipelineCompiler", "Fallback pipeline failed to compile: " + p->error);
+                }
+            }
+
+            size_t id = 0;
+            {
+                lock_guard<mutex> guard(lock);
+                allJobs.push_back(std::move(job));
+                id = allJobs.size() - 1;
+            }
+
+            if(!isSync) {
+                refJobs->runBackground([this, p]() { compile(*refInitData, p); }, &(p->counter));
+            }
+            return id;
+        };
+
+        static unique_ptr<PipelineJob> makeJob(const VulkanPipelineCreateInfo &createInfo) {
+            auto job = make_unique<PipelineJob>();
+            job->graphicsInfo = make_unique<VulkanPipelineCreateInfo>(createInfo);
+            fixCopiedVulkanPipelineCreateInfo(createInfo, *(job->graphicsInfo));
+            return job;
+        };
+
+        static unique_ptr<PipelineJob> makeJob(const VulkanComputePipelineCreateInfo &createInfo) {
+            auto job = make_unique<PipelineJob>();
+            job->computeInfo = make_unique<VulkanComputePipelineCreateInfo>(createInfo);
+            return job;
+        };
+
+    public:
+        PipelineCompiler(VulkanInitData &vkInitData, JobSystem &jobs = JobSystem::getDefault()) {
+            refInitData = &vkInitData;
+            refJobs = &jobs;
+        };
+
+        ~PipelineCompiler() {
+            // Jobs still running write into allJobs
+            waitAll();
+
+            // Command buffers may still reference them
+            refInitData->device().waitIdle();
+            for(auto &job : allJobs) {
+                if(!job->hasFailed) {
+                    cleanupVulkanPipelineOnly(*refInitData, job->data);
+                }
+            }
+            allJobs.clear();
+        };
+
+        // Copy: forbidden (unique ownership)
+        PipelineCompiler(const PipelineCompiler&)            = delete;
+        PipelineCompiler& operator=(const PipelineCompiler&) = delete;
+
+        // Returns right away; the create info is copied, so it may be changed/reused for the next permutation
+        size_t submit(const VulkanPipelineCreateInfo &createInfo) {
+            return addJob(makeJob(createInfo), false);
+        };
+
+        size_t submitCompute(const VulkanComputePipelineCreateInfo &createInfo) {
+            return addJob(makeJob(createInfo), false);
+        };
+
+        // Compiles on the calling thread before returning (throws if that fails), so it is always ready for get()
+        size_t addFallback(const VulkanPipelineCreateInfo &createInfo) {
+            return addJob(makeJob(createInfo), true);
+        };
+
+        size_t addComputeFallback(const VulkanComputePipelineCreateInfo &createInfo) {
+            return addJob(makeJob(createInfo), true);
+        };
+
+        // Finished (successfully or not); never blocks
+        bool isReady(size_t id) const {
+            return getJob(id)->isDone.load(memory_order_acquire);
+        };
+
+        bool hasFailed(size_t id) const {
+            PipelineJob *job = getJob(id);
+            return job->isDone.load(memory_order_acquire) && job->hasFailed;
+        };
+
+        // Blocks until compiled (compiling/running other jobs meanwhile); throws if compilation failed
+        VulkanPipelineData& wait(size_t id) {
+            PipelineJob *job = getJob(id);
+            refJobs->wait(job->counter, true);
+            if(job->hasFailed) {
+                print_and_throw_error("PipelineCompiler", "Pipeline " + to_string(id) + " failed to compile: " + job->error);
+            }
+            return job->data;
+        };
+
+        // The real pipeline if it is ready, otherwise the fallback (see addFallback()); never blocks
+        VulkanPipelineData& get(size_t id, size_t fallbackID) {
+            PipelineJob *job = getJob(id);
+            if(job->isDone.load(memory_order_acquire) && !job->hasFailed) {
+                return job->data;
+            }
+
+            PipelineJob *fallback = getJob(fallbackID);
+            if(!fallback->isDone.load(memory_order_acquire) || fallback->hasFailed) {
+                print_and_throw_error("PipelineCompiler", "Fallback " + to_string(fallbackID) + " is not ready (use addFallback())");
+            }
+            return fallback->data;
+        };
+
+        void waitAll() {
+            size_t jobCnt = 0;
+            {
+                lock_guard<mutex> guard(lock);
+                jobCnt = allJobs.size();
+            }
+            for(size_t i = 0; i < jobCnt; i++) {
+                refJobs->wait(getJob(i)->counter, true);
+            }
+        };
+
+        // Number of submitted jobs that have not finished
+        size_t getPendingCnt() const {
+            lock_guard<mutex> guard(lock);
+            size_t pendingCnt = 0;
+            for(auto &job : allJobs) {
+                pendingCnt += job->isDone.load(memory_order_acquire) ? 0 : 1;
+            }
+            return pendingCnt;
+        };
+
+        // Wall time of one compilation (0 until it is ready)
+        float getCompileSeconds(size_t id) const {
+            PipelineJob *job = getJob(id);
+            return job->isDone.load(memory_order_acquire) ? job->compileSeconds : 0.0f;
+        };
+    };
+}
@@ -0,0 +1,253 @@
+#pragma once
+#include "ProCommand.hpp"
+#include <unordered_map>
+#include <algorithm>
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Rolling stats over the last historySize frames (one sample per frame; repeated scopes are summed)
+    struct GPUScopeStats {
+        string name = "";
+        size_t sampleCnt = 0;
+        float lastMs = 0.0f;
+        float minMs = 0.0f;
+        float avgMs = 0.0f;
+        float p99Ms = 0.0f;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Named GPU timings with timestamp queries (one query pool per frame in flight; see createFrameCommandData()).
+    // Per frame:
+    //  - wait for the frame's fence, begin its command buffer
+    //  - beginFrame(frame): reads back what THIS frame recorded last time (already finished, so no stall),
+    //      then resets its queries
+    //  - beginScope("name") / endScope() (or GPUProfileScope) around any commands
+    class GPUProfiler {
+    private:
+        struct RecordedScope {
+            uint32_t nameIndex = 0;
+            uint32_t beginQuery = 0;
+            uint32_t endQuery = UINT32_MAX;     // UINT32_MAX = never ended
+        };
+
+        struct FrameRecord {
+            vector<RecordedScope> allScopes {};
+            uint32_t queryCnt = 0;
+        };
+
+        struct ScopeHistory {
+            string name = "";
+            vector<float> samples {};           // Ring buffer
+            size_t next = 0;
+            float lastMs = 0.0f;
+        };
+
+        VulkanInitData *refInitData;            // Do NOT clean up!!!
+        float timestampPeriod = 1.0f;           // Nanoseconds per tick
+        uint64_t timestampMask = ~0ull;
+        size_t historySize = 240;
+        bool isValid = false;
+        bool warnedOutOfQueries = false;
+
+        unordered_map<VkQueryPool, FrameRecord> allRecords {};    // Per frame in flight
+        FrameCommandData *currentFrame = nullptr;
+        FrameRecord *currentRecord = nullptr;
+        vector<size_t> openScopes {};
+
+        vector<ScopeHistory> allHistories {};
+        unordered_map<string, uint32_t> nameToIndex {};
+
+        uint32_t getNameIndex(const string &name) {
+            auto it = nameToIndex.find(name);
+            if(it != nameToIndex.end()) {
+                return it->second;
+            }
+            uint32_t index = (uint32_t)allHistories.size();
+            ScopeHistory history {};
+            history.name = name;
+            history.samples.reserve(historySize);
+            allHistories.push_back(history);
+            nameToIndex[name] = index;
+            return index;
+        };
+
+        void addSample(uint32_t nameIndex, float ms) {
+            ScopeHistory &history = allHistories[nameIndex];
+            if(history.samples.size() < historySize) {
+                history.samples.push_back(ms);
+            }
+            else {
+                history.samples[history.next] = ms;
+            }
+            history.next = (history.next + 1) % historySize;
+            history.lastMs = ms;
+        };
+
+        // Everything was submitted before the fence we waited on, so this does not wait
+        void resolve(vk::QueryPool pool, FrameRecord &record) {
+            if(record.queryCnt == 0) {
+                return;
+            }
+
+            // (value, availability) pairs
+            vector<uint64_t> results(record.queryCnt * 2, 0);
+            vk::Result res = refInitData->device().getQueryPoolResults(
+                                pool, 0, record.queryCnt,
+                                results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+                                vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+            if(res != vk::Result::eSuccess && res != vk::Result::eNotReady) {
+                print_warning("GPUProfiler", "Cannot read timestamps: " + vk::to_string(res));
+                return;
+            }
+
+            // Sum repeated scopes within the frame
+            vector<float> frameMs(allHistories.size(), 0.0f);
+            vector<bool> isUsed(allHistories.size(), false);
+            for(auto &scope : record.allScopes) {
+                if(scope.endQuery == UINT32_MAX
+                    || results[scope.beginQuery*2 + 1] == 0 || results[scope.endQuery*2 + 1] == 0) {
+                    continue;
+                }
+                uint64_t ticks = (results[scope.endQuery*2] - results[scope.beginQuery*2]) & timestampMask;
+                frameMs[scope.nameIndex] += (float)((double)ticks * timestampPeriod / 1.0e6);
+                isUsed[scope.nameIndex] = true;
+            }
+            for(uint32_t i = 0; i < frameMs.size(); i++) {
+                if(isUsed[i]) {
+                    addSample(i, frameMs[i]);
+                }
+            }
+        };
+
+    public:
+        GPUProfiler(VulkanInitData &vkInitData, size_t historySize = 240) {
+            refInitData = &vkInitData;
+            this->historySize = max<size_t>(1, historySize);
+
+            vk::PhysicalDeviceProperties props = refInitData->physicalDevice().getProperties();
+            timestampPeriod = (props.limits.timestampPeriod > 0.0f) ? props.limits.timestampPeriod : 1.0f;
+
+            auto allFamilies = refInitData->physicalDevice().getQueueFamilyProperties();
+            uint32_t validBits = allFamilies.at(refInitData->graphicsQueue().index).timestampValidBits;
+            timestampMask = (validBits >= 64) ? ~0ull : ((1ull << validBits) - 1);
+            isValid = (validBits > 0);
+            if(!isValid) {
+                print_warning("GPUProfiler", "Graphics queue does not support timestamps; profiling is off.");
+            }
+        };
+
+        // Copy: forbidden (unique ownership)
+        GPUProfiler(const GPUProfiler&)            = delete;
+        GPUProfiler& operator=(const GPUProfiler&) = delete;
+
+        bool isSupported() const noexcept { return isValid; };
+
+        // Call right after frame.commandBuffer.begin() (frame.inFlight must have signaled)
+        void beginFrame(FrameCommandData &frame) {
+            currentFrame = nullptr;
+            currentRecord = nullptr;
+            openScopes.clear();
+            if(!isValid || !frame.timestampPool) {
+                return;
+            }
+
+            FrameRecord &record = allRecords[static_cast<VkQueryPool>(frame.timestampPool)];
+            resolve(frame.timestampPool, record);
+            record = {};
+
+            frame.commandBuffer.resetQueryPool(frame.timestampPool, 0, frame.timestampQueryCnt);
+            currentFrame = &frame;
+            currentRecord = &record;
+        };
+
+        void beginScope(const string &name) {
+            if(!currentRecord) {
+                return;
+            }
+            if(currentRecord->queryCnt + 2 > currentFrame->timestampQueryCnt) {
+                if(!warnedOutOfQueries) {
+                    print_warning("GPUProfiler", "Out of timestamp queries (increase timestampQueryCnt); skipping scopes.");
+                    warnedOutOfQueries = true;
+                }
+                openScopes.push_back(SIZE_MAX);
+                return;
+            }
+
+            RecordedScope scope {};
+            scope.nameIndex = getNameIndex(name);
+            scope.beginQuery = currentRecord->queryCnt++;
+            currentRecord->queryCnt++;          // Reserve the end query too
+            currentFrame->commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe,
+                                                        currentFrame->timestampPool, scope.beginQuery);
+            openScopes.push_back(currentRecord->allScopes.size());
+            currentRecord->allScopes.push_back(scope);
+        };
+
+        void endScope() {
+            if(!currentRecord || openScopes.empty()) {
+                return;
+            }
+            size_t index = openScopes.back();
+            openScopes.pop_back();
+            if(index == SIZE_MAX) {
+                return;
+            }
+
+            RecordedScope &scope = currentRecord->allScopes[index];
+            scope.endQuery = scope.beginQuery + 1;
+            currentFrame->commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe,
+                                                        currentFrame->timestampPool, scope.endQuery);
+        };
+
+        vector<GPUScopeStats> getStats() const {
+            vector<GPUScopeStats> allStats {};
+            for(auto &history : allHistories) {
+                if(history.samples.empty()) {
+                    continue;
+                }
+                vector<float> sorted = history.samples;
+                sort(sorted.begin(), sorted.end());
+
+                GPUScopeStats stats {};
+                stats.name = history.name;
+                stats.sampleCnt = sorted.size();
+                stats.lastMs = history.lastMs;
+                stats.minMs = sorted.front();
+                stats.p99Ms = sorted[min(sorted.size() - 1, sorted.size() * 99 / 100)];
+                for(float ms : sorted) {
+                    stats.avgMs += ms;
+                }
+                stats.avgMs /= (float)sorted.size();
+                allStats.push_back(stats);
+            }
+            return allStats;
+        };
+
+        void printStats() const {
+            for(auto &stats : getStats()) {
+                cout << "GPU " << stats.name << ": avg " << stats.avgMs << " ms, min " << stats.minMs
+                     << " ms, p99 " << stats.p99Ms << " ms (" << stats.sampleCnt << " frames)" << endl;
+            }
+        };
+    };
+
+    // beginScope() now, endScope() when it goes out of scope
+    struct GPUProfileScope {
+        GPUProfiler &profiler;
+
+        GPUProfileScope(GPUProfiler &profiler, const string &name) : profiler(profiler) {
+            profiler.beginScope(name);
+        };
+
+        ~GPUProfileScope() {
+            profiler.endScope();
+        };
+    };
+}
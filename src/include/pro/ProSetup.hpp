@@ -46,22 +46,43 @@ namespace pro {
         vk::PhysicalDeviceVulkan13Features reqFeatures13 {};   
         vector<string> reqExtensions {};
 
+        // Enabled only if the selected device has them (check enabledFeatures() / isExtensionEnabled())
+        vk::PhysicalDeviceFeatures optFeaturesBase {};
+        vector<string> optExtensions {};
+
         // Window size
         GetCurrentWindowSizeFunc getCurrentWindowSizeFunc = nullptr;
 
         // Surface
         CreateSurfaceFunc createSurfaceFunc = nullptr;
 
+        // Headless (no surface, no swapchain, no present queue; render into VulkanImages instead).
+        // headlessExtent is used unless getCurrentWindowSizeFunc is set.
+        bool headless = false;
+        vk::Extent2D headlessExtent { 800, 600 };
+
         // Swapchain
         VkSurfaceFormatKHR desiredSwapchainFormat {};
 
         // Queues
         bool requireComputeQueue = true;
         bool requireTransferQueue = true;
+
+        // Pipeline cache (shared by all pipelines; empty filename = in-memory only)
+        // The vendor and device IDs are appended to the filename, so
+        // multiple GPUs on the same machine do not overwrite each other.
+        string pipelineCacheFilename = "pipeline_cache.bin";
             
         VulkanInitCreateInfo() {
             // Set default requested features
             reqFeaturesBase.samplerAnisotropy = true;
+
+            optFeaturesBase.textureCompressionBC = true;
+
+            // Real heap budgets for VMA (otherwise it estimates them)
+            optExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+            reqFeatures12.timelineSemaphore = true;
             
             reqFeatures13.dynamicRendering = true;
             reqFeatures13.synchronization2 = true;
@@ -117,6 +138,91 @@ namespace pro {
                 << VK_VERSION_PATCH(apiVer) << endl;
     }
 
+    inline string getPipelineCachePath(const string &baseFilename, 
+                                        const vk::PhysicalDeviceProperties &props) {
+        // Insert "vendor_device" before the extension:
+        // pipeline_cache.bin --> pipeline_cache.10de_2684.bin
+        filesystem::path path(baseFilename);
+        char deviceKey[32];
+        snprintf(deviceKey, sizeof(deviceKey), ".%04x_%04x", props.vendorID, props.deviceID);
+        
+        filesystem::path keyedPath = path.parent_path() / 
+                                        (path.stem().string() + deviceKey + path.extension().string());
+        return keyedPath.string();
+    };
+
+    inline bool isPipelineCacheDataValid(   const vector<char> &cacheData, 
+                                            const vk::PhysicalDeviceProperties &props) {
+        // Must at least hold the header
+        if(cacheData.size() < sizeof(VkPipelineCacheHeaderVersionOne)) {
+            return false;
+        }
+
+        VkPipelineCacheHeaderVersionOne header {};
+        memcpy(&header, cacheData.data(), sizeof(header));
+
+        // Header must be the version we know about, 
+        // AND it must have been created by this exact driver/device
+        return (header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne)
+                && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+                && header.vendorID == props.vendorID
+                && header.deviceID == props.deviceID
+                && memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0);
+    };
+
+    inline vector<char> loadPipelineCacheData(  const string &filename, 
+                                                const vk::PhysicalDeviceProperties &props) {
+        vector<char> cacheData {};
+
+        ifstream file(filename, ios::ate | ios::binary);
+        if(!file.is_open()) {
+            // No cache yet (first launch)
+            return cacheData;
+        }
+
+        size_t fileSize = (size_t) file.tellg();
+        cacheData.resize(fileSize);
+        file.seekg(0);
+        file.read(cacheData.data(), fileSize);
+        file.close();
+
+        if(!isPipelineCacheDataValid(cacheData, props)) {
+            print_warning("loadPipelineCacheData", 
+                            "Ignoring stale or incompatible pipeline cache: " + filename);
+            cacheData.clear();
+        }
+
+        return cacheData;
+    };
+
+    inline bool savePipelineCacheData(const string &filename, const vector<uint8_t> &cacheData) {
+        // Write to temporary file first, then rename over the old one,
+        // so a crash mid-write never leaves a corrupt cache behind.
+        string tempFilename = filename + ".tmp";
+        {
+            ofstream file(tempFilename, ios::binary | ios::trunc);
+            if(!file.is_open()) {
+                print_warning("savePipelineCacheData", "Cannot open file: " + tempFilename);
+                return false;
+            }
+            file.write(reinterpret_cast<const char*>(cacheData.data()), cacheData.size());
+            if(!file) {
+                print_warning("savePipelineCacheData", "Failed writing file: " + tempFilename);
+                return false;
+            }
+        }
+
+        error_code err;
+        filesystem::rename(tempFilename, filename, err);
+        if(err) {
+            print_warning("savePipelineCacheData", "Cannot replace " + filename + ": " + err.message());
+            filesystem::remove(tempFilename, err);
+            return false;
+        }
+
+        return true;
+    };
+
     inline bool getVulkanQueue( vkb::Device vkbDevice, 
                                 vkb::QueueType queueType, 
                                 VulkanQueue &queueData) {
@@ -164,12 +270,14 @@ namespace pro {
     public:
         VulkanInitData(VulkanInitCreateInfo &createInfo) {
             // Quick sanity check...is the surface creation function defined?
-            if(!createInfo.createSurfaceFunc) {
+            headless_ = createInfo.headless;
+            if(!headless_ && !createInfo.createSurfaceFunc) {
                 print_and_throw_error("VulkanInitData", "createSurfaceFunc cannot be null!");                
             }
 
             // Copy our "get window/buffer size" function
             this->getCurrentWindowSizeFunc = createInfo.getCurrentWindowSizeFunc;
+            this->headlessExtent_ = createInfo.headlessExtent;
            
             // Instance
             vkb::InstanceBuilder builder;        
@@ -177,6 +285,7 @@ namespace pro {
                                 .set_engine_name(createInfo.engineName.c_str())
                                 .request_validation_layers()
                                 .use_default_debug_messenger()
+                                .set_headless(headless_)
                                 .require_api_version(
                                     createInfo.requestedAppVulkanVersionMajor,
                                     createInfo.requestedAppVulkanVersionMinor,
@@ -192,16 +301,20 @@ namespace pro {
 
             // Surface
             VkSurfaceKHR surface = nullptr;
-            VkResult surfErr = createInfo.createSurfaceFunc(vkbInstance.instance, surface);
-            if(surfErr != VK_SUCCESS) {                 
-                vkb::destroy_instance(bootInstance_);   
-                print_and_throw_error("VulkanInitData", surfErr + ""); 
+            if(!headless_) {
+                VkResult surfErr = createInfo.createSurfaceFunc(vkbInstance.instance, surface);
+                if(surfErr != VK_SUCCESS) {                 
+                    vkb::destroy_instance(bootInstance_);   
+                    print_and_throw_error("VulkanInitData", string_VkResult(surfErr)); 
+                }
             }
             surface_ = vk::SurfaceKHR { surface };
 
             // Physical device           
             vkb::PhysicalDeviceSelector selector { vkbInstance };  
-            selector.set_surface(surface);      
+            if(!headless_) {
+                selector.set_surface(surface);      
+            }
             selector.set_minimum_version(
                 createInfo.requestedAppVulkanVersionMajor,
                 createInfo.requestedAppVulkanVersionMinor);                 
@@ -217,7 +330,7 @@ namespace pro {
             auto physRet = selector.select();
 
             if(!physRet) {  
-                instance_.destroySurfaceKHR(surface_); 
+                destroySurface(); 
                 vkb::destroy_instance(bootInstance_);   
                 print_and_throw_error("VulkanInitData", physRet.error().message());   
             }
@@ -225,11 +338,19 @@ namespace pro {
             vkb::PhysicalDevice vkbPhysicalDevice = physRet.value();
             physicalDevice_ = vk::PhysicalDevice { vkbPhysicalDevice.physical_device };
 
+            vkbPhysicalDevice.enable_features_if_present(createInfo.optFeaturesBase);
+            enabledFeatures_ = vk::PhysicalDeviceFeatures { vkbPhysicalDevice.features };
+
+            for(auto &optExt : createInfo.optExtensions) {
+                vkbPhysicalDevice.enable_extension_if_present(optExt.c_str());
+            }
+            enabledExtensions_ = vkbPhysicalDevice.get_extensions();
+
             // Logical device        
             vkb::DeviceBuilder deviceBuilder { vkbPhysicalDevice };
             auto devRet = deviceBuilder.build();
             if(!devRet) {
-                instance_.destroySurfaceKHR(surface_); 
+                destroySurface(); 
                 vkb::destroy_instance(bootInstance_);    
                 print_and_throw_error("VulkanInitData", devRet.error().message());
             }
@@ -256,7 +377,8 @@ namespace pro {
 
             // Get queues
             bool graphQueueSuccess = getVulkanQueue(vkbDevice, vkb::QueueType::graphics, graphicsQueue_);
-            bool presentQueueSuccess = getVulkanQueue(vkbDevice, vkb::QueueType::present, presentQueue_);
+            // (Nothing to present to if headless)
+            bool presentQueueSuccess = headless_ || getVulkanQueue(vkbDevice, vkb::QueueType::present, presentQueue_);
             bool computeQueueSuccess = getVulkanQueue(vkbDevice, vkb::QueueType::compute, computeQueue_);
             bool transferQueueSuccess = getVulkanQueue(vkbDevice, vkb::QueueType::transfer, transferQueue_);
 
@@ -266,7 +388,7 @@ namespace pro {
                 (createInfo.requireTransferQueue && !transferQueueSuccess)) {
             
                 device_.destroy();
-                instance_.destroySurfaceKHR(surface_); 
+                destroySurface(); 
                 vkb::destroy_instance(bootInstance_);  
                 print_and_throw_error("VulkanInitData", "Could not retrieve requested queues!"); 
             }
@@ -275,7 +397,7 @@ namespace pro {
             swapchain_create_format_ = createInfo.desiredSwapchainFormat;
             if(!createVulkanSwapchain()) {
                 device_.destroy();
-                instance_.destroySurfaceKHR(surface_); 
+                destroySurface(); 
                 vkb::destroy_instance(bootInstance_);     
                 print_and_throw_error("VulkanInitData", "Unable to create swapchain!");     
             }   
@@ -286,23 +408,46 @@ namespace pro {
             allocatorInfo.instance = vkbInstance.instance;
             allocatorInfo.physicalDevice = vkbPhysicalDevice.physical_device;
             allocatorInfo.device = vkbDevice.device;
+            // Same version as the instance (VMA assumes 1.0 otherwise, e.g., for the budget queries)
+            allocatorInfo.vulkanApiVersion = VK_MAKE_API_VERSION(   0,
+                                                                    createInfo.requestedAppVulkanVersionMajor,
+                                                                    createInfo.requestedAppVulkanVersionMinor,
+                                                                    0);
+            if(isExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+                allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+            }
 
             auto vmaResult = vmaCreateAllocator(&allocatorInfo, &(allocator_));
             if(vmaResult != VK_SUCCESS) {    
                 cleanupVulkanSwapchain();            
                 device_.destroy();
-                instance_.destroySurfaceKHR(surface_); 
+                destroySurface(); 
                 vkb::destroy_instance(bootInstance_);  
                 print_and_throw_error("VulkanInitData", string_VkResult(vmaResult));
-            }            
+            }
+
+            // Shared pipeline cache (loaded from disk if we have a valid one)
+            vk::PhysicalDeviceProperties props = physicalDevice_.getProperties();
+            vector<char> cacheData {};
+            if(!createInfo.pipelineCacheFilename.empty()) {
+                pipelineCachePath_ = getPipelineCachePath(createInfo.pipelineCacheFilename, props);
+                cacheData = loadPipelineCacheData(pipelineCachePath_, props);
+            }
+            
+            vk::PipelineCacheCreateInfo cacheInfo {};
+            cacheInfo.initialDataSize = cacheData.size();
+            cacheInfo.pInitialData = cacheData.data();
+            pipelineCache_ = device_.createPipelineCache(cacheInfo);
         };
         
         ~VulkanInitData() {
             device_.waitIdle();
+            savePipelineCache();
+            device_.destroyPipelineCache(pipelineCache_);
             vmaDestroyAllocator(allocator_);
             cleanupVulkanSwapchain();
             device_.destroy();
-            instance_.destroySurfaceKHR(surface_); 
+            destroySurface(); 
             vkb::destroy_instance(bootInstance_);             
         };
 
@@ -317,6 +462,10 @@ namespace pro {
         // Getters        
         const vk::Instance& instance() const noexcept { return instance_; };
         const vk::PhysicalDevice& physicalDevice() const noexcept { return physicalDevice_; };
+        const vk::PhysicalDeviceFeatures& enabledFeatures() const noexcept { return enabledFeatures_; };
+        bool isExtensionEnabled(const string &name) const {
+            return find(enabledExtensions_.begin(), enabledExtensions_.end(), name) != enabledExtensions_.end();
+        };
         const vk::Device& device() const noexcept { return device_; };
         const VulkanQueue& graphicsQueue() const noexcept { return graphicsQueue_; };
         const VulkanQueue& presentQueue() const noexcept {  return presentQueue_; };
@@ -324,7 +473,9 @@ namespace pro {
         const VulkanQueue& transferQueue() const noexcept {  return transferQueue_; };
         const VulkanSwapChain& swapchain() const noexcept { return swapchain_; };
         const VmaAllocator allocator() const noexcept { return allocator_; };
+        const vk::PipelineCache& pipelineCache() const noexcept { return pipelineCache_; };
 
+        const bool isHeadless() const noexcept { return headless_; }
         const bool isComputeQueueValid() const noexcept { return computeQueue_.is_valid; }
         const bool isTransferQueueValid() const noexcept { return transferQueue_.is_valid; }
 
@@ -374,6 +525,16 @@ namespace pro {
             os << "**************************" << endl;            
         };
 
+        bool savePipelineCache() {
+            // Persistence disabled?
+            if(pipelineCachePath_.empty() || !pipelineCache_) {
+                return false;
+            }
+
+            vector<uint8_t> cacheData = device_.getPipelineCacheData(pipelineCache_);
+            return savePipelineCacheData(pipelineCachePath_, cacheData);
+        };
+
         bool isComputeDedicated() {
             return (graphicsQueue_.queue != computeQueue_.queue);
         };
@@ -389,6 +550,8 @@ namespace pro {
         vk::SurfaceKHR surface_ {};              // Clean up explicitly
         
         vk::PhysicalDevice physicalDevice_ {};   // No NEED to clean up
+        vk::PhysicalDeviceFeatures enabledFeatures_ {};   // No NEED to clean up
+        vector<string> enabledExtensions_ {};             // No NEED to clean up
 
         vkb::Device bootDevice_ {};              // Do NOT clean up explicitly
         vk::Device device_ {};                   // Cleaned up explicitly
@@ -402,13 +565,38 @@ namespace pro {
         VkSurfaceFormatKHR swapchain_create_format_ {};   // No NEED to clean up
 
         VmaAllocator allocator_ {};              // Cleaned up explicitly 
+
+        bool headless_ = false;                  // No cleanup necessary
+        vk::Extent2D headlessExtent_ {};         // No cleanup necessary
+
+        vk::PipelineCache pipelineCache_ {};     // Cleaned up explicitly
+        string pipelineCachePath_ {};            // No cleanup necessary
         
         GetCurrentWindowSizeFunc getCurrentWindowSizeFunc = nullptr;    // No cleanup necessary
 
+        void destroySurface() {
+            // (Surface extension not even loaded if headless)
+            if(surface_) {
+                instance_.destroySurfaceKHR(surface_);
+                surface_ = vk::SurfaceKHR();
+            }
+        };
+
         bool createVulkanSwapchain() {
             // Get current window/buffer width and height
-            int width, height;
-            getCurrentWindowSizeFunc(width, height);
+            int width = (int)headlessExtent_.width;
+            int height = (int)headlessExtent_.height;
+            if(getCurrentWindowSizeFunc) {
+                getCurrentWindowSizeFunc(width, height);
+            }
+
+            // Headless: no actual swapchain, just the extent/format to render offscreen with
+            if(headless_) {
+                swapchain_.extent = vk::Extent2D { static_cast<uint32_t>(width), 
+                                                   static_cast<uint32_t>(height) };
+                swapchain_.format = vk::Format(swapchain_create_format_.format);
+                return true;
+            }
 
             // Create swapchain
             vkb::SwapchainBuilder swapchainBuilder { bootDevice_ };
@@ -449,7 +637,9 @@ namespace pro {
                 device_.destroySemaphore(swapchain_.swaps[i].renderDone);        
             }       
             swapchain_.swaps.clear();             
-            device_.destroySwapchainKHR(swapchain_.chain);
+            if(swapchain_.chain) {
+                device_.destroySwapchainKHR(swapchain_.chain);
+            }
             swapchain_ = {};
         };     
 
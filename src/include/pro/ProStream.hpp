@@ -0,0 +1,577 @@
+#pragma once
+#include "ProTexture.hpp"
+#include "ProMesh.hpp"
+#include "ProObj.hpp"
+#include "ProJobs.hpp"
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    enum STREAM_RESOURCE_TYPE {
+        STREAM_TEXTURE,
+        STREAM_MESH
+    };
+
+    enum STREAM_STATE {
+        STREAM_QUEUED,          // Waiting for a decode job
+        STREAM_DECODING,
+        STREAM_DECODED,         // Waiting for upload (per-frame byte budget / memory budget)
+        STREAM_UPLOADING,       // On the transfer queue
+        STREAM_RESIDENT,
+        STREAM_EVICTED,         // Memory was given back; requested again when next used
+        STREAM_FAILED
+    };
+
+    using StreamHandle = uint32_t;
+    const StreamHandle INVALID_STREAM_HANDLE = 0;
+
+    // Output of a decode function (runs as a job)
+    struct StreamPayload {
+        // STREAM_TEXTURE: every mip level packed back to back (see packHostMipChain())
+        vk::Format format = vk::Format::eR8G8B8A8Srgb;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 1;
+        vector<unsigned char> texelData {};
+        vector<vk::BufferImageCopy> regions {};
+
+        // STREAM_MESH
+        vector<unsigned char> vertexData {};
+        vector<unsigned char> indexData {};
+        vk::IndexType indexType = vk::IndexType::eUint32;
+        unsigned int indexCnt = 0;
+        MeshBounds bounds {};
+
+        size_t getSize() const { return texelData.size() + vertexData.size() + indexData.size(); };
+    };
+
+    using StreamDecodeFunc = function<StreamPayload(const string&)>;
+
+    struct StreamRequest {
+        STREAM_RESOURCE_TYPE type = STREAM_TEXTURE;
+        string filename = "";
+        float priority = 0.0f;                  // Higher goes first (decode AND upload)
+        StreamDecodeFunc decodeFunc = nullptr;
+    };
+
+    struct StreamingOptions {
+        unsigned int threadCnt = 2;                                 // Max. decode jobs at once (leave cores for the frame)
+        vk::DeviceSize maxUploadBytesPerFrame = 8 * 1024 * 1024;    // 0 = no limit
+        vk::DeviceSize stagingRingSize = 32 * 1024 * 1024;
+        float budgetFraction = 0.8f;            // Share of the device-local heap budget (from VMA) we fill up to
+        vk::DeviceSize maxResidentBytes = 0;    // Our own cap on top of that (0 = none)
+        unsigned int framesInFlight = 2;        // Anything used in the last N frames is never evicted
+    };
+
+    struct StreamingStats {
+        size_t queuedCnt = 0;                   // Queued + decoding
+        size_t decodedCnt = 0;
+        size_t uploadingCnt = 0;
+        size_t residentCnt = 0;
+        size_t evictedCnt = 0;
+        size_t failedCnt = 0;
+        vk::DeviceSize residentBytes = 0;
+        vk::DeviceSize uploadedBytesLastFrame = 0;
+        vk::DeviceSize heapUsage = 0;           // Device-local heaps, whole process (from VMA)
+        vk::DeviceSize heapBudget = 0;
+        uint64_t totalEvictions = 0;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Sum over device-local heaps (real numbers with VK_EXT_memory_budget; VMA estimates otherwise)
+    inline void getDeviceLocalHeapBudget(const VulkanInitData &vkInitData, vk::DeviceSize &usage, vk::DeviceSize &budget) {
+        const VkPhysicalDeviceMemoryProperties *memProps = nullptr;
+        vmaGetMemoryProperties(vkInitData.allocator(), &memProps);
+
+        vector<VmaBudget> allBudgets(memProps->memoryHeapCount);
+        vmaGetHeapBudgets(vkInitData.allocator(), allBudgets.data());
+
+        usage = 0;
+        budget = 0;
+        for(uint32_t i = 0; i < memProps->memoryHeapCount; i++) {
+            if(memProps->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                usage += allBudgets[i].usage;
+                budget += allBudgets[i].budget;
+            }
+        }
+    };
+
+    // RGBA8 texture (+ CPU mips, so the graphics queue has no blits to do)
+    inline StreamPayload decodeStreamTexture(const string &filename, bool sRGB = true, bool generateMipmaps = true) {
+        HostImage image = loadHostImage(filename, 4);
+
+        StreamPayload payload {};
+        payload.format = sRGB ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
+        payload.width = (uint32_t)image.width;
+        payload.height = (uint32_t)image.height;
+
+        vector<HostImage> levels = generateMipmaps ? generateHostMipChain(image, sRGB) : vector<HostImage> { std::move(image) };
+        packHostMipChain(levels, payload.texelData, payload.regions);
+        payload.mipLevels = (uint32_t)levels.size();
+        return payload;
+    };
+
+    template<typename T>
+    StreamPayload decodeStreamMesh(const string &filename) {
+        HostMesh<T> hostMesh = loadOBJ<T>(filename);
+        narrowHostMeshIndices(hostMesh);
+
+        StreamPayload payload {};
+        payload.bounds = computeMeshBounds(hostMesh);
+        const unsigned char *vertexBytes = reinterpret_cast<const unsigned char*>(hostMesh.vertices.data());
+        payload.vertexData.assign(vertexBytes, vertexBytes + hostMesh.vertices.size()*sizeof(T));
+        const unsigned char *indexBytes = reinterpret_cast<const unsigned char*>(getHostMeshIndexData(hostMesh));
+        payload.indexData.assign(indexBytes, indexBytes + getHostMeshIndexBufferSize(hostMesh));
+        payload.indexType = hostMesh.indexType;
+        payload.indexCnt = (unsigned int)hostMesh.indices.size();
+        return payload;
+    };
+
+    inline StreamRequest makeTextureStreamRequest(  const string &filename, float priority,
+                                                    bool sRGB = true, bool generateMipmaps = true) {
+        StreamRequest request {};
+        request.type = STREAM_TEXTURE;
+        request.filename = filename;
+        request.priority = priority;
+        request.decodeFunc = [sRGB, generateMipmaps](const string &f) { return decodeStreamTexture(f, sRGB, generateMipmaps); };
+        return request;
+    };
+
+    template<typename T>
+    StreamRequest makeMeshStreamRequest(const string &filename, float priority) {
+        StreamRequest request {};
+        request.type = STREAM_MESH;
+        request.filename = filename;
+        request.priority = priority;
+        request.decodeFunc = [](const string &f) { return decodeStreamMesh<T>(f); };
+        return request;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Loads textures/meshes in the background:
+    //  request() --> decode as background jobs on a JobSystem (highest priority first; at most options.threadCnt at once)
+    //  update() (once per frame) --> upload within the per-frame byte budget,
+    //      make finished uploads resident, and evict least-recently-used resources
+    //      when over the memory budget.
+    // getTexture()/getMesh() mark a resource as used this frame (and re-request evicted ones).
+    // Everything except the decode jobs runs on the thread that calls update().
+    class StreamingManager {
+    private:
+        struct StreamEntry {
+            StreamRequest request {};
+            STREAM_STATE state = STREAM_QUEUED;
+            uint64_t order = 0;                 // Request order (ties in priority)
+            uint64_t queueVersion = 0;          // Stale decode queue items are skipped
+            bool releaseRequested = false;
+
+            StreamPayload payload {};           // Only while STREAM_DECODED/STREAM_UPLOADING
+            VulkanImage texture {};
+            VulkanMesh mesh {};
+            vk::DeviceSize residentBytes = 0;
+            uint64_t lastUsedFrame = 0;
+        };
+
+        struct DecodeQueueItem {
+            float priority = 0.0f;
+            uint64_t order = 0;
+            StreamHandle handle = INVALID_STREAM_HANDLE;
+            uint64_t version = 0;
+
+            bool operator<(const DecodeQueueItem &other) const {
+                if(priority != other.priority) {
+                    return priority < other.priority;
+                }
+                return order > other.order;
+            };
+        };
+
+        struct UploadBatch {
+            BufferCopyReceipt receipt {};
+            vector<StreamHandle> allHandles {};
+        };
+
+        VulkanInitData *refInitData;                    // Do NOT clean up!!!
+        JobSystem *refJobs;                             // Do NOT clean up!!!
+        unique_ptr<TransferManager> transferManager {}; // Released explicitly (after the device is idle)
+        StreamingOptions options {};
+
+        // Guards entries, decodeQueue, runningCnt and stopping (decode jobs only touch QUEUED/DECODING entries)
+        mutex entriesMutex {};
+        bool stopping = false;
+        unsigned int runningCnt = 0;                    // Decode jobs started and not yet returned
+        JobCounter decodeCounter {};
+
+        unordered_map<StreamHandle, StreamEntry> entries {};
+        priority_queue<DecodeQueueItem> decodeQueue {};
+        StreamHandle nextHandle = 1;
+        uint64_t nextOrder = 0;
+
+        deque<UploadBatch> allInFlightBatches {};
+        uint64_t frameIndex = 0;
+        vk::DeviceSize residentBytes = 0;
+        vk::DeviceSize uploadedBytesLastFrame = 0;
+        uint64_t totalEvictions = 0;
+
+        // Caller holds entriesMutex
+        void enqueueDecode(StreamHandle handle, StreamEntry &entry) {
+            entry.state = STREAM_QUEUED;
+            entry.queueVersion++;
+            decodeQueue.push({ entry.request.priority, entry.order, handle, entry.queueVersion });
+
+            if(!stopping && runningCnt < max(1u, options.threadCnt)) {
+                runningCnt++;
+                refJobs->runBackground([this]() { decodeJob(); }, &decodeCounter);
+            }
+        };
+
+        // Decodes until the queue is empty (so the queue, not the job order, decides what goes first)
+        void decodeJob() {
+            while(true) {
+                StreamHandle handle = INVALID_STREAM_HANDLE;
+                StreamRequest request {};
+                {
+                    lock_guard<mutex> lock(entriesMutex);
+                    if(stopping || decodeQueue.empty()) {
+                        // Under the lock, so enqueueDecode() starts a new job if needed
+                        runningCnt--;
+                        return;
+                    }
+
+                    DecodeQueueItem item = decodeQueue.top();
+                    decodeQueue.pop();
+                    auto it = entries.find(item.handle);
+                    if(it == entries.end() || it->second.state != STREAM_QUEUED || it->second.queueVersion != item.version) {
+                        continue;
+                    }
+                    it->second.state = STREAM_DECODING;
+                    handle = item.handle;
+                    request = it->second.request;
+                }
+
+                // Decode WITHOUT the lock
+                StreamPayload payload {};
+                string errorMsg = "";
+                try {
+                    payload = request.decodeFunc(request.filename);
+                }
+                catch(const exception &e) {
+                    errorMsg = e.what();
+                }
+
+                {
+                    lock_guard<mutex> lock(entriesMutex);
+                    StreamEntry &entry = entries.at(handle);
+                    if(errorMsg.empty()) {
+                        entry.payload = std::move(payload);
+                        entry.state = STREAM_DECODED;
+                    }
+                    else {
+                        entry.state = STREAM_FAILED;
+                    }
+                }
+                if(!errorMsg.empty()) {
+                    print_warning("StreamingManager", "Cannot decode " + request.filename + ": " + errorMsg);
+                }
+            }
+        };
+
+        void destroyResources(StreamEntry &entry) {
+            if(entry.request.type == STREAM_TEXTURE) {
+                cleanupVulkanImage(*refInitData, entry.texture);
+            }
+            else {
+                cleanupVulkanMesh(*refInitData, entry.mesh);
+            }
+            residentBytes -= entry.residentBytes;
+            entry.residentBytes = 0;
+        };
+
+        // Not used by any frame that may still be on the GPU
+        bool isSafeToDestroy(const StreamEntry &entry) const {
+            return entry.lastUsedFrame + options.framesInFlight < frameIndex;
+        };
+
+        // Evicts least-recently-used resident entries until size more bytes fit (caller holds entriesMutex).
+        // Returns false if that is not possible.
+        bool makeRoom(vk::DeviceSize size, vk::DeviceSize &heapUsage, vk::DeviceSize heapBudget) {
+            vk::DeviceSize allowed = (vk::DeviceSize)(heapBudget * options.budgetFraction);
+            auto fits = [&]() {
+                bool fitsHeap = (heapUsage + size <= allowed);
+                bool fitsCap = (options.maxResidentBytes == 0 || residentBytes + size <= options.maxResidentBytes);
+                return fitsHeap && fitsCap;
+            };
+
+            while(!fits()) {
+                StreamEntry *victim = nullptr;
+                for(auto &[handle, entry] : entries) {
+                    if(entry.state == STREAM_RESIDENT && isSafeToDestroy(entry)
+                        && (!victim || entry.lastUsedFrame < victim->lastUsedFrame)) {
+                        victim = &entry;
+                    }
+                }
+                if(!victim) {
+                    return false;
+                }
+
+                vk::DeviceSize freed = victim->residentBytes;
+                destroyResources(*victim);
+                victim->state = STREAM_EVICTED;
+                heapUsage = (heapUsage > freed) ? (heapUsage - freed) : 0;
+                totalEvictions++;
+            }
+            return true;
+        };
+
+        // Creates the resource and its pending copy (caller holds entriesMutex)
+        void prepareUpload( StreamEntry &entry,
+                            vector<PendingBufferCopy> &pendingBufferCopies,
+                            vector<PendingImageCopy> &pendingImageCopies) {
+            StreamPayload &payload = entry.payload;
+            VmaAllocationInfo allocInfo {};
+
+            if(entry.request.type == STREAM_TEXTURE) {
+                entry.texture = createTextureImage(*refInitData, payload.width, payload.height, payload.format, payload.mipLevels);
+                pendingImageCopies.push_back(PendingImageCopy(  entry.texture, payload.texelData.data(),
+                                                                payload.texelData.size(), payload.regions));
+                vmaGetAllocationInfo(refInitData->allocator(), entry.texture.allocation, &allocInfo);
+                entry.residentBytes = allocInfo.size;
+            }
+            else {
+                entry.mesh = createVulkanMesh(*refInitData, payload.vertexData.size(), payload.indexData.size(), true);
+                entry.mesh.indexType = payload.indexType;
+                entry.mesh.indexCnt = payload.indexCnt;
+                entry.mesh.bounds = payload.bounds;
+                pendingBufferCopies.push_back(PendingBufferCopy(entry.mesh.vertices, payload.vertexData.data(),
+                                                                vk::AccessFlagBits::eVertexAttributeRead));
+                pendingBufferCopies.push_back(PendingBufferCopy(entry.mesh.indices, payload.indexData.data(),
+                                                                vk::AccessFlagBits::eIndexRead));
+                vmaGetAllocationInfo(refInitData->allocator(), entry.mesh.vertices.allocation, &allocInfo);
+                entry.residentBytes = allocInfo.size;
+                vmaGetAllocationInfo(refInitData->allocator(), entry.mesh.indices.allocation, &allocInfo);
+                entry.residentBytes += allocInfo.size;
+            }
+
+            residentBytes += entry.residentBytes;
+            entry.state = STREAM_UPLOADING;
+        };
+
+        // Marks as used this frame; evicted entries go back in the queue (caller holds entriesMutex)
+        StreamEntry* touch(StreamHandle handle) {
+            auto it = entries.find(handle);
+            if(it == entries.end() || it->second.releaseRequested) {
+                return nullptr;
+            }
+            StreamEntry &entry = it->second;
+            entry.lastUsedFrame = frameIndex;
+            if(entry.state == STREAM_EVICTED) {
+                enqueueDecode(handle, entry);
+            }
+            return (entry.state == STREAM_RESIDENT) ? &entry : nullptr;
+        };
+
+    public:
+        // Needs a transfer queue (see VulkanInitCreateInfo::requireTransferQueue)
+        StreamingManager(   VulkanInitData &vkInitData, 
+                            StreamingOptions options = {}, 
+                            JobSystem &jobs = JobSystem::getDefault()) {
+            refInitData = &vkInitData;
+            refJobs = &jobs;
+            this->options = options;
+            if(jobs.getThreadCnt() < 2) {
+                print_warning("StreamingManager", "JobSystem has one thread: decoding only runs while it waits on jobs.");
+            }
+            transferManager = make_unique<TransferManager>(vkInitData, options.stagingRingSize);
+        };
+
+        ~StreamingManager() {
+            {
+                lock_guard<mutex> lock(entriesMutex);
+                stopping = true;
+            }
+
+            // Running decode jobs finish their current file
+            refJobs->wait(decodeCounter);
+
+            // Frames in flight may still use any of these
+            refInitData->device().waitIdle();
+            transferManager.reset();
+            for(auto &[handle, entry] : entries) {
+                destroyResources(entry);
+            }
+        };
+
+        // Copy: forbidden (unique ownership)
+        StreamingManager(const StreamingManager&)            = delete;
+        StreamingManager& operator=(const StreamingManager&) = delete;
+
+        StreamHandle request(const StreamRequest &request) {
+            lock_guard<mutex> lock(entriesMutex);
+            StreamHandle handle = nextHandle++;
+            StreamEntry &entry = entries[handle];
+            entry.request = request;
+            entry.order = nextOrder++;
+            entry.lastUsedFrame = frameIndex;
+            enqueueDecode(handle, entry);
+            return handle;
+        };
+
+        // Also reorders anything still waiting for a decode job
+        void setPriority(StreamHandle handle, float priority) {
+            lock_guard<mutex> lock(entriesMutex);
+            auto it = entries.find(handle);
+            if(it == entries.end()) {
+                return;
+            }
+            it->second.request.priority = priority;
+            if(it->second.state == STREAM_QUEUED) {
+                enqueueDecode(handle, it->second);
+            }
+        };
+
+        // Freed in a later update(), once no frame in flight can use it
+        void release(StreamHandle handle) {
+            lock_guard<mutex> lock(entriesMutex);
+            auto it = entries.find(handle);
+            if(it != entries.end()) {
+                it->second.releaseRequested = true;
+            }
+        };
+
+        // Call once per frame, BEFORE recording draws: receive barriers for finished uploads
+        // are recorded into graphicsCommandBuffer (so those resources can be used right after).
+        void update(vk::CommandBuffer &graphicsCommandBuffer) {
+            frameIndex++;
+
+            // Finished uploads (batches complete in submission order)
+            vector<StreamHandle> allFinished {};
+            while(!allInFlightBatches.empty()
+                    && transferManager->checkCompleted(allInFlightBatches.front().receipt, graphicsCommandBuffer)) {
+                allFinished.insert(allFinished.end(), allInFlightBatches.front().allHandles.begin(),
+                                                        allInFlightBatches.front().allHandles.end());
+                allInFlightBatches.pop_front();
+            }
+
+            vector<PendingBufferCopy> pendingBufferCopies {};
+            vector<PendingImageCopy> pendingImageCopies {};
+            UploadBatch batch {};
+            {
+                lock_guard<mutex> lock(entriesMutex);
+                for(StreamHandle handle : allFinished) {
+                    StreamEntry &entry = entries.at(handle);
+                    entry.payload = StreamPayload();
+                    entry.state = STREAM_RESIDENT;
+                }
+
+                // Released entries (skip ones a decode job or the transfer queue still has)
+                for(auto it = entries.begin(); it != entries.end(); ) {
+                    StreamEntry &entry = it->second;
+                    if(entry.releaseRequested && entry.state != STREAM_DECODING && entry.state != STREAM_UPLOADING
+                        && isSafeToDestroy(entry)) {
+                        destroyResources(entry);
+                        it = entries.erase(it);
+                    }
+                    else {
+                        ++it;
+                    }
+                }
+
+                // Decoded entries, highest priority first
+                vector<pair<StreamEntry*, StreamHandle>> allDecoded {};
+                for(auto &[handle, entry] : entries) {
+                    if(entry.state == STREAM_DECODED && !entry.releaseRequested) {
+                        allDecoded.push_back({ &entry, handle });
+                    }
+                }
+                sort(allDecoded.begin(), allDecoded.end(), [](const auto &a, const auto &b) {
+                    if(a.first->request.priority != b.first->request.priority) {
+                        return a.first->request.priority > b.first->request.priority;
+                    }
+                    return a.first->order < b.first->order;
+                });
+
+                vk::DeviceSize heapUsage = 0, heapBudget = 0;
+                getDeviceLocalHeapBudget(*refInitData, heapUsage, heapBudget);
+
+                // Upload within this frame's byte budget (at least one, so huge assets still get through)
+                vk::DeviceSize uploadedBytes = 0;
+                for(auto &[entry, handle] : allDecoded) {
+                    vk::DeviceSize size = entry->payload.getSize();
+                    if(options.maxUploadBytesPerFrame > 0 && uploadedBytes > 0
+                        && uploadedBytes + size > options.maxUploadBytesPerFrame) {
+                        break;
+                    }
+                    if(!makeRoom(size, heapUsage, heapBudget)) {
+                        break;
+                    }
+
+                    prepareUpload(*entry, pendingBufferCopies, pendingImageCopies);
+                    batch.allHandles.push_back(handle);
+                    heapUsage += entry->residentBytes;
+                    uploadedBytes += size;
+                }
+                uploadedBytesLastFrame = uploadedBytes;
+            }
+
+            // Payloads of UPLOADING entries are not touched by the decode jobs, so no lock needed
+            if(!batch.allHandles.empty()) {
+                batch.receipt = transferManager->submitCopies(pendingBufferCopies, pendingImageCopies);
+                allInFlightBatches.push_back(batch);
+            }
+        };
+
+        // nullptr unless resident (marks it as used this frame)
+        const VulkanImage* getTexture(StreamHandle handle) {
+            lock_guard<mutex> lock(entriesMutex);
+            StreamEntry *entry = touch(handle);
+            return (entry && entry->request.type == STREAM_TEXTURE) ? &entry->texture : nullptr;
+        };
+
+        const VulkanMesh* getMesh(StreamHandle handle) {
+            lock_guard<mutex> lock(entriesMutex);
+            StreamEntry *entry = touch(handle);
+            return (entry && entry->request.type == STREAM_MESH) ? &entry->mesh : nullptr;
+        };
+
+        STREAM_STATE getState(StreamHandle handle) {
+            lock_guard<mutex> lock(entriesMutex);
+            auto it = entries.find(handle);
+            return (it == entries.end()) ? STREAM_FAILED : it->second.state;
+        };
+
+        StreamingStats getStats() {
+            StreamingStats stats {};
+            {
+                lock_guard<mutex> lock(entriesMutex);
+                for(auto &[handle, entry] : entries) {
+                    switch(entry.state) {
+                        case STREAM_QUEUED:
+                        case STREAM_DECODING:   stats.queuedCnt++; break;
+                        case STREAM_DECODED:    stats.decodedCnt++; break;
+                        case STREAM_UPLOADING:  stats.uploadingCnt++; break;
+                        case STREAM_RESIDENT:   stats.residentCnt++; break;
+                        case STREAM_EVICTED:    stats.evictedCnt++; break;
+                        case STREAM_FAILED:     stats.failedCnt++; break;
+                    }
+                }
+            }
+            stats.residentBytes = residentBytes;
+            stats.uploadedBytesLastFrame = uploadedBytesLastFrame;
+            stats.totalEvictions = totalEvictions;
+            getDeviceLocalHeapBudget(*refInitData, stats.heapUsage, stats.heapBudget);
+            return stats;
+        };
+    };
+}
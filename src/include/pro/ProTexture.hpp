@@ -0,0 +1,169 @@
+#pragma once
+#include "ProBuffer.hpp"
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    struct VulkanSamplerCreateInfo {
+        vk::Filter filter = vk::Filter::eLinear;
+        vk::SamplerMipmapMode mipmapMode = vk::SamplerMipmapMode::eLinear;
+        vk::SamplerAddressMode addressMode = vk::SamplerAddressMode::eRepeat;
+        float maxAnisotropy = 16.0f;        // Clamped to the device limit (<= 1 turns it off)
+        float maxLod = VK_LOD_CLAMP_NONE;   // Use every mip level the image has
+    };
+
+    enum MIPMAP_MODE {
+        MIPMAPS_NONE,
+        MIPMAPS_GPU,        // Blits on the graphics queue (falls back to MIPMAPS_CPU if the format can't be blitted)
+        MIPMAPS_CPU         // generateHostMipChain() on worker threads, uploaded with level 0
+    };
+
+    struct TextureLoadOptions {
+        bool sRGB = true;                   // False for data textures (e.g., normal maps)
+        unsigned int threadCnt = 0;         // Decode threads (0 = all of JobSystem::getDefault())
+        MIPMAP_MODE mipmaps = MIPMAPS_GPU;
+        MIPMAP_FILTER_TYPE cpuFilter = MIPMAP_BOX;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    inline vk::Sampler createVulkanSampler( VulkanInitData &vkInitData,
+                                            const VulkanSamplerCreateInfo &samplerInfo = {}) {
+        float deviceMaxAnisotropy = vkInitData.physicalDevice().getProperties().limits.maxSamplerAnisotropy;
+        float maxAnisotropy = min(samplerInfo.maxAnisotropy, deviceMaxAnisotropy);
+
+        vk::SamplerCreateInfo createInfo {};
+        createInfo.magFilter = samplerInfo.filter;
+        createInfo.minFilter = samplerInfo.filter;
+        createInfo.mipmapMode = samplerInfo.mipmapMode;
+        createInfo.addressModeU = samplerInfo.addressMode;
+        createInfo.addressModeV = samplerInfo.addressMode;
+        createInfo.addressModeW = samplerInfo.addressMode;
+        createInfo.anisotropyEnable = (maxAnisotropy > 1.0f);   // samplerAnisotropy is requested by default
+        createInfo.maxAnisotropy = max(1.0f, maxAnisotropy);
+        createInfo.minLod = 0.0f;
+        createInfo.maxLod = samplerInfo.maxLod;
+        createInfo.borderColor = vk::BorderColor::eFloatOpaqueBlack;
+
+        return vkInitData.device().createSampler(createInfo);
+    };
+
+    inline void cleanupVulkanSampler(VulkanInitData &vkInitData, vk::Sampler &sampler) {
+        if(sampler) {
+            vkInitData.device().destroySampler(sampler);
+            sampler = vk::Sampler();
+        }
+    };
+
+    // Sampled image that can be filled with PendingImageCopy
+    inline VulkanImage createTextureImage(  VulkanInitData &vkInitData,
+                                            uint32_t width, uint32_t height,
+                                            vk::Format format,
+                                            uint32_t mipLevels = 1) {
+        vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+        if(mipLevels > 1) {
+            usage |= vk::ImageUsageFlagBits::eTransferSrc;     // For recordGenerateMipmaps()
+        }
+        return createVulkanImage(   vkInitData,
+                                    vk::Extent3D { width, height, 1 },
+                                    format,
+                                    usage,
+                                    vk::ImageAspectFlagBits::eColor,
+                                    mipLevels, vk::SampleCountFlagBits::e1);
+    };
+
+    // Decodes every file at once (stb_image is thread-safe for loading)
+    inline vector<HostImage> loadHostImagesParallel(const vector<string> &filenames,
+                                                    int desiredChannels = 4,
+                                                    unsigned int threadCnt = 0) {
+        vector<HostImage> allImages(filenames.size());
+        vector<string> allErrors(filenames.size());
+
+        runInParallel(filenames.size(), [&](size_t i) {
+            try {
+                allImages[i] = loadHostImage(filenames[i], desiredChannels);
+            }
+            catch(const exception &e) {
+                allErrors[i] = e.what();
+            }
+        }, threadCnt);
+
+        // Rethrow on THIS thread
+        for(auto &err : allErrors) {
+            if(!err.empty()) {
+                throw runtime_error(err);
+            }
+        }
+        return allImages;
+    };
+
+    // Creates a texture for each (RGBA) host image and uploads ALL of them in one batch.
+    // Images land in eShaderReadOnlyOptimal once the receive barriers are recorded
+    // (TransferManager::checkCompleted() or receiveOnGraphics()); GPU mips are blitted then too.
+    inline BufferCopyReceipt submitTextureUploads(  VulkanInitData &vkInitData,
+                                                    TransferManager &transferManager,
+                                                    vector<HostImage> &hostImages,
+                                                    vector<VulkanImage> &allTextures,
+                                                    TextureLoadOptions options = {}) {
+        vk::Format format = options.sRGB ? vk::Format::eR8G8B8A8Srgb : vk::Format::eR8G8B8A8Unorm;
+
+        MIPMAP_MODE mipmaps = options.mipmaps;
+        if(mipmaps == MIPMAPS_GPU && !canBlitMipmaps(vkInitData, format)) {
+            mipmaps = MIPMAPS_CPU;
+        }
+
+        for(auto &hostImage : hostImages) {
+            if(hostImage.channels != 4) {
+                print_and_throw_error("submitTextureUploads", "Only 4-channel (RGBA) host images are supported!");
+            }
+        }
+
+        // CPU mips: build and pack every chain in parallel (only needs to live until submitCopies())
+        vector<vector<unsigned char>> allMipData(hostImages.size());
+        vector<vector<vk::BufferImageCopy>> allMipRegions(hostImages.size());
+        if(mipmaps == MIPMAPS_CPU) {
+            runInParallel(hostImages.size(), [&](size_t i) {
+                vector<HostImage> levels = generateHostMipChain(hostImages[i], options.sRGB, options.cpuFilter);
+                packHostMipChain(levels, allMipData[i], allMipRegions[i]);
+            }, options.threadCnt);
+        }
+
+        vector<PendingImageCopy> pendingCopies {};
+        for(size_t i = 0; i < hostImages.size(); i++) {
+            HostImage &hostImage = hostImages[i];
+            uint32_t mipLevels = (mipmaps == MIPMAPS_NONE) ? 1 
+                                    : getMipLevelCount((uint32_t)hostImage.width, (uint32_t)hostImage.height);
+
+            VulkanImage texture = createTextureImage(   vkInitData,
+                                                        (uint32_t)hostImage.width, (uint32_t)hostImage.height,
+                                                        format, mipLevels);
+
+            if(mipmaps == MIPMAPS_CPU) {
+                pendingCopies.push_back(PendingImageCopy(texture, allMipData[i].data(), allMipData[i].size(), allMipRegions[i]));
+            }
+            else {
+                pendingCopies.push_back(PendingImageCopy(texture, hostImage.data.data(), hostImage.data.size()));
+                pendingCopies.back().generateMipmaps = (mipmaps == MIPMAPS_GPU);
+            }
+            allTextures.push_back(texture);
+        }
+
+        vector<PendingBufferCopy> noBufferCopies {};
+        return transferManager.submitCopies(noBufferCopies, pendingCopies);
+    };
+
+    // Decode on worker threads, then one transfer-queue submission for everything
+    inline BufferCopyReceipt loadTextures(  VulkanInitData &vkInitData,
+                                            TransferManager &transferManager,
+                                            const vector<string> &filenames,
+                                            vector<VulkanImage> &allTextures,
+                                            TextureLoadOptions options = {}) {
+        vector<HostImage> hostImages = loadHostImagesParallel(filenames, 4, options.threadCnt);
+        return submitTextureUploads(vkInitData, transferManager, hostImages, allTextures, options);
+    };
+}
@@ -0,0 +1,394 @@
+#pragma once
+#include "ProFile.hpp"
+#include "ProTexture.hpp"
+#include "ProBC.hpp"
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Bump whenever the encoder output or the source info changes (old caches are then rebuilt)
+    const uint32_t TEXTURE_CACHE_VERSION = 2;           // 2: BC5/normal map mips are always filtered linearly
+    const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    const char TEXTURE_CACHE_SOURCE_KEY[] = "ProSource";
+    const uint64_t TEXTURE_CACHE_LEVEL_ALIGNMENT = 16;
+
+    // File layout (KTX2 container, but no Data Format Descriptor and no supercompression):
+    //  KTX2Header
+    //  KTX2LevelIndex[levelCount]
+    //  Key/value data: one "ProSource" entry holding a TextureCacheSourceInfo
+    //  (padding) level data, smallest level first (as in KTX2)
+    struct KTX2Header {
+        uint8_t identifier[12] = {};
+        uint32_t vkFormat = 0;
+        uint32_t typeSize = 1;
+        uint32_t pixelWidth = 0;
+        uint32_t pixelHeight = 0;
+        uint32_t pixelDepth = 0;
+        uint32_t layerCount = 0;
+        uint32_t faceCount = 1;
+        uint32_t levelCount = 0;
+        uint32_t supercompressionScheme = 0;
+
+        uint32_t dfdByteOffset = 0;
+        uint32_t dfdByteLength = 0;
+        uint32_t kvdByteOffset = 0;
+        uint32_t kvdByteLength = 0;
+        uint64_t sgdByteOffset = 0;
+        uint64_t sgdByteLength = 0;
+    };
+
+    struct KTX2LevelIndex {
+        uint64_t byteOffset = 0;
+        uint64_t byteLength = 0;
+        uint64_t uncompressedByteLength = 0;
+    };
+
+    // Source file info + encoder settings (cache is stale if any of these change)
+    struct TextureCacheSourceInfo {
+        uint32_t version = TEXTURE_CACHE_VERSION;
+        uint32_t mipFilter = 0;
+        uint64_t sourceHash = 0;
+        int64_t sourceModifiedTime = 0;
+        uint64_t sourceSize = 0;
+    };
+
+    struct TextureCacheOptions {
+        TEXTURE_COMPRESSION compression = COMPRESS_AUTO;
+        bool isNormalMap = false;           // COMPRESS_AUTO picks BC5; forces linear (non-sRGB) mips and format
+
+        // If false, only mtime/size are compared (skips reading the whole source)
+        bool verifySourceHash = true;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // HELPER FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    inline uint64_t alignTextureCacheOffset(uint64_t offset) {
+        return (offset + TEXTURE_CACHE_LEVEL_ALIGNMENT - 1) & ~(TEXTURE_CACHE_LEVEL_ALIGNMENT - 1);
+    };
+
+    // e.g., "bricks.png" -> "bricks.png.bc7.ktx2"
+    inline string getTextureCacheFilename(const string &sourceFilename, TEXTURE_COMPRESSION compression) {
+        return sourceFilename + "." + getTextureCompressionName(compression) + ".ktx2";
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    // A compressed mip chain read straight out of a memory-mapped cache file.
+    // The upload data points INTO the mapping (no copies),
+    // so this must stay alive until any uploads from it are submitted.
+    class MappedCompressedTexture {
+    private:
+        MappedFile file {};
+        const KTX2Header *header = nullptr;
+        const KTX2LevelIndex *levels = nullptr;
+        TextureCacheSourceInfo sourceInfo {};      // Copied out (key/value data is only 4-byte aligned)
+
+    public:
+        MappedCompressedTexture() = default;
+
+        // Maps filename and checks it is a complete cache file (returns false otherwise)
+        bool open(const string &filename) {
+            header = nullptr;
+            if(!file.open(filename) || file.size() < sizeof(KTX2Header)) {
+                return false;
+            }
+
+            const KTX2Header *h = reinterpret_cast<const KTX2Header*>(file.data());
+            if(memcmp(h->identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0
+                || h->levelCount == 0 || h->supercompressionScheme != 0
+                || sizeof(KTX2Header) + (uint64_t)h->levelCount*sizeof(KTX2LevelIndex) > file.size()) {
+                return false;
+            }
+
+            // Levels must actually be in the file (truncated writes, etc.)
+            const KTX2LevelIndex *l = reinterpret_cast<const KTX2LevelIndex*>(file.data() + sizeof(KTX2Header));
+            for(uint32_t i = 0; i < h->levelCount; i++) {
+                if(l[i].byteOffset + l[i].byteLength > file.size()) {
+                    return false;
+                }
+            }
+
+            // Find our key/value entry
+            bool foundInfo = false;
+            uint64_t kvdEnd = (uint64_t)h->kvdByteOffset + h->kvdByteLength;
+            if(kvdEnd > file.size()) {
+                return false;
+            }
+            for(uint64_t pos = h->kvdByteOffset; pos + sizeof(uint32_t) <= kvdEnd; ) {
+                uint32_t length = 0;
+                memcpy(&length, file.data() + pos, sizeof(length));
+                const char *entry = file.data() + pos + sizeof(length);
+                if(pos + sizeof(length) + length > kvdEnd) {
+                    break;
+                }
+                if(length == sizeof(TEXTURE_CACHE_SOURCE_KEY) + sizeof(TextureCacheSourceInfo)
+                    && memcmp(entry, TEXTURE_CACHE_SOURCE_KEY, sizeof(TEXTURE_CACHE_SOURCE_KEY)) == 0) {
+                    memcpy(&sourceInfo, entry + sizeof(TEXTURE_CACHE_SOURCE_KEY), sizeof(sourceInfo));
+                    foundInfo = true;
+                    break;
+                }
+                pos += sizeof(length) + ((length + 3) & ~3u);
+            }
+            if(!foundInfo || sourceInfo.version != TEXTURE_CACHE_VERSION) {
+                return false;
+            }
+
+            header = h;
+            levels = l;
+            return true;
+        };
+
+        bool isOpen() const noexcept { return header != nullptr; };
+        const KTX2Header& getHeader() const { return *header; };
+        const TextureCacheSourceInfo& getSourceInfo() const { return sourceInfo; };
+
+        vk::Format format() const { return (vk::Format)header->vkFormat; };
+        uint32_t width() const { return header->pixelWidth; };
+        uint32_t height() const { return header->pixelHeight; };
+        uint32_t levelCnt() const { return header->levelCount; };
+
+        // Every level as one span of the mapping + the regions (relative to data) for a PendingImageCopy
+        void getUploadData(const char *&data, size_t &size, vector<vk::BufferImageCopy> &regions) const {
+            uint64_t start = UINT64_MAX;
+            uint64_t end = 0;
+            for(uint32_t i = 0; i < header->levelCount; i++) {
+                start = min(start, levels[i].byteOffset);
+                end = max(end, levels[i].byteOffset + levels[i].byteLength);
+            }
+
+            regions.clear();
+            for(uint32_t i = 0; i < header->levelCount; i++) {
+                vk::BufferImageCopy region {};
+                region.bufferOffset = levels[i].byteOffset - start;
+                region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i, 0, 1);
+                region.imageExtent = vk::Extent3D(max(1u, header->pixelWidth >> i), max(1u, header->pixelHeight >> i), 1);
+                regions.push_back(region);
+            }
+
+            data = file.data() + start;
+            size = (size_t)(end - start);
+        };
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    inline bool writeTextureCache(  const string &cacheFilename,
+                                    const CompressedMipChain &chain,
+                                    vk::Format format,
+                                    const TextureCacheSourceInfo &sourceInfo) {
+        uint32_t levelCnt = (uint32_t)chain.levelOffsets.size();
+
+        KTX2Header header {};
+        memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+        header.vkFormat = (uint32_t)format;
+        header.pixelWidth = chain.width;
+        header.pixelHeight = chain.height;
+        header.levelCount = levelCnt;
+
+        uint32_t kvdLength = (uint32_t)(sizeof(TEXTURE_CACHE_SOURCE_KEY) + sizeof(TextureCacheSourceInfo));
+        header.kvdByteOffset = (uint32_t)(sizeof(KTX2Header) + levelCnt*sizeof(KTX2LevelIndex));
+        header.kvdByteLength = (uint32_t)sizeof(uint32_t) + ((kvdLength + 3) & ~3u);
+
+        // Smallest level first
+        vector<KTX2LevelIndex> levelIndex(levelCnt);
+        uint64_t offset = header.kvdByteOffset + header.kvdByteLength;
+        for(uint32_t i = levelCnt; i-- > 0; ) {
+            offset = alignTextureCacheOffset(offset);
+            levelIndex[i].byteOffset = offset;
+            levelIndex[i].byteLength = chain.levelSizes[i];
+            levelIndex[i].uncompressedByteLength = chain.levelSizes[i];
+            offset += chain.levelSizes[i];
+        }
+
+        // Same trick as the mesh cache: write temp file, then rename
+        string tempFilename = cacheFilename + ".tmp";
+        {
+            ofstream file(tempFilename, ios::binary | ios::trunc);
+            if(!file.is_open()) {
+                print_warning("writeTextureCache", "Cannot open file: " + tempFilename);
+                return false;
+            }
+
+            const char zeros[TEXTURE_CACHE_LEVEL_ALIGNMENT] = {};
+            auto padTo = [&file, &zeros](uint64_t offset) {
+                uint64_t pos = (uint64_t)file.tellp();
+                file.write(zeros, offset - pos);
+            };
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(levelIndex.data()), levelCnt*sizeof(KTX2LevelIndex));
+            file.write(reinterpret_cast<const char*>(&kvdLength), sizeof(kvdLength));
+            file.write(TEXTURE_CACHE_SOURCE_KEY, sizeof(TEXTURE_CACHE_SOURCE_KEY));
+            file.write(reinterpret_cast<const char*>(&sourceInfo), sizeof(sourceInfo));
+            padTo(header.kvdByteOffset + header.kvdByteLength);
+            for(uint32_t i = levelCnt; i-- > 0; ) {
+                padTo(levelIndex[i].byteOffset);
+                file.write(reinterpret_cast<const char*>(chain.data.data() + chain.levelOffsets[i]), chain.levelSizes[i]);
+            }
+
+            if(!file) {
+                print_warning("writeTextureCache", "Failed writing file: " + tempFilename);
+                return false;
+            }
+        }
+
+        error_code err;
+        filesystem::rename(tempFilename, cacheFilename, err);
+        if(err) {
+            print_warning("writeTextureCache", "Cannot replace " + cacheFilename + ": " + err.message());
+            filesystem::remove(tempFilename, err);
+            return false;
+        }
+        return true;
+    };
+
+    // Can we sample this BC format? (needs the textureCompressionBC feature)
+    inline bool isTextureCompressionSupported(const VulkanInitData &vkInitData, vk::Format format) {
+        if(!vkInitData.enabledFeatures().textureCompressionBC) {
+            return false;
+        }
+        vk::FormatProperties props = vkInitData.physicalDevice().getFormatProperties(format);
+        return (bool)(props.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
+    };
+
+    // Maps the BC cache of every file, (re)encoding the ones that are missing or stale,
+    // and uploads ALL of them in one batch. Mips always come from the CPU (BC can't be blitted).
+    // Falls back to loadTextures() if the device can't sample the BC format.
+    inline BufferCopyReceipt loadCompressedTextures(VulkanInitData &vkInitData,
+                                                    TransferManager &transferManager,
+                                                    const vector<string> &filenames,
+                                                    vector<VulkanImage> &allTextures,
+                                                    TextureLoadOptions options = {},
+                                                    TextureCacheOptions cacheOptions = {}) {
+        TEXTURE_COMPRESSION compression = resolveTextureCompression(cacheOptions.compression, cacheOptions.isNormalMap);
+
+        // Normals (and anything in BC5) are data: sRGB mip filtering would bend them
+        if(compression == COMPRESS_BC5 || cacheOptions.isNormalMap) {
+            options.sRGB = false;
+        }
+
+        vk::Format format = getBCFormat(compression, options.sRGB);
+        if(compression == COMPRESS_NONE || !isTextureCompressionSupported(vkInitData, format)) {
+            if(compression != COMPRESS_NONE) {
+                print_warning("loadCompressedTextures", string("Cannot sample ") + vk::to_string(format) + "; loading uncompressed.");
+            }
+            return loadTextures(vkInitData, transferManager, filenames, allTextures, options);
+        }
+
+        bool useMipmaps = (options.mipmaps != MIPMAPS_NONE);
+        TextureCacheSourceInfo expectedInfo {};
+        expectedInfo.mipFilter = useMipmaps ? (uint32_t)options.cpuFilter + 1 : 0;
+
+        // Check every cache (hashing reads the whole source, so do it in parallel)
+        vector<string> allCacheFilenames(filenames.size());
+        vector<TextureCacheSourceInfo> allSourceInfos(filenames.size(), expectedInfo);
+        vector<MappedCompressedTexture> allMapped(filenames.size());
+        vector<uint8_t> isStale(filenames.size(), 0);      // NOT vector<bool> (written from several threads)
+        vector<string> allErrors(filenames.size());
+
+        runInParallel(filenames.size(), [&](size_t i) {
+            allCacheFilenames[i] = getTextureCacheFilename(filenames[i], compression);
+
+            error_code err;
+            TextureCacheSourceInfo &info = allSourceInfos[i];
+            info.sourceSize = (uint64_t)filesystem::file_size(filenames[i], err);
+            if(err) {
+                allErrors[i] = "Cannot open source: " + filenames[i];
+                return;
+            }
+            info.sourceModifiedTime = getFileModifiedTime(filenames[i]);
+
+            // Cheap checks first
+            MappedCompressedTexture &mapped = allMapped[i];
+            bool isValid = mapped.open(allCacheFilenames[i]);
+            if(isValid) {
+                const TextureCacheSourceInfo &cached = mapped.getSourceInfo();
+                uint32_t levelCnt = useMipmaps ? getMipLevelCount(mapped.width(), mapped.height()) : 1;
+                isValid = (mapped.format() == format
+                            && mapped.levelCnt() == levelCnt
+                            && cached.mipFilter == info.mipFilter
+                            && cached.sourceModifiedTime == info.sourceModifiedTime
+                            && cached.sourceSize == info.sourceSize);
+            }
+
+            // Hash is needed to verify OR to write a new cache
+            if(!isValid || cacheOptions.verifySourceHash) {
+                if(!hashFile(filenames[i], info.sourceHash)) {
+                    allErrors[i] = "Cannot read source: " + filenames[i];
+                    return;
+                }
+                isValid = isValid && (mapped.getSourceInfo().sourceHash == info.sourceHash);
+            }
+            isStale[i] = !isValid;
+        }, options.threadCnt);
+
+        for(size_t i = 0; i < filenames.size(); i++) {
+            if(!allErrors[i].empty()) {
+                print_and_throw_error("loadCompressedTextures", allErrors[i]);
+            }
+        }
+
+        // Rebuild stale ones: decode + mips in parallel per file, then encode (parallel over block rows)
+        vector<size_t> staleIndices {};
+        vector<string> staleFilenames {};
+        for(size_t i = 0; i < filenames.size(); i++) {
+            if(isStale[i]) {
+                staleIndices.push_back(i);
+                staleFilenames.push_back(filenames[i]);
+            }
+        }
+        if(!staleIndices.empty()) {
+            vector<HostImage> hostImages = loadHostImagesParallel(staleFilenames, 4, options.threadCnt);
+            vector<vector<HostImage>> allLevels(hostImages.size());
+            runInParallel(hostImages.size(), [&](size_t i) {
+                allLevels[i] = useMipmaps ? generateHostMipChain(hostImages[i], options.sRGB, options.cpuFilter)
+                                            : vector<HostImage> { std::move(hostImages[i]) };
+            }, options.threadCnt);
+
+            for(size_t k = 0; k < staleIndices.size(); k++) {
+                size_t i = staleIndices[k];
+                CompressedMipChain chain = compressHostMipChainBC(allLevels[k], compression, options.threadCnt);
+                allLevels[k].clear();
+
+                // Unmap the stale file before replacing it
+                allMapped[i] = MappedCompressedTexture();
+                if(!writeTextureCache(allCacheFilenames[i], chain, format, allSourceInfos[i])
+                    || !allMapped[i].open(allCacheFilenames[i])) {
+                    print_and_throw_error("loadCompressedTextures", "Cannot create cache: " + allCacheFilenames[i]);
+                }
+            }
+        }
+
+        // Upload straight from the mappings
+        vector<PendingImageCopy> pendingCopies {};
+        for(auto &mapped : allMapped) {
+            const char *data = nullptr;
+            size_t size = 0;
+            vector<vk::BufferImageCopy> regions {};
+            mapped.getUploadData(data, size, regions);
+
+            VulkanImage texture = createVulkanImage(vkInitData,
+                                                    vk::Extent3D { mapped.width(), mapped.height(), 1 },
+                                                    format,
+                                                    vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+                                                    vk::ImageAspectFlagBits::eColor,
+                                                    mapped.levelCnt(), vk::SampleCountFlagBits::e1);
+
+            // Transfers only read from hostData, so the read-only mapping is fine
+            pendingCopies.push_back(PendingImageCopy(texture, const_cast<char*>(data), size, regions));
+            allTextures.push_back(texture);
+        }
+
+        vector<PendingBufferCopy> noBufferCopies {};
+        return transferManager.submitCopies(noBufferCopies, pendingCopies);
+    };
+}
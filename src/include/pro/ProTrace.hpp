@@ -0,0 +1,299 @@
+#pragma once
+#include "ProTime.hpp"
+#include <mutex>
+#include <memory>
+
+// CPU profiler: PRO_PROFILE_SCOPE("name") times the enclosing scope on the calling thread.
+// The macros only do anything if PRO_ENABLE_CPU_PROFILER is defined (CMake option of the same name);
+// otherwise they expand to nothing, so instrumented code costs nothing.
+// Names must outlive the profiler (string literals, __func__).
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // One finished scope (begin and end in one event, so rings never hold an unmatched half)
+    struct CPUTraceEvent {
+        const char *name = nullptr;
+        int64_t beginNs = 0;            // Since CPUProfiler was created
+        int64_t endNs = 0;
+        uint32_t depth = 0;             // Nesting level on its thread
+    };
+
+    struct CPUThreadTrace {
+        uint32_t threadIndex = 0;
+        string threadName = "";
+        vector<CPUTraceEvent> allEvents {};     // In order of scope END
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // CLASSES
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Fixed-size ring of events written ONLY by its owning thread (no locks).
+    // When full, the oldest events are overwritten.
+    // Readers copy out, then drop anything the writer may have overwritten in the meantime
+    // (seqlock-style: slots are relaxed atomics, so a torn copy is discarded, never a data race).
+    class CPUEventRing {
+    private:
+        struct EventSlot {
+            atomic<const char*> name {nullptr};
+            atomic<int64_t> beginNs {0};
+            atomic<int64_t> endNs {0};
+            atomic<uint32_t> depth {0};
+        };
+
+        unique_ptr<EventSlot[]> allSlots {};
+        uint64_t mask = 0;
+        atomic<uint64_t> head {0};          // Total events ever pushed
+        atomic<uint64_t> firstIndex {0};    // Events before this were cleared
+
+    public:
+        uint32_t threadIndex = 0;
+        uint32_t depth = 0;                 // Owning thread only
+        string threadName = "";             // Guarded by the CPUProfiler's mutex
+
+        explicit CPUEventRing(size_t capacity) {
+            size_t size = 1;
+            while(size < capacity) {
+                size <<= 1;
+            }
+            allSlots = make_unique<EventSlot[]>(size);
+            mask = size - 1;
+        };
+
+        // Copy: forbidden (unique ownership)
+        CPUEventRing(const CPUEventRing&)            = delete;
+        CPUEventRing& operator=(const CPUEventRing&) = delete;
+
+        void push(const CPUTraceEvent &e) {
+            uint64_t h = head.load(memory_order_relaxed);
+
+            // A reader that sees any of these stores also sees head >= h (so it drops the slot)
+            atomic_thread_fence(memory_order_release);
+            EventSlot &slot = allSlots[h & mask];
+            slot.name.store(e.name, memory_order_relaxed);
+            slot.beginNs.store(e.beginNs, memory_order_relaxed);
+            slot.endNs.store(e.endNs, memory_order_relaxed);
+            slot.depth.store(e.depth, memory_order_relaxed);
+            head.store(h + 1, memory_order_release);
+        };
+
+        void clear() {
+            firstIndex.store(head.load(memory_order_acquire), memory_order_relaxed);
+        };
+
+        void copyEvents(vector<CPUTraceEvent> &out) const {
+            uint64_t capacity = mask + 1;
+            uint64_t end = head.load(memory_order_acquire);
+            uint64_t begin = max(firstIndex.load(memory_order_relaxed), (end > capacity) ? (end - capacity) : 0);
+
+            size_t startSize = out.size();
+            for(uint64_t i = begin; i < end; i++) {
+                const EventSlot &slot = allSlots[i & mask];
+                out.push_back(CPUTraceEvent {   slot.name.load(memory_order_relaxed),
+                                                slot.beginNs.load(memory_order_relaxed),
+                                                slot.endNs.load(memory_order_relaxed),
+                                                slot.depth.load(memory_order_relaxed) });
+            }
+
+            // The writer may have lapped us (+1 for the slot it may be writing right now)
+            atomic_thread_fence(memory_order_acquire);
+            uint64_t after = head.load(memory_order_relaxed) + 1;
+            uint64_t firstValid = (after > capacity) ? (after - capacity) : 0;
+            if(firstValid > begin) {
+                size_t dropCnt = (size_t)min(firstValid - begin, end - begin);
+                out.erase(out.begin() + startSize, out.begin() + startSize + dropCnt);
+            }
+        };
+    };
+
+    // Process-wide registry of per-thread rings (the mutex is only taken when a thread
+    // records its first event, names itself, or on capture/clear)
+    class CPUProfiler {
+    private:
+        mutex registryMutex;
+        vector<shared_ptr<CPUEventRing>> allRings {};   // Kept after their threads exit
+        atomic<bool> enabled {true};
+        size_t ringCapacity = 1 << 16;
+        chrono::steady_clock::time_point origin = getTime();
+
+        CPUProfiler() = default;
+
+        shared_ptr<CPUEventRing> registerThread() {
+            lock_guard<mutex> lock(registryMutex);
+            auto ring = make_shared<CPUEventRing>(ringCapacity);
+            ring->threadIndex = (uint32_t)allRings.size();
+            ring->threadName = "Thread " + to_string(ring->threadIndex);
+            allRings.push_back(ring);
+            return ring;
+        };
+
+        static void writeJSONString(ostream &out, const string &s) {
+            out << '"';
+            for(char c : s) {
+                if(c == '"' || c == '\\') {
+                    out << '\\' << c;
+                }
+                else if((unsigned char)c < 0x20) {
+                    char buffer[8];
+                    snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned int)c);
+                    out << buffer;
+                }
+                else {
+                    out << c;
+                }
+            }
+            out << '"';
+        };
+
+    public:
+        static CPUProfiler& get() {
+            static CPUProfiler profiler;
+            return profiler;
+        };
+
+        // Copy: forbidden (unique ownership)
+        CPUProfiler(const CPUProfiler&)            = delete;
+        CPUProfiler& operator=(const CPUProfiler&) = delete;
+
+        // Ring of the calling thread (created on first use)
+        CPUEventRing& threadRing() {
+            thread_local shared_ptr<CPUEventRing> ring = registerThread();
+            return *ring;
+        };
+
+        int64_t nowNs() const {
+            return chrono::duration_cast<chrono::nanoseconds>(getTime() - origin).count();
+        };
+
+        // Runtime switch (scopes still cost an atomic load while off)
+        void setEnabled(bool isEnabled) { enabled.store(isEnabled, memory_order_relaxed); };
+        bool isEnabled() const noexcept { return enabled.load(memory_order_relaxed); };
+
+        // Only affects threads that have not recorded anything yet
+        void setRingCapacity(size_t capacity) {
+            lock_guard<mutex> lock(registryMutex);
+            ringCapacity = max<size_t>(1, capacity);
+        };
+
+        void setThreadName(const string &name) {
+            CPUEventRing &ring = threadRing();
+            lock_guard<mutex> lock(registryMutex);
+            ring.threadName = name;
+        };
+
+        void clear() {
+            lock_guard<mutex> lock(registryMutex);
+            for(auto &ring : allRings) {
+                ring->clear();
+            }
+        };
+
+        // Safe while other threads keep recording
+        vector<CPUThreadTrace> capture() {
+            lock_guard<mutex> lock(registryMutex);
+            vector<CPUThreadTrace> allTraces {};
+            for(auto &ring : allRings) {
+                CPUThreadTrace trace {};
+                trace.threadIndex = ring->threadIndex;
+                trace.threadName = ring->threadName;
+                ring->copyEvents(trace.allEvents);
+                allTraces.push_back(std::move(trace));
+            }
+            return allTraces;
+        };
+
+        // Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev); nesting is shown from the timestamps
+        bool writeChromeTrace(const string &filename) {
+            vector<CPUThreadTrace> allTraces = capture();
+
+            ofstream file(filename, ios::trunc);
+            if(!file.is_open()) {
+                print_warning("CPUProfiler", "Cannot open file: " + filename);
+                return false;
+            }
+
+            file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+            bool isFirst = true;
+            auto separator = [&]() {
+                file << (isFirst ? "\n" : ",\n");
+                isFirst = false;
+            };
+
+            char buffer[64];
+            for(auto &trace : allTraces) {
+                separator();
+                file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << trace.threadIndex << ",\"args\":{\"name\":";
+                writeJSONString(file, trace.threadName);
+                file << "}}";
+
+                for(auto &e : trace.allEvents) {
+                    separator();
+                    file << "{\"ph\":\"X\",\"cat\":\"cpu\",\"name\":";
+                    writeJSONString(file, e.name ? e.name : "");
+                    // Microseconds
+                    snprintf(buffer, sizeof(buffer), ",\"ts\":%.3f,\"dur\":%.3f",
+                                e.beginNs / 1000.0, (e.endNs - e.beginNs) / 1000.0);
+                    file << buffer << ",\"pid\":1,\"tid\":" << trace.threadIndex << "}";
+                }
+            }
+            file << "\n]}\n";
+
+            if(!file) {
+                print_warning("CPUProfiler", "Failed writing file: " + filename);
+                return false;
+            }
+            return true;
+        };
+    };
+
+    // Times its own lifetime on the calling thread (use PRO_PROFILE_SCOPE instead, so it compiles out)
+    class CPUProfileScope {
+    private:
+        CPUEventRing *ring = nullptr;
+        const char *name = nullptr;
+        int64_t beginNs = 0;
+
+    public:
+        explicit CPUProfileScope(const char *name) {
+            CPUProfiler &profiler = CPUProfiler::get();
+            if(profiler.isEnabled()) {
+                this->name = name;
+                ring = &profiler.threadRing();
+                ring->depth++;
+                beginNs = profiler.nowNs();
+            }
+        };
+
+        ~CPUProfileScope() {
+            if(ring) {
+                int64_t endNs = CPUProfiler::get().nowNs();
+                ring->depth--;
+                ring->push(CPUTraceEvent {name, beginNs, endNs, ring->depth});
+            }
+        };
+
+        // Copy: forbidden (unique ownership)
+        CPUProfileScope(const CPUProfileScope&)            = delete;
+        CPUProfileScope& operator=(const CPUProfileScope&) = delete;
+    };
+}
+
+///////////////////////////////////////////////////////////////////////////
+// MACROS
+///////////////////////////////////////////////////////////////////////////
+
+#ifdef PRO_ENABLE_CPU_PROFILER
+    #define PRO_PROFILE_CONCAT_INNER(a, b) a##b
+    #define PRO_PROFILE_CONCAT(a, b) PRO_PROFILE_CONCAT_INNER(a, b)
+    #define PRO_PROFILE_SCOPE(name) pro::CPUProfileScope PRO_PROFILE_CONCAT(proProfileScope, __LINE__)(name)
+    #define PRO_PROFILE_FUNCTION() PRO_PROFILE_SCOPE(__func__)
+    #define PRO_PROFILE_THREAD_NAME(name) pro::CPUProfiler::get().setThreadName(name)
+#else
+    #define PRO_PROFILE_SCOPE(name) ((void)0)
+    #define PRO_PROFILE_FUNCTION() ((void)0)
+    #define PRO_PROFILE_THREAD_NAME(name) ((void)0)
+#endif
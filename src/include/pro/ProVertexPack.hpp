@@ -0,0 +1,360 @@
+#pragma once
+#include "ProMesh.hpp"
+#include "glm/gtc/packing.hpp"
+#include "glm/gtc/type_precision.hpp"
+
+namespace pro {
+
+    ///////////////////////////////////////////////////////////////////////////
+    // STRUCTS
+    ///////////////////////////////////////////////////////////////////////////
+
+    // How snorm16 positions map back to object space:
+    //  pos = posOffset + posScale * packedPos
+    // (pass to the vertex shader, e.g., as a push constant)
+    struct VertexQuantization {
+        glm::vec3 posOffset {0,0,0};
+        glm::vec3 posScale {1,1,1};
+    };
+
+    // Largest error (over all vertices) introduced by packing
+    struct VertexQuantizationReport {
+        size_t bytesBefore = 0;
+        size_t bytesAfter = 0;
+        float maxPosError = 0.0f;               // Object-space units
+        float maxNormalErrorDegrees = 0.0f;
+        float maxUVError = 0.0f;
+        float maxColorError = 0.0f;             // 0 to 1
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // HELPER FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    inline float signNotZero(float v) {
+        return (v >= 0.0f) ? 1.0f : -1.0f;
+    };
+
+    // Octahedral normal encoding (unit vector -> [-1,1]^2)
+    inline glm::vec2 encodeOctahedral(glm::vec3 n) {
+        float l1 = glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+        if(l1 == 0.0f) {
+            return glm::vec2(0,0);
+        }
+        n /= l1;
+        glm::vec2 p(n.x, n.y);
+        if(n.z < 0.0f) {
+            p = glm::vec2(  (1.0f - glm::abs(n.y)) * signNotZero(n.x),
+                            (1.0f - glm::abs(n.x)) * signNotZero(n.y));
+        }
+        return p;
+    };
+
+    // Same as in the shader:
+    //  vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+    //  if(n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    //  n = normalize(n);
+    inline glm::vec3 decodeOctahedral(glm::vec2 p) {
+        glm::vec3 n(p.x, p.y, 1.0f - glm::abs(p.x) - glm::abs(p.y));
+        if(n.z < 0.0f) {
+            float x = n.x;
+            n.x = (1.0f - glm::abs(n.y)) * signNotZero(x);
+            n.y = (1.0f - glm::abs(x)) * signNotZero(n.y);
+        }
+        return glm::normalize(n);
+    };
+
+    inline void packOctahedralSnorm16(const glm::vec3 &n, int16_t out[2]) {
+        glm::vec2 p = encodeOctahedral(n);
+        out[0] = (int16_t)glm::packSnorm1x16(p.x);
+        out[1] = (int16_t)glm::packSnorm1x16(p.y);
+    };
+
+    inline glm::vec3 unpackOctahedralSnorm16(const int16_t in[2]) {
+        return decodeOctahedral(glm::vec2(  glm::unpackSnorm1x16((uint16_t)in[0]),
+                                            glm::unpackSnorm1x16((uint16_t)in[1])));
+    };
+
+    inline void packHalf4(const glm::vec3 &v, uint16_t out[4]) {
+        out[0] = glm::packHalf1x16(v.x);
+        out[1] = glm::packHalf1x16(v.y);
+        out[2] = glm::packHalf1x16(v.z);
+        out[3] = glm::packHalf1x16(1.0f);
+    };
+
+    inline glm::vec3 unpackHalf4(const uint16_t in[4]) {
+        return glm::vec3(glm::unpackHalf1x16(in[0]), glm::unpackHalf1x16(in[1]), glm::unpackHalf1x16(in[2]));
+    };
+
+    inline void packHalf2(const glm::vec2 &v, uint16_t out[2]) {
+        out[0] = glm::packHalf1x16(v.x);
+        out[1] = glm::packHalf1x16(v.y);
+    };
+
+    inline glm::vec2 unpackHalf2(const uint16_t in[2]) {
+        return glm::vec2(glm::unpackHalf1x16(in[0]), glm::unpackHalf1x16(in[1]));
+    };
+
+    inline vk::VertexInputAttributeDescription createAttribDesc(uint32_t location, uint32_t binding,
+                                                                vk::Format format, uint32_t offset) {
+        return vk::VertexInputAttributeDescription(location, binding, format, offset);
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // PACKED VERTEX FORMATS
+    // Shader locations follow member order (starting at 0).
+    // Each provides pack()/unpack() (to/from LoaderVertex) and getAttribDesc().
+    ///////////////////////////////////////////////////////////////////////////
+
+    // 12 bytes: half-float position + unorm8 color
+    // (drop-in for vec3 pos + vec4 color shaders)
+    struct PackedVertexPC {
+        uint16_t pos[4];
+        uint32_t color;
+
+        static constexpr bool hasNormal = false;
+        static constexpr bool hasUV = false;
+        static constexpr bool hasColor = true;
+        static constexpr bool needsQuantization = false;
+
+        static PackedVertexPC pack(const LoaderVertex &lv, const VertexQuantization &q) {
+            PackedVertexPC v {};
+            packHalf4(lv.pos, v.pos);
+            v.color = glm::packUnorm4x8(lv.color);
+            return v;
+        };
+
+        static LoaderVertex unpack(const PackedVertexPC &v, const VertexQuantization &q) {
+            LoaderVertex lv {};
+            lv.pos = unpackHalf4(v.pos);
+            lv.color = glm::unpackUnorm4x8(v.color);
+            return lv;
+        };
+
+        static vector<vk::VertexInputAttributeDescription> getAttribDesc(uint32_t binding = 0) {
+            return {
+                createAttribDesc(0, binding, vk::Format::eR16G16B16A16Sfloat, offsetof(PackedVertexPC, pos)),
+                createAttribDesc(1, binding, vk::Format::eR8G8B8A8Unorm, offsetof(PackedVertexPC, color))
+            };
+        };
+    };
+
+    // 16 bytes: half-float position + octahedral snorm16 normal + half-float UV
+    struct PackedVertexPNU {
+        uint16_t pos[4];
+        int16_t normal[2];
+        uint16_t uv[2];
+
+        static constexpr bool hasNormal = true;
+        static constexpr bool hasUV = true;
+        static constexpr bool hasColor = false;
+        static constexpr bool needsQuantization = false;
+
+        static PackedVertexPNU pack(const LoaderVertex &lv, const VertexQuantization &q) {
+            PackedVertexPNU v {};
+            packHalf4(lv.pos, v.pos);
+            packOctahedralSnorm16(lv.normal, v.normal);
+            packHalf2(lv.uv, v.uv);
+            return v;
+        };
+
+        static LoaderVertex unpack(const PackedVertexPNU &v, const VertexQuantization &q) {
+            LoaderVertex lv {};
+            lv.pos = unpackHalf4(v.pos);
+            lv.normal = unpackOctahedralSnorm16(v.normal);
+            lv.uv = unpackHalf2(v.uv);
+            return lv;
+        };
+
+        static vector<vk::VertexInputAttributeDescription> getAttribDesc(uint32_t binding = 0) {
+            return {
+                createAttribDesc(0, binding, vk::Format::eR16G16B16A16Sfloat, offsetof(PackedVertexPNU, pos)),
+                createAttribDesc(1, binding, vk::Format::eR16G16Snorm, offsetof(PackedVertexPNU, normal)),
+                createAttribDesc(2, binding, vk::Format::eR16G16Sfloat, offsetof(PackedVertexPNU, uv))
+            };
+        };
+    };
+
+    // 20 bytes: snorm16 position (relative to mesh bounds; see VertexQuantization)
+    // + octahedral snorm16 normal + half-float UV + unorm8 color
+    struct QuantizedVertexPNUC {
+        int16_t pos[4];
+        int16_t normal[2];
+        uint16_t uv[2];
+        uint32_t color;
+
+        static constexpr bool hasNormal = true;
+        static constexpr bool hasUV = true;
+        static constexpr bool hasColor = true;
+        static constexpr bool needsQuantization = true;
+
+        static QuantizedVertexPNUC pack(const LoaderVertex &lv, const VertexQuantization &q) {
+            QuantizedVertexPNUC v {};
+            glm::vec3 p = (lv.pos - q.posOffset) / q.posScale;
+            v.pos[0] = (int16_t)glm::packSnorm1x16(p.x);
+            v.pos[1] = (int16_t)glm::packSnorm1x16(p.y);
+            v.pos[2] = (int16_t)glm::packSnorm1x16(p.z);
+            v.pos[3] = (int16_t)glm::packSnorm1x16(1.0f);
+            packOctahedralSnorm16(lv.normal, v.normal);
+            packHalf2(lv.uv, v.uv);
+            v.color = glm::packUnorm4x8(lv.color);
+            return v;
+        };
+
+        static LoaderVertex unpack(const QuantizedVertexPNUC &v, const VertexQuantization &q) {
+            LoaderVertex lv {};
+            glm::vec3 p(glm::unpackSnorm1x16((uint16_t)v.pos[0]),
+                        glm::unpackSnorm1x16((uint16_t)v.pos[1]),
+                        glm::unpackSnorm1x16((uint16_t)v.pos[2]));
+            lv.pos = q.posOffset + q.posScale * p;
+            lv.normal = unpackOctahedralSnorm16(v.normal);
+            lv.uv = unpackHalf2(v.uv);
+            lv.color = glm::unpackUnorm4x8(v.color);
+            return lv;
+        };
+
+        static vector<vk::VertexInputAttributeDescription> getAttribDesc(uint32_t binding = 0) {
+            return {
+                createAttribDesc(0, binding, vk::Format::eR16G16B16A16Snorm, offsetof(QuantizedVertexPNUC, pos)),
+                createAttribDesc(1, binding, vk::Format::eR16G16Snorm, offsetof(QuantizedVertexPNUC, normal)),
+                createAttribDesc(2, binding, vk::Format::eR16G16Sfloat, offsetof(QuantizedVertexPNUC, uv)),
+                createAttribDesc(3, binding, vk::Format::eR8G8B8A8Unorm, offsetof(QuantizedVertexPNUC, color))
+            };
+        };
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // FUNCTIONS
+    ///////////////////////////////////////////////////////////////////////////
+
+    template<typename T>
+    vk::VertexInputBindingDescription getVertexBindDesc(uint32_t binding = 0) {
+        return vk::VertexInputBindingDescription(binding, sizeof(T), vk::VertexInputRate::eVertex);
+    };
+
+    // Format of one plain glm attribute member (integer types stay integers in the shader, e.g., uvec2 -> R32G32Uint).
+    // Anything else does not compile; give the vertex type its own getAttribDesc() instead.
+    template<typename M>
+    constexpr vk::Format getVertexAttribFormat() {
+        if constexpr (is_same_v<M, float>)              return vk::Format::eR32Sfloat;
+        else if constexpr (is_same_v<M, glm::vec2>)     return vk::Format::eR32G32Sfloat;
+        else if constexpr (is_same_v<M, glm::vec3>)     return vk::Format::eR32G32B32Sfloat;
+        else if constexpr (is_same_v<M, glm::vec4>)     return vk::Format::eR32G32B32A32Sfloat;
+        else if constexpr (is_same_v<M, int32_t>)       return vk::Format::eR32Sint;
+        else if constexpr (is_same_v<M, glm::ivec2>)    return vk::Format::eR32G32Sint;
+        else if constexpr (is_same_v<M, glm::ivec3>)    return vk::Format::eR32G32B32Sint;
+        else if constexpr (is_same_v<M, glm::ivec4>)    return vk::Format::eR32G32B32A32Sint;
+        else if constexpr (is_same_v<M, uint32_t>)      return vk::Format::eR32Uint;
+        else if constexpr (is_same_v<M, glm::uvec2>)    return vk::Format::eR32G32Uint;
+        else if constexpr (is_same_v<M, glm::uvec3>)    return vk::Format::eR32G32B32Uint;
+        else if constexpr (is_same_v<M, glm::uvec4>)    return vk::Format::eR32G32B32A32Uint;
+        else if constexpr (is_same_v<M, glm::i16vec2>)  return vk::Format::eR16G16Sint;
+        else if constexpr (is_same_v<M, glm::i16vec4>)  return vk::Format::eR16G16B16A16Sint;
+        else if constexpr (is_same_v<M, glm::u16vec2>)  return vk::Format::eR16G16Uint;
+        else if constexpr (is_same_v<M, glm::u16vec4>)  return vk::Format::eR16G16B16A16Uint;
+        else if constexpr (is_same_v<M, glm::i8vec4>)   return vk::Format::eR8G8B8A8Sint;
+        else if constexpr (is_same_v<M, glm::u8vec4>)   return vk::Format::eR8G8B8A8Uint;
+        else {
+            static_assert(sizeof(M) == 0, "getVertexAttribFormat(): no vk::Format for this attribute type "
+                                          "(give the vertex type a static getAttribDesc())");
+            return vk::Format::eUndefined;
+        }
+    };
+
+    // Attribute descriptions for T (ready for VulkanPipelineCreateInfo::attribDesc).
+    // Packed formats supply their own; plain glm vertices get one per member (see getVertexAttribFormat())
+    // with locations in VertexTraits<T>::getLayout() order: pos, normal, uv, color.
+    template<typename T>
+    vector<vk::VertexInputAttributeDescription> getVertexAttribDesc(uint32_t binding = 0) {
+        if constexpr (requires { T::getAttribDesc(binding); }) {
+            return T::getAttribDesc(binding);
+        }
+        else {
+            T v {};
+            vector<vk::VertexInputAttributeDescription> attribDesc {};
+            uint32_t location = 0;
+            auto add = [&](const auto &member) {
+                uint32_t offset = (uint32_t)(reinterpret_cast<const char*>(&member) - reinterpret_cast<const char*>(&v));
+                vk::Format format = getVertexAttribFormat<remove_cvref_t<decltype(member)>>();
+                attribDesc.push_back(createAttribDesc(location++, binding, format, offset));
+            };
+
+            if constexpr (requires { v.pos = glm::vec3(); })    add(v.pos);
+            if constexpr (VertexTraits<T>::hasNormal)           add(v.normal);
+            if constexpr (VertexTraits<T>::hasUV)               add(v.uv);
+            if constexpr (VertexTraits<T>::hasColor)            add(v.color);
+            return attribDesc;
+        }
+    };
+
+    // Fits snorm16 positions to the mesh bounds
+    template<typename T>
+    VertexQuantization computeVertexQuantization(const HostMesh<T> &hostMesh) {
+        MeshBounds bounds = computeMeshBounds(hostMesh);
+        VertexQuantization q {};
+        q.posOffset = (bounds.minPos + bounds.maxPos) * 0.5f;
+        q.posScale = glm::max((bounds.maxPos - bounds.minPos) * 0.5f, glm::vec3(1e-8f));
+        return q;
+    };
+
+    // Quantization pass: converts hostMesh to packed format P and
+    // (optionally) measures the error that introduced.
+    // The result carries the bounds of its DECODED positions (what the GPU sees; see HostMesh::bounds).
+    template<typename P, typename T>
+    HostMesh<P> packHostMesh(   const HostMesh<T> &hostMesh,
+                                VertexQuantization &quant,
+                                VertexQuantizationReport *report = nullptr) {
+        quant = P::needsQuantization ? computeVertexQuantization(hostMesh) : VertexQuantization {};
+
+        HostMesh<P> packed {};
+        packed.vertices.resize(hostMesh.vertices.size());
+        packed.indices = hostMesh.indices;
+
+        VertexQuantizationReport r {};
+        r.bytesBefore = hostMesh.vertices.size() * sizeof(T);
+        r.bytesAfter = packed.vertices.size() * sizeof(P);
+        vector<glm::vec3> allDecodedPositions(hostMesh.vertices.size());
+
+        for(size_t i = 0; i < hostMesh.vertices.size(); i++) {
+            LoaderVertex orig = VertexTraits<T>::toLoaderVertex(hostMesh.vertices[i]);
+            packed.vertices[i] = P::pack(orig, quant);
+            LoaderVertex back = P::unpack(packed.vertices[i], quant);
+            allDecodedPositions[i] = back.pos;
+
+            if(report) {
+                r.maxPosError = max(r.maxPosError, glm::length(back.pos - orig.pos));
+
+                if constexpr (P::hasNormal && VertexTraits<T>::hasNormal) {
+                    float len = glm::length(orig.normal);
+                    if(len > 0.0f) {
+                        float cosAngle = glm::clamp(glm::dot(orig.normal / len, back.normal), -1.0f, 1.0f);
+                        r.maxNormalErrorDegrees = max(r.maxNormalErrorDegrees, glm::degrees(glm::acos(cosAngle)));
+                    }
+                }
+                if constexpr (P::hasUV && VertexTraits<T>::hasUV) {
+                    r.maxUVError = max(r.maxUVError, glm::length(back.uv - orig.uv));
+                }
+                if constexpr (P::hasColor && VertexTraits<T>::hasColor) {
+                    glm::vec4 d = glm::abs(back.color - glm::clamp(orig.color, 0.0f, 1.0f));
+                    r.maxColorError = max(r.maxColorError, max(max(d.r, d.g), max(d.b, d.a)));
+                }
+            }
+        }
+
+        packed.bounds = computeMeshBounds(allDecodedPositions.data(), allDecodedPositions.size());
+        packed.hasBounds = true;
+
+        if(report) {
+            *report = r;
+        }
+        return packed;
+    };
+
+    inline void printVertexQuantizationReport(const VertexQuantizationReport &report) {
+        cout << "Vertex bytes: " << report.bytesBefore << " -> " << report.bytesAfter << endl;
+        cout << "Max position error: " << report.maxPosError << endl;
+        cout << "Max normal error: " << report.maxNormalErrorDegrees << " degrees" << endl;
+        cout << "Max UV error: " << report.maxUVError << endl;
+        cout << "Max color error: " << report.maxColorError << endl;
+    };
+}
@@ -6,4 +6,21 @@
 #include "ProCommand.hpp"
 #include "ProPipeline.hpp"
 #include "ProBuffer.hpp"
+#include "ProTexture.hpp"
 #include "ProMesh.hpp"
+#include "ProFile.hpp"
+#include "ProObj.hpp"
+#include "ProModel.hpp"
+#include "ProMeshCache.hpp"
+#include "ProMeshOpt.hpp"
+#include "ProVertexPack.hpp"
+#include "ProBC.hpp"
+#include "ProTextureCache.hpp"
+#include "ProStream.hpp"
+#include "ProProfile.hpp"
+#include "ProJobs.hpp"
+#include "ProCompute.hpp"
+#include "ProCull.hpp"
+#include "ProIndirect.hpp"
+#include "ProHotReload.hpp"
+#include "ProPipelineCompiler.hpp"